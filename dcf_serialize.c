@@ -25,6 +25,17 @@
     #include <arpa/inet.h>
 #endif
 
+#ifdef DCF_SER_PLATFORM_POSIX
+    #include <errno.h>
+    #include <unistd.h>
+    #include <pthread.h>
+#endif
+
+#if defined(__SSE2__) && defined(__GNUC__)
+    #include <emmintrin.h>
+    #define DCF_SER_HAVE_SSE2 1
+#endif
+
 /* ============================================================================
  * Internal Macros
  * ============================================================================ */
@@ -40,6 +51,9 @@
     if ((r)->position + (n) > (r)->payload_end) { \
         return DCF_SER_ERR_TRUNCATED; \
     } \
+    if ((r)->position + (n) > (r)->length) { \
+        return reader_need_more(r); \
+    } \
 } while(0)
 
 /* ============================================================================
@@ -181,27 +195,186 @@ uint32_t dcf_ser_crc32_update(uint32_t crc, const void* data, size_t len) {
     return crc;
 }
 
+/* ============================================================================
+ * Wire Header Encoding
+ * ============================================================================ */
+
+#define COMPACT_HEADER_MAX  14  /* sync + len(5) + msg_type(3) + seq delta(5) */
+#define EXTENDED_HEADER_SIZE (DCF_SER_HEADER_SIZE + 8 + 4)  /* + u64 length + header CRC */
+
+static size_t varint_encode(uint8_t* out, uint64_t val) {
+    size_t n = 0;
+    do {
+        uint8_t byte = val & 0x7F;
+        val >>= 7;
+        if (val != 0) byte |= 0x80;
+        out[n++] = byte;
+    } while (val != 0);
+    return n;
+}
+
+static DCFSerError varint_decode(const uint8_t* p, size_t avail, uint64_t* out, size_t* used) {
+    uint64_t result = 0;
+    uint8_t shift = 0;
+    size_t n = 0;
+    uint8_t b;
+    
+    do {
+        if (shift >= 64) return DCF_SER_ERR_OVERFLOW;
+        if (n >= avail) return DCF_SER_ERR_TRUNCATED;
+        b = p[n++];
+        result |= (uint64_t)(b & 0x7F) << shift;
+        shift += 7;
+    } while (b & 0x80);
+    
+    *out = result;
+    *used = n;
+    return DCF_SER_OK;
+}
+
+static bool header_is_compact(const uint8_t* p) {
+    return (p[0] & DCF_SER_COMPACT_MASK) == DCF_SER_COMPACT_SYNC;
+}
+
+/* Encode a full (or, with DCF_SER_FLAG_EXTENDED, extended) header; returns its size */
+static size_t header_build(uint8_t* out, uint16_t msg_type, uint8_t flags,
+                           uint32_t sequence, uint64_t payload_len) {
+    bool extended = (flags & DCF_SER_FLAG_EXTENDED) != 0;
+    DCFSerHeader header;
+    header.magic = dcf_ser_hton32(DCF_SER_MAGIC);
+    header.version = dcf_ser_hton16(DCF_SER_VERSION);
+    header.msg_type = dcf_ser_hton16(msg_type);
+    header.flags = flags;
+    header.payload_len = dcf_ser_hton32(extended ? UINT32_MAX : (uint32_t)payload_len);
+    header.sequence = dcf_ser_hton32(sequence);
+    memcpy(out, &header, sizeof(DCFSerHeader));
+    size_t n = sizeof(DCFSerHeader);
+    
+    if (extended) {
+        /* 64-bit length, then a CRC over the header alone */
+        uint64_t len_net = dcf_ser_hton64(payload_len);
+        memcpy(out + n, &len_net, 8);
+        n += 8;
+        uint32_t hcrc_net = dcf_ser_hton32(dcf_ser_crc32(out, n));
+        memcpy(out + n, &hcrc_net, 4);
+        n += 4;
+    }
+    return n;
+}
+
+/* Bytes reserved ahead of the payload for the (largest) header */
+static size_t writer_header_reserve(uint8_t flags) {
+    return (flags & DCF_SER_FLAG_EXTENDED) ? EXTENDED_HEADER_SIZE : sizeof(DCFSerHeader);
+}
+
+/*
+ * Parse a full, extended or compact header; the result is in host order.
+ * The payload length is returned separately since it may exceed 32 bits
+ * (hdr->payload_len is UINT32_MAX for extended headers).
+ */
+static DCFSerError header_parse(const uint8_t* p, size_t avail, uint32_t seq_base,
+                                DCFSerHeader* hdr, size_t* out_hdr_len,
+                                uint64_t* out_payload_len) {
+    if (avail < 1) return DCF_SER_ERR_TRUNCATED;
+    
+    if (header_is_compact(p)) {
+        uint8_t sync = p[0];
+        uint64_t len = 0, msg_type = 0, delta = 0;
+        size_t n = 1, used;
+        
+        DCF_SER_CHECK(varint_decode(p + n, avail - n, &len, &used));
+        n += used;
+        DCF_SER_CHECK(varint_decode(p + n, avail - n, &msg_type, &used));
+        n += used;
+        if (sync & DCF_SER_COMPACT_SEQ) {
+            DCF_SER_CHECK(varint_decode(p + n, avail - n, &delta, &used));
+            n += used;
+        }
+        if (len > UINT32_MAX || msg_type > UINT16_MAX || delta > UINT32_MAX) {
+            return DCF_SER_ERR_MALFORMED;
+        }
+        
+        hdr->magic = DCF_SER_MAGIC;
+        hdr->version = DCF_SER_VERSION;
+        hdr->msg_type = (uint16_t)msg_type;
+        hdr->flags = DCF_SER_FLAG_COMPACT;
+        if (sync & DCF_SER_COMPACT_NO_CRC) hdr->flags |= DCF_SER_FLAG_NO_CRC;
+        if (sync & DCF_SER_COMPACT_PRIORITY) hdr->flags |= DCF_SER_FLAG_PRIORITY;
+        hdr->payload_len = (uint32_t)len;
+        hdr->sequence = seq_base + (uint32_t)delta;
+        *out_hdr_len = n;
+        *out_payload_len = len;
+        return DCF_SER_OK;
+    }
+    
+    if (avail < sizeof(DCFSerHeader)) return DCF_SER_ERR_TRUNCATED;
+    
+    const DCFSerHeader* wire_hdr = (const DCFSerHeader*)p;
+    hdr->magic = dcf_ser_ntoh32(wire_hdr->magic);
+    hdr->version = dcf_ser_ntoh16(wire_hdr->version);
+    hdr->msg_type = dcf_ser_ntoh16(wire_hdr->msg_type);
+    hdr->flags = wire_hdr->flags;
+    hdr->payload_len = dcf_ser_ntoh32(wire_hdr->payload_len);
+    hdr->sequence = dcf_ser_ntoh32(wire_hdr->sequence);
+    
+    if (hdr->magic != DCF_SER_MAGIC) return DCF_SER_ERR_INVALID_MAGIC;
+    
+    if (hdr->flags & DCF_SER_FLAG_EXTENDED) {
+        if (avail < EXTENDED_HEADER_SIZE) return DCF_SER_ERR_TRUNCATED;
+        
+        uint64_t len_net;
+        uint32_t hcrc_net;
+        memcpy(&len_net, p + sizeof(DCFSerHeader), 8);
+        memcpy(&hcrc_net, p + sizeof(DCFSerHeader) + 8, 4);
+        if (dcf_ser_ntoh32(hcrc_net) != dcf_ser_crc32(p, sizeof(DCFSerHeader) + 8)) {
+            return DCF_SER_ERR_CRC_MISMATCH;
+        }
+        
+        *out_hdr_len = EXTENDED_HEADER_SIZE;
+        *out_payload_len = dcf_ser_ntoh64(len_net);
+        return DCF_SER_OK;
+    }
+    
+    *out_hdr_len = sizeof(DCFSerHeader);
+    *out_payload_len = hdr->payload_len;
+    return DCF_SER_OK;
+}
+
 /* ============================================================================
  * Writer Internal Functions
  * ============================================================================ */
 
-static DCFSerError writer_grow(DCFSerWriter* w, size_t needed) {
+static DCFSerError writer_realloc(DCFSerWriter* w, size_t needed) {
     if (!w->owns_buffer) {
         w->last_error = DCF_SER_ERR_BUFFER_FULL;
         return DCF_SER_ERR_BUFFER_FULL;
     }
     
-    size_t new_cap = w->capacity * 2;
-    while (new_cap < w->position + needed) {
-        new_cap *= 2;
+    /* Largest buffer a message within the limits can need */
+    size_t max_cap = w->payload_start + 4 + w->tailroom;
+    max_cap = (w->limits.max_message > SIZE_MAX - max_cap)
+            ? SIZE_MAX : max_cap + (size_t)w->limits.max_message;
+    
+    if (needed > max_cap || w->position > max_cap - needed) {
+        w->last_error = DCF_SER_ERR_TOO_LARGE;
+        return DCF_SER_ERR_TOO_LARGE;
     }
     
-    if (new_cap > DCF_SER_MAX_MESSAGE) {
+    /* Chunks already sent count toward the message limit */
+    if (w->flushed > 0 &&
+        w->flushed + (w->position + needed - w->payload_start) > w->limits.max_message) {
         w->last_error = DCF_SER_ERR_TOO_LARGE;
         return DCF_SER_ERR_TOO_LARGE;
     }
     
-    uint8_t* new_buf = (uint8_t*)realloc(w->buffer, new_cap);
+    size_t new_cap = w->capacity;
+    while (new_cap < w->position + needed) {
+        new_cap = (new_cap > max_cap / 2) ? max_cap : new_cap * 2;
+    }
+    
+    /* Sink writers keep the CRC slot and tailroom hidden past capacity */
+    size_t slack = w->sink ? 4 + w->tailroom : 0;
+    uint8_t* new_buf = (uint8_t*)realloc(w->buffer, new_cap + slack);
     if (!new_buf) {
         w->last_error = DCF_SER_ERR_ALLOC_FAIL;
         return DCF_SER_ERR_ALLOC_FAIL;
@@ -212,6 +385,40 @@ static DCFSerError writer_grow(DCFSerWriter* w, size_t needed) {
     return DCF_SER_OK;
 }
 
+static DCFSerError writer_flush_chunk(DCFSerWriter* w, bool final);
+
+static DCFSerError writer_grow(DCFSerWriter* w, size_t needed) {
+    /* Sink writers send the buffered payload instead of growing */
+    if (w->sink && !w->batch_open && w->held_depth == 0 && w->position > w->payload_start) {
+        DCF_SER_CHECK(writer_flush_chunk(w, false));
+        if (w->position + needed <= w->capacity) return DCF_SER_OK;
+    }
+    return writer_realloc(w, needed);
+}
+
+/* Copy bulk data, flushing chunks in between so sink writers stay bounded */
+static DCFSerError writer_put_bytes(DCFSerWriter* w, const void* data, size_t len) {
+    const uint8_t* src = (const uint8_t*)data;
+    
+    if (w->sink && !w->batch_open && w->held_depth == 0) {
+        while (len > 0) {
+            if (w->position == w->capacity) DCF_SER_CHECK(writer_grow(w, 1));
+            size_t n = w->capacity - w->position;
+            if (n > len) n = len;
+            memcpy(w->buffer + w->position, src, n);
+            w->position += n;
+            src += n;
+            len -= n;
+        }
+        return DCF_SER_OK;
+    }
+    
+    WRITER_ENSURE_SPACE(w, len);
+    memcpy(w->buffer + w->position, src, len);
+    w->position += len;
+    return DCF_SER_OK;
+}
+
 static DCFSerError writer_put_u8(DCFSerWriter* w, uint8_t val) {
     WRITER_ENSURE_SPACE(w, 1);
     w->buffer[w->position++] = val;
@@ -242,105 +449,402 @@ static DCFSerError writer_put_u64(DCFSerWriter* w, uint64_t val) {
     return DCF_SER_OK;
 }
 
+static DCFSerError writer_put_varint(DCFSerWriter* w, uint64_t val) {
+    WRITER_ENSURE_SPACE(w, 10);
+    w->position += varint_encode(w->buffer + w->position, val);
+    return DCF_SER_OK;
+}
+
+/* ============================================================================
+ * Limits
+ * ============================================================================ */
+
+void dcf_ser_limits_default(DCFSerLimits* limits) {
+    if (!limits) return;
+    limits->max_message = DCF_SER_MAX_MESSAGE;
+    limits->max_string = DCF_SER_MAX_STRING;
+    limits->max_array = DCF_SER_MAX_ARRAY;
+    limits->max_depth = DCF_SER_MAX_DEPTH;
+}
+
+static DCFSerError limits_check(const DCFSerLimits* limits) {
+    if (limits->max_depth > DCF_SER_MAX_DEPTH) return DCF_SER_ERR_INVALID_ARG;
+    if (limits->max_message > SIZE_MAX) return DCF_SER_ERR_INVALID_ARG;
+    return DCF_SER_OK;
+}
+
 /* ============================================================================
  * Writer API Implementation
  * ============================================================================ */
 
 DCFSerError dcf_ser_writer_init(DCFSerWriter* writer, uint16_t msg_type, uint8_t flags) {
-    if (!writer) return DCF_SER_ERR_NULL_PTR;
-    
-    memset(writer, 0, sizeof(DCFSerWriter));
-    
-    writer->buffer = (uint8_t*)malloc(DCF_SER_INITIAL_CAP);
-    if (!writer->buffer) return DCF_SER_ERR_ALLOC_FAIL;
-    
-    writer->capacity = DCF_SER_INITIAL_CAP;
-    writer->owns_buffer = true;
-    writer->msg_type = msg_type;
-    writer->flags = flags;
-    
-    /* Reserve space for header */
-    writer->position = sizeof(DCFSerHeader);
-    
-    return DCF_SER_OK;
+    return dcf_ser_writer_init_ex(writer, msg_type, flags, NULL);
 }
 
 DCFSerError dcf_ser_writer_init_buffer(DCFSerWriter* writer, uint8_t* buffer,
                                         size_t capacity, uint16_t msg_type, uint8_t flags) {
-    if (!writer || !buffer) return DCF_SER_ERR_NULL_PTR;
-    if (capacity < sizeof(DCFSerHeader) + 4) return DCF_SER_ERR_BUFFER_FULL;
+    if (!buffer) return DCF_SER_ERR_NULL_PTR;
+    
+    DCFSerWriterOptions opts = {0};
+    opts.buffer = buffer;
+    opts.capacity = capacity;
+    return dcf_ser_writer_init_ex(writer, msg_type, flags, &opts);
+}
+
+DCFSerError dcf_ser_writer_init_ex(DCFSerWriter* writer, uint16_t msg_type, uint8_t flags,
+                                   const DCFSerWriterOptions* opts) {
+    if (!writer) return DCF_SER_ERR_NULL_PTR;
+    
+    DCFSerWriterOptions defaults = {0};
+    if (!opts) opts = &defaults;
+    if (opts->limits) DCF_SER_CHECK(limits_check(opts->limits));
+    
+    size_t payload_start = opts->headroom + writer_header_reserve(flags);
+    size_t min_cap = payload_start + 4 + opts->tailroom;
+    if (min_cap < payload_start) return DCF_SER_ERR_TOO_LARGE;
+    
+    /* Sink writers hold one chunk; the CRC slot comes on top */
+    size_t sink_cap = 0;
+    if (opts->sink) {
+        size_t chunk = opts->chunk_size ? opts->chunk_size : DCF_SER_STREAM_CHUNK;
+        if (chunk > SIZE_MAX - min_cap) return DCF_SER_ERR_TOO_LARGE;
+        sink_cap = min_cap + chunk;
+    }
     
     memset(writer, 0, sizeof(DCFSerWriter));
     
-    writer->buffer = buffer;
-    writer->capacity = capacity;
-    writer->owns_buffer = false;
+    if (opts->buffer) {
+        if (opts->capacity < min_cap) return DCF_SER_ERR_BUFFER_FULL;
+        writer->buffer = opts->buffer;
+        writer->capacity = opts->capacity;
+        writer->owns_buffer = false;
+    } else {
+        size_t cap = opts->capacity ? opts->capacity : DCF_SER_INITIAL_CAP;
+        if (sink_cap) cap = sink_cap;
+        if (cap < min_cap) cap = min_cap;
+        
+        writer->buffer = (uint8_t*)malloc(cap);
+        if (!writer->buffer) return DCF_SER_ERR_ALLOC_FAIL;
+        writer->capacity = cap;
+        writer->owns_buffer = true;
+    }
+    
     writer->msg_type = msg_type;
     writer->flags = flags;
-    writer->position = sizeof(DCFSerHeader);
+    writer->headroom = opts->headroom;
+    writer->tailroom = opts->tailroom;
+    writer->sink = opts->sink;
+    writer->sink_ctx = opts->sink_ctx;
+    if (opts->sink) {
+        /* Chunks are sealed in place: keep room for the CRC behind them */
+        writer->capacity -= 4 + opts->tailroom;
+    }
+    if (opts->limits) {
+        writer->limits = *opts->limits;
+    } else {
+        dcf_ser_limits_default(&writer->limits);
+    }
+    
+    /* Reserve space for headroom and header */
+    writer->payload_start = payload_start;
+    writer->position = payload_start;
     
     return DCF_SER_OK;
 }
 
 void dcf_ser_writer_destroy(DCFSerWriter* writer) {
-    if (writer && writer->owns_buffer && writer->buffer) {
+    if (!writer) return;
+    if (writer->owns_buffer && writer->buffer) {
         free(writer->buffer);
         writer->buffer = NULL;
     }
+    free(writer->segments);
+    writer->segments = NULL;
+    free(writer->held);
+    writer->held = NULL;
+    writer->held_depth = 0;
+    writer->segment_count = 0;
+    writer->segment_cap = 0;
+    writer->ref_bytes = 0;
 }
 
 void dcf_ser_writer_reset(DCFSerWriter* writer, uint16_t msg_type, uint8_t flags) {
     if (!writer) return;
     
-    writer->position = sizeof(DCFSerHeader);
+    /* Keep the headroom fixed; the header reserve depends on the flags */
+    writer->payload_start = writer->headroom + writer_header_reserve(flags);
+    writer->position = writer->payload_start;
     writer->depth = 0;
     writer->msg_type = msg_type;
     writer->flags = flags;
     writer->sequence = 0;
     writer->header_written = false;
     writer->last_error = DCF_SER_OK;
+    writer->segment_count = 0;
+    writer->ref_bytes = 0;
+    writer->msg_start = 0;
+    writer->msg_end = 0;
+    writer->batch_open = false;
+    writer->held_depth = 0;
+    writer->flushed = 0;
+    writer->sent = 0;
+}
+
+static bool writer_use_compact(const DCFSerWriter* writer) {
+    const uint8_t compact_ok = DCF_SER_FLAG_COMPACT | DCF_SER_FLAG_NO_CRC | DCF_SER_FLAG_PRIORITY;
+    return (writer->flags & DCF_SER_FLAG_COMPACT) && !(writer->flags & ~compact_ok);
+}
+
+/* Write the header so that it ends exactly at payload_start */
+static void writer_put_header(DCFSerWriter* writer, size_t payload_len) {
+    uint8_t hdr[EXTENDED_HEADER_SIZE];
+    size_t n;
+    
+    if (writer_use_compact(writer)) {
+        uint32_t delta = writer->sequence - writer->seq_base;
+        uint8_t sync = DCF_SER_COMPACT_SYNC;
+        if (delta != 0) sync |= DCF_SER_COMPACT_SEQ;
+        if (writer->flags & DCF_SER_FLAG_NO_CRC) sync |= DCF_SER_COMPACT_NO_CRC;
+        if (writer->flags & DCF_SER_FLAG_PRIORITY) sync |= DCF_SER_COMPACT_PRIORITY;
+        
+        hdr[0] = sync;
+        n = 1;
+        n += varint_encode(hdr + n, payload_len);
+        n += varint_encode(hdr + n, writer->msg_type);
+        if (delta != 0) n += varint_encode(hdr + n, delta);
+    } else {
+        n = header_build(hdr, writer->msg_type, writer->flags & (uint8_t)~DCF_SER_FLAG_COMPACT,
+                         writer->sequence, payload_len);
+    }
+    
+    writer->msg_start = writer->payload_start - n;
+    memcpy(writer->buffer + writer->msg_start, hdr, n);
+}
+
+/* Copy external segments into the buffer, back to front, so it is contiguous */
+static DCFSerError writer_linearize(DCFSerWriter* writer) {
+    if (writer->segment_count == 0) return DCF_SER_OK;
+    
+    WRITER_ENSURE_SPACE(writer, writer->ref_bytes);
+    
+    size_t src_end = writer->position;
+    size_t dst_end = writer->position + writer->ref_bytes;
+    for (size_t i = writer->segment_count; i-- > 0; ) {
+        const DCFSerSegment* seg = &writer->segments[i];
+        size_t chunk = src_end - seg->offset;
+        memmove(writer->buffer + dst_end - chunk, writer->buffer + seg->offset, chunk);
+        dst_end -= chunk;
+        memcpy(writer->buffer + dst_end - seg->len, seg->data, seg->len);
+        dst_end -= seg->len;
+        src_end = seg->offset;
+    }
+    
+    writer->position += writer->ref_bytes;
+    writer->segment_count = 0;
+    writer->ref_bytes = 0;
+    return DCF_SER_OK;
+}
+
+/* Seal the buffered payload as one chunk and hand it to the sink */
+static DCFSerError writer_flush_chunk(DCFSerWriter* w, bool final) {
+    size_t payload_len = w->position - w->payload_start;
+    uint8_t flags = w->flags;
+    
+    if (payload_len > w->limits.max_message - w->flushed) {
+        w->last_error = DCF_SER_ERR_TOO_LARGE;
+        return DCF_SER_ERR_TOO_LARGE;
+    }
+    
+    /* A message that never spilled is sent as a plain message */
+    if (!final || w->flushed > 0) {
+        w->flags |= DCF_SER_FLAG_STREAMING | (final ? DCF_SER_FLAG_FINAL : 0);
+    }
+    writer_put_header(w, payload_len);
+    w->flags = flags;
+    
+    /* The CRC slot past capacity is reserved for this */
+    size_t end = w->position;
+    if (!(w->flags & DCF_SER_FLAG_NO_CRC)) {
+        uint32_t crc = dcf_ser_crc32(w->buffer + w->msg_start, end - w->msg_start);
+        uint32_t crc_net = dcf_ser_hton32(crc);
+        memcpy(w->buffer + end, &crc_net, 4);
+        end += 4;
+    }
+    
+    DCFSerError err = w->sink(w->sink_ctx, w->buffer + w->msg_start, end - w->msg_start);
+    if (err != DCF_SER_OK) {
+        w->last_error = err;
+        return err;
+    }
+    
+    w->flushed += payload_len;
+    w->sent += end - w->msg_start;
+    w->position = w->payload_start;
+    return DCF_SER_OK;
+}
+
+DCFSerError dcf_ser_writer_flush(DCFSerWriter* writer) {
+    if (!writer) return DCF_SER_ERR_NULL_PTR;
+    if (!writer->sink) return DCF_SER_ERR_INVALID_ARG;
+    /* Held containers are patched in place until they end */
+    if (writer->batch_open || writer->held_depth > 0) return DCF_SER_ERR_MALFORMED;
+    if (writer->position == writer->payload_start) return DCF_SER_OK;
+    return writer_flush_chunk(writer, false);
 }
 
+#ifdef DCF_SER_PLATFORM_POSIX
+DCFSerError dcf_ser_fd_sink(void* ctx, const void* data, size_t len) {
+    if (!ctx || (!data && len > 0)) return DCF_SER_ERR_NULL_PTR;
+    
+    int fd = *(const int*)ctx;
+    const uint8_t* p = (const uint8_t*)data;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return DCF_SER_ERR_IO;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return DCF_SER_OK;
+}
+#endif
+
 DCFSerError dcf_ser_writer_finish(DCFSerWriter* writer, const uint8_t** out_data, size_t* out_len) {
     if (!writer || !out_data || !out_len) return DCF_SER_ERR_NULL_PTR;
+    if (writer->batch_open) return DCF_SER_ERR_MALFORMED;
     
-    size_t payload_len = writer->position - sizeof(DCFSerHeader);
+    if (writer->sink) {
+        DCF_SER_CHECK(writer_flush_chunk(writer, true));
+        writer->header_written = true;
+        *out_data = NULL;
+        *out_len = writer->sent;
+        return DCF_SER_OK;
+    }
     
-    /* Write header at beginning */
-    DCFSerHeader header;
-    header.magic = dcf_ser_hton32(DCF_SER_MAGIC);
-    header.version = dcf_ser_hton16(DCF_SER_VERSION);
-    header.msg_type = dcf_ser_hton16(writer->msg_type);
-    header.flags = writer->flags;
-    header.payload_len = dcf_ser_hton32((uint32_t)payload_len);
-    header.sequence = dcf_ser_hton32(writer->sequence);
+    DCF_SER_CHECK(writer_linearize(writer));
+    
+    /* Reserve CRC and tailroom up front: growing may move the buffer */
+    WRITER_ENSURE_SPACE(writer, 4 + writer->tailroom);
+    
+    size_t payload_len = writer->position - writer->payload_start;
+    if (payload_len > UINT32_MAX && !(writer->flags & DCF_SER_FLAG_EXTENDED)) {
+        return DCF_SER_ERR_TOO_LARGE;
+    }
     
-    memcpy(writer->buffer, &header, sizeof(DCFSerHeader));
+    /* Write header immediately before the payload */
+    writer_put_header(writer, payload_len);
     
     /* Calculate and write CRC (unless disabled) */
     if (!(writer->flags & DCF_SER_FLAG_NO_CRC)) {
-        WRITER_ENSURE_SPACE(writer, 4);
-        uint32_t crc = dcf_ser_crc32(writer->buffer, writer->position);
+        uint32_t crc = dcf_ser_crc32(writer->buffer + writer->msg_start,
+                                     writer->position - writer->msg_start);
         uint32_t crc_net = dcf_ser_hton32(crc);
         memcpy(writer->buffer + writer->position, &crc_net, 4);
         writer->position += 4;
     }
     
     writer->header_written = true;
-    *out_data = writer->buffer;
-    *out_len = writer->position;
+    writer->msg_end = writer->position;
+    *out_data = writer->buffer + writer->msg_start;
+    *out_len = writer->position - writer->msg_start;
+    
+    return DCF_SER_OK;
+}
+
+DCFSerError dcf_ser_writer_headroom(DCFSerWriter* writer, uint8_t** out_ptr, size_t* out_len) {
+    if (!writer || !out_ptr || !out_len) return DCF_SER_ERR_NULL_PTR;
+    if (!writer->header_written) return DCF_SER_ERR_INVALID_ARG;
+    
+    *out_ptr = writer->buffer;
+    *out_len = writer->msg_start;
+    return DCF_SER_OK;
+}
+
+DCFSerError dcf_ser_writer_tailroom(DCFSerWriter* writer, uint8_t** out_ptr, size_t* out_len) {
+    if (!writer || !out_ptr || !out_len) return DCF_SER_ERR_NULL_PTR;
+    if (!writer->header_written) return DCF_SER_ERR_INVALID_ARG;
+    
+    *out_ptr = writer->buffer + writer->msg_end;
+    *out_len = writer->capacity - writer->msg_end;
+    return DCF_SER_OK;
+}
+
+size_t dcf_ser_writer_iov_count(const DCFSerWriter* writer) {
+    return writer ? (writer->segment_count * 2 + 1) : 0;
+}
+
+DCFSerError dcf_ser_writer_finish_iov(DCFSerWriter* writer, DCFSerIoVec* iov,
+                                      size_t max_iov, size_t* out_count) {
+    if (!writer || !iov || !out_count) return DCF_SER_ERR_NULL_PTR;
+    if (writer->sink) return DCF_SER_ERR_INVALID_ARG;
+    if (writer->batch_open) return DCF_SER_ERR_MALFORMED;
+    if (max_iov < dcf_ser_writer_iov_count(writer)) return DCF_SER_ERR_BUFFER_FULL;
+    
+    /* Reserve CRC and tailroom first: growing may move the buffer */
+    WRITER_ENSURE_SPACE(writer, 4 + writer->tailroom);
+    
+    size_t payload_len = writer->position - writer->payload_start + writer->ref_bytes;
+    if (payload_len > UINT32_MAX && !(writer->flags & DCF_SER_FLAG_EXTENDED)) {
+        return DCF_SER_ERR_TOO_LARGE;
+    }
+    writer_put_header(writer, payload_len);
+    
+    /* Interleave inline chunks with external segments, CRC as we go */
+    uint32_t crc = 0xFFFFFFFF;
+    size_t count = 0;
+    size_t chunk_start = writer->msg_start;
+    for (size_t i = 0; i < writer->segment_count; i++) {
+        const DCFSerSegment* seg = &writer->segments[i];
+        size_t chunk = seg->offset - chunk_start;
+        crc = dcf_ser_crc32_update(crc, writer->buffer + chunk_start, chunk);
+        crc = dcf_ser_crc32_update(crc, seg->data, seg->len);
+        if (chunk > 0) {
+            iov[count].iov_base = writer->buffer + chunk_start;
+            iov[count].iov_len = chunk;
+            count++;
+        }
+        iov[count].iov_base = (void*)seg->data;
+        iov[count].iov_len = seg->len;
+        count++;
+        chunk_start = seg->offset;
+    }
+    
+    size_t tail = writer->position - chunk_start;
+    crc = dcf_ser_crc32_update(crc, writer->buffer + chunk_start, tail);
+    
+    if (!(writer->flags & DCF_SER_FLAG_NO_CRC)) {
+        uint32_t crc_net = dcf_ser_hton32(crc ^ 0xFFFFFFFF);
+        memcpy(writer->buffer + writer->position, &crc_net, 4);
+        tail += 4;
+    }
+    
+    if (tail > 0) {
+        iov[count].iov_base = writer->buffer + chunk_start;
+        iov[count].iov_len = tail;
+        count++;
+    }
     
+    writer->header_written = true;
+    writer->msg_end = chunk_start + tail;
+    *out_count = count;
     return DCF_SER_OK;
 }
 
 size_t dcf_ser_writer_payload_size(const DCFSerWriter* writer) {
-    return writer ? (writer->position - sizeof(DCFSerHeader)) : 0;
+    if (!writer) return 0;
+    return writer->flushed + writer->position - writer->payload_start + writer->ref_bytes;
 }
 
 void dcf_ser_writer_set_sequence(DCFSerWriter* writer, uint32_t seq) {
     if (writer) writer->sequence = seq;
 }
 
+void dcf_ser_writer_set_sequence_base(DCFSerWriter* writer, uint32_t base) {
+    if (writer) writer->seq_base = base;
+}
+
 /* ----------------------------------------------------------------------------
  * Primitive Writers
  * ---------------------------------------------------------------------------- */
@@ -430,14 +934,7 @@ DCFSerError dcf_ser_write_varint(DCFSerWriter* w, uint64_t val) {
     DCF_SER_CHECK(writer_put_u8(w, DCF_TYPE_VARINT));
     
     /* LEB128 encoding */
-    do {
-        uint8_t byte = val & 0x7F;
-        val >>= 7;
-        if (val != 0) byte |= 0x80;
-        DCF_SER_CHECK(writer_put_u8(w, byte));
-    } while (val != 0);
-    
-    return DCF_SER_OK;
+    return writer_put_varint(w, val);
 }
 
 DCFSerError dcf_ser_write_varsint(DCFSerWriter* w, int64_t val) {
@@ -454,15 +951,13 @@ DCFSerError dcf_ser_write_string(DCFSerWriter* w, const char* str) {
 
 DCFSerError dcf_ser_write_string_n(DCFSerWriter* w, const char* str, size_t len) {
     if (!w) return DCF_SER_ERR_NULL_PTR;
-    if (len > DCF_SER_MAX_STRING) return DCF_SER_ERR_TOO_LARGE;
+    if (len > w->limits.max_string) return DCF_SER_ERR_TOO_LARGE;
     
     DCF_SER_CHECK(writer_put_u8(w, DCF_TYPE_STRING));
     DCF_SER_CHECK(writer_put_u32(w, (uint32_t)len));
     
     if (len > 0 && str) {
-        WRITER_ENSURE_SPACE(w, len);
-        memcpy(w->buffer + w->position, str, len);
-        w->position += len;
+        DCF_SER_CHECK(writer_put_bytes(w, str, len));
     }
     
     return DCF_SER_OK;
@@ -470,17 +965,49 @@ DCFSerError dcf_ser_write_string_n(DCFSerWriter* w, const char* str, size_t len)
 
 DCFSerError dcf_ser_write_bytes(DCFSerWriter* w, const void* data, size_t len) {
     if (!w) return DCF_SER_ERR_NULL_PTR;
-    if (len > DCF_SER_MAX_MESSAGE) return DCF_SER_ERR_TOO_LARGE;
+    if (len > w->limits.max_message || len > UINT32_MAX) return DCF_SER_ERR_TOO_LARGE;
     
     DCF_SER_CHECK(writer_put_u8(w, DCF_TYPE_BYTES));
     DCF_SER_CHECK(writer_put_u32(w, (uint32_t)len));
     
     if (len > 0 && data) {
-        WRITER_ENSURE_SPACE(w, len);
-        memcpy(w->buffer + w->position, data, len);
-        w->position += len;
+        DCF_SER_CHECK(writer_put_bytes(w, data, len));
+    }
+    
+    return DCF_SER_OK;
+}
+
+DCFSerError dcf_ser_write_bytes_ref(DCFSerWriter* w, const void* data, size_t len) {
+    if (!w) return DCF_SER_ERR_NULL_PTR;
+    /* Small values, sink writers (which flush as they go) and values inside
+     * sorted maps (which get moved) copy inline */
+    if (len < DCF_SER_REF_MIN_LEN || w->sink || w->held_depth) return dcf_ser_write_bytes(w, data, len);
+    if (!data) return DCF_SER_ERR_NULL_PTR;
+    if (len > UINT32_MAX || dcf_ser_writer_payload_size(w) + 5 + len > w->limits.max_message) {
+        return DCF_SER_ERR_TOO_LARGE;
+    }
+    
+    if (w->segment_count == w->segment_cap) {
+        size_t new_cap = w->segment_cap ? w->segment_cap * 2 : 8;
+        DCFSerSegment* segs = (DCFSerSegment*)realloc(w->segments,
+                                                      new_cap * sizeof(DCFSerSegment));
+        if (!segs) {
+            w->last_error = DCF_SER_ERR_ALLOC_FAIL;
+            return DCF_SER_ERR_ALLOC_FAIL;
+        }
+        w->segments = segs;
+        w->segment_cap = new_cap;
     }
     
+    DCF_SER_CHECK(writer_put_u8(w, DCF_TYPE_BYTES));
+    DCF_SER_CHECK(writer_put_u32(w, (uint32_t)len));
+    
+    DCFSerSegment* seg = &w->segments[w->segment_count++];
+    seg->offset = w->position;
+    seg->data = data;
+    seg->len = len;
+    w->ref_bytes += len;
+    
     return DCF_SER_OK;
 }
 
@@ -507,8 +1034,8 @@ DCFSerError dcf_ser_write_timestamp(DCFSerWriter* w, uint64_t timestamp_us) {
 
 DCFSerError dcf_ser_write_array_begin(DCFSerWriter* w, DCFSerType elem_type, size_t count) {
     if (!w) return DCF_SER_ERR_NULL_PTR;
-    if (count > DCF_SER_MAX_ARRAY) return DCF_SER_ERR_TOO_LARGE;
-    if (w->depth >= DCF_SER_MAX_DEPTH) return DCF_SER_ERR_DEPTH_EXCEEDED;
+    if (count > w->limits.max_array) return DCF_SER_ERR_TOO_LARGE;
+    if (w->depth >= w->limits.max_depth) return DCF_SER_ERR_DEPTH_EXCEEDED;
     
     DCF_SER_CHECK(writer_put_u8(w, DCF_TYPE_ARRAY));
     DCF_SER_CHECK(writer_put_u8(w, (uint8_t)elem_type));
@@ -528,8 +1055,8 @@ DCFSerError dcf_ser_write_array_end(DCFSerWriter* w) {
 DCFSerError dcf_ser_write_map_begin(DCFSerWriter* w, DCFSerType key_type,
                                      DCFSerType val_type, size_t count) {
     if (!w) return DCF_SER_ERR_NULL_PTR;
-    if (count > DCF_SER_MAX_ARRAY) return DCF_SER_ERR_TOO_LARGE;
-    if (w->depth >= DCF_SER_MAX_DEPTH) return DCF_SER_ERR_DEPTH_EXCEEDED;
+    if (count > w->limits.max_array) return DCF_SER_ERR_TOO_LARGE;
+    if (w->depth >= w->limits.max_depth) return DCF_SER_ERR_DEPTH_EXCEEDED;
     
     DCF_SER_CHECK(writer_put_u8(w, DCF_TYPE_MAP));
     DCF_SER_CHECK(writer_put_u8(w, (uint8_t)key_type));
@@ -549,7 +1076,7 @@ DCFSerError dcf_ser_write_map_end(DCFSerWriter* w) {
 
 DCFSerError dcf_ser_write_struct_begin(DCFSerWriter* w, uint16_t type_id) {
     if (!w) return DCF_SER_ERR_NULL_PTR;
-    if (w->depth >= DCF_SER_MAX_DEPTH) return DCF_SER_ERR_DEPTH_EXCEEDED;
+    if (w->depth >= w->limits.max_depth) return DCF_SER_ERR_DEPTH_EXCEEDED;
     
     DCF_SER_CHECK(writer_put_u8(w, DCF_TYPE_STRUCT));
     DCF_SER_CHECK(writer_put_u16(w, type_id));
@@ -586,10 +1113,7 @@ DCFSerError dcf_ser_write_raw(DCFSerWriter* w, const void* data, size_t len) {
     if (len == 0) return DCF_SER_OK;
     if (!data) return DCF_SER_ERR_NULL_PTR;
     
-    WRITER_ENSURE_SPACE(w, len);
-    memcpy(w->buffer + w->position, data, len);
-    w->position += len;
-    return DCF_SER_OK;
+    return writer_put_bytes(w, data, len);
 }
 
 DCFSerError dcf_ser_write_reserve(DCFSerWriter* w, size_t len, uint8_t** out_ptr) {
@@ -601,10 +1125,83 @@ DCFSerError dcf_ser_write_reserve(DCFSerWriter* w, size_t len, uint8_t** out_ptr
     return DCF_SER_OK;
 }
 
+/* ----------------------------------------------------------------------------
+ * Batch Writers
+ * ---------------------------------------------------------------------------- */
+
+#define BATCH_LEN_RESERVE 5  /* Max LEB128 bytes for a 32-bit length */
+
+DCFSerError dcf_ser_batch_begin(DCFSerWriter* w, uint16_t msg_type, uint32_t sequence) {
+    if (!w) return DCF_SER_ERR_NULL_PTR;
+    if (w->msg_type != DCF_SER_MSG_BATCH || w->batch_open || w->depth != 0) {
+        return DCF_SER_ERR_INVALID_ARG;
+    }
+    
+    DCF_SER_CHECK(writer_put_varint(w, msg_type));
+    DCF_SER_CHECK(writer_put_varint(w, sequence));
+    
+    /* Length is unknown until the sub-message ends; reserve the max */
+    WRITER_ENSURE_SPACE(w, BATCH_LEN_RESERVE);
+    w->position += BATCH_LEN_RESERVE;
+    
+    w->batch_mark = w->position;
+    w->batch_refs = w->ref_bytes;
+    w->batch_open = true;
+    return DCF_SER_OK;
+}
+
+DCFSerError dcf_ser_batch_end(DCFSerWriter* w) {
+    if (!w) return DCF_SER_ERR_NULL_PTR;
+    if (!w->batch_open || w->depth != 0) return DCF_SER_ERR_MALFORMED;
+    
+    size_t body_len = w->position - w->batch_mark + (w->ref_bytes - w->batch_refs);
+    if (body_len > UINT32_MAX) return DCF_SER_ERR_TOO_LARGE;
+    
+    uint8_t len_buf[BATCH_LEN_RESERVE];
+    size_t len_size = varint_encode(len_buf, body_len);
+    size_t shift = BATCH_LEN_RESERVE - len_size;
+    
+    /* Write the minimal length encoding and close the gap */
+    size_t len_pos = w->batch_mark - BATCH_LEN_RESERVE;
+    memcpy(w->buffer + len_pos, len_buf, len_size);
+    if (shift > 0) {
+        memmove(w->buffer + len_pos + len_size, w->buffer + w->batch_mark,
+                w->position - w->batch_mark);
+        w->position -= shift;
+        for (size_t i = w->segment_count; i-- > 0 && w->segments[i].offset >= w->batch_mark; ) {
+            w->segments[i].offset -= shift;
+        }
+    }
+    
+    w->batch_open = false;
+    return DCF_SER_OK;
+}
+
+DCFSerError dcf_ser_batch_append(DCFSerWriter* w, uint16_t msg_type, uint32_t sequence,
+                                 const void* payload, size_t len) {
+    if (!w) return DCF_SER_ERR_NULL_PTR;
+    if (len > 0 && !payload) return DCF_SER_ERR_NULL_PTR;
+    if (len > UINT32_MAX) return DCF_SER_ERR_TOO_LARGE;
+    if (w->msg_type != DCF_SER_MSG_BATCH || w->batch_open || w->depth != 0) {
+        return DCF_SER_ERR_INVALID_ARG;
+    }
+    
+    DCF_SER_CHECK(writer_put_varint(w, msg_type));
+    DCF_SER_CHECK(writer_put_varint(w, sequence));
+    DCF_SER_CHECK(writer_put_varint(w, len));
+    return dcf_ser_write_raw(w, payload, len);
+}
+
 /* ============================================================================
  * Reader Internal Functions
  * ============================================================================ */
 
+/* Value not fully received yet: rewind to its start so the call can be retried */
+static DCFSerError reader_need_more(DCFSerReader* r) {
+    r->position = r->mark;
+    return DCF_SER_ERR_NEED_MORE;
+}
+
 static DCFSerError reader_get_u8(DCFSerReader* r, uint8_t* out) {
     READER_ENSURE_BYTES(r, 1);
     *out = r->buffer[r->position++];
@@ -638,8 +1235,28 @@ static DCFSerError reader_get_u64(DCFSerReader* r, uint64_t* out) {
     return DCF_SER_OK;
 }
 
-static DCFSerError reader_expect_type(DCFSerReader* r, DCFSerType expected) {
-    uint8_t type_byte;
+static DCFSerError reader_get_varint(DCFSerReader* r, uint64_t* out) {
+    uint64_t result = 0;
+    uint8_t shift = 0;
+    uint8_t b;
+    
+    do {
+        if (shift >= 64) return DCF_SER_ERR_OVERFLOW;
+        DCF_SER_CHECK(reader_get_u8(r, &b));
+        result |= (uint64_t)(b & 0x7F) << shift;
+        shift += 7;
+    } while (b & 0x80);
+    
+    *out = result;
+    return DCF_SER_OK;
+}
+
+static DCFSerError reader_iov_prepare(DCFSerReader* r, bool whole);
+
+static DCFSerError reader_expect_type(DCFSerReader* r, DCFSerType expected) {
+    if (r->iov) DCF_SER_CHECK(reader_iov_prepare(r, true));
+    r->mark = r->position;
+    uint8_t type_byte;
     DCF_SER_CHECK(reader_get_u8(r, &type_byte));
     if ((DCFSerType)type_byte != expected) {
         r->last_error = DCF_SER_ERR_TYPE_MISMATCH;
@@ -648,56 +1265,260 @@ static DCFSerError reader_expect_type(DCFSerReader* r, DCFSerType expected) {
     return DCF_SER_OK;
 }
 
+/* ----------------------------------------------------------------------------
+ * Segmented (Scatter-Gather) Reading
+ * 
+ * The reader decodes from a window: normally the segment holding the
+ * current value, or, when a value straddles segments, a copy of it in
+ * r->scratch. position/length/payload_end are window-relative; win_base
+ * is the window's logical offset in the message.
+ * ---------------------------------------------------------------------------- */
+
+/* Find the segment holding logical offset off (the last one if off is the end) */
+static void reader_iov_locate(const DCFSerReader* r, size_t off, size_t* out_seg, size_t* out_start) {
+    size_t seg = 0, start = 0;
+    if (r->seg_start <= off) {
+        seg = r->seg;
+        start = r->seg_start;
+    }
+    while (seg + 1 < r->iov_count && off >= start + r->iov[seg].iov_len) {
+        start += r->iov[seg].iov_len;
+        seg++;
+    }
+    *out_seg = seg;
+    *out_start = start;
+}
+
+static void reader_iov_copy(const DCFSerReader* r, size_t off, void* dst, size_t n) {
+    size_t seg, start;
+    reader_iov_locate(r, off, &seg, &start);
+    uint8_t* out = (uint8_t*)dst;
+    while (n > 0 && seg < r->iov_count) {
+        size_t in_seg = off - start;
+        size_t take = r->iov[seg].iov_len - in_seg;
+        if (take > n) take = n;
+        memcpy(out, (const uint8_t*)r->iov[seg].iov_base + in_seg, take);
+        out += take;
+        off += take;
+        n -= take;
+        start += r->iov[seg].iov_len;
+        seg++;
+    }
+}
+
+/* Move the window to the segment holding logical offset off */
+static DCFSerError reader_iov_seek(DCFSerReader* r, size_t off) {
+    size_t seg, start;
+    reader_iov_locate(r, off, &seg, &start);
+    
+    size_t len = r->iov[seg].iov_len;
+    if (len > r->iov_end - start) len = r->iov_end - start;
+    
+    r->seg = seg;
+    r->seg_start = start;
+    r->buffer = (const uint8_t*)r->iov[seg].iov_base;
+    r->win_base = start;
+    r->position = off - start;
+    r->length = len;
+    r->payload_end = len;
+    return DCF_SER_OK;
+}
+
+/* Make the next n bytes contiguous in the window (fewer at the payload end) */
+static DCFSerError reader_iov_ensure(DCFSerReader* r, size_t n) {
+    if (r->position + n <= r->length) return DCF_SER_OK;
+    
+    size_t off = r->win_base + r->position;
+    size_t avail = r->iov_end - off;
+    if (n > avail) n = avail;
+    
+    /* Fast path: the value starts a fresh segment, or sits within one */
+    DCF_SER_CHECK(reader_iov_seek(r, off));
+    if (r->position + n <= r->length) return DCF_SER_OK;
+    
+    if (n > DCF_SER_IOV_SCRATCH) return DCF_SER_ERR_FRAGMENTED;
+    
+    /* Straddles a boundary: linearize into scratch */
+    size_t take = avail < DCF_SER_IOV_SCRATCH ? avail : DCF_SER_IOV_SCRATCH;
+    reader_iov_copy(r, off, r->scratch, take);
+    r->buffer = r->scratch;
+    r->win_base = off;
+    r->position = 0;
+    r->length = take;
+    r->payload_end = take;
+    return DCF_SER_OK;
+}
+
+/* Make the next value (or with !whole, just its header) contiguous */
+static DCFSerError reader_iov_prepare(DCFSerReader* r, bool whole) {
+    DCF_SER_CHECK(reader_iov_ensure(r, 1));
+    if (r->position >= r->length) return DCF_SER_OK;  /* At end: reads report it */
+    
+    size_t need;
+    switch ((DCFSerType)r->buffer[r->position]) {
+        case DCF_TYPE_BOOL: case DCF_TYPE_U8: case DCF_TYPE_I8:
+            need = 2; break;
+        case DCF_TYPE_U16: case DCF_TYPE_I16:
+            need = 3; break;
+        case DCF_TYPE_U32: case DCF_TYPE_I32: case DCF_TYPE_F32:
+            need = 5; break;
+        case DCF_TYPE_U64: case DCF_TYPE_I64: case DCF_TYPE_F64:
+        case DCF_TYPE_TIMESTAMP: case DCF_TYPE_DURATION:
+            need = 9; break;
+        case DCF_TYPE_UUID:
+            need = 17; break;
+        case DCF_TYPE_VARINT:
+            need = 11; break;
+        case DCF_TYPE_ARRAY:
+            need = 6; break;
+        case DCF_TYPE_MAP:
+        case DCF_TYPE_SORTED_MAP:
+            need = 7; break;
+        case DCF_TYPE_STRUCT:
+            need = 3; break;
+        case DCF_TYPE_TABLE:
+            need = 9; break;
+        case DCF_TYPE_FIXED:
+        case DCF_TYPE_COMPACT_STRUCT:
+            need = 7; break;
+        case DCF_TYPE_SCHEMA_REF:
+            need = 13; break;
+        case DCF_TYPE_STRING:
+        case DCF_TYPE_BYTES: {
+            need = 5;
+            if (!whole) break;
+            DCF_SER_CHECK(reader_iov_ensure(r, 5));
+            if (r->position + 5 > r->length) break;
+            uint32_t len_net;
+            memcpy(&len_net, r->buffer + r->position + 1, 4);
+            need += dcf_ser_ntoh32(len_net);
+            break;
+        }
+        default:
+            need = 1; break;
+    }
+    
+    return reader_iov_ensure(r, need);
+}
+
+static DCFSerError reader_parse_header(DCFSerReader* reader, size_t* out_msg_len);
+
+/* Validate a segmented message: header via scratch, CRC across segments */
+static DCFSerError reader_iov_validate(DCFSerReader* reader) {
+    size_t total = 0;
+    for (size_t i = 0; i < reader->iov_count; i++) total += reader->iov[i].iov_len;
+    
+    reader->seg = 0;
+    reader->seg_start = 0;
+    reader->iov_end = total;
+    size_t hdr_avail = total < DCF_SER_IOV_SCRATCH ? total : DCF_SER_IOV_SCRATCH;
+    reader_iov_copy(reader, 0, reader->scratch, hdr_avail);
+    reader->buffer = reader->scratch;
+    reader->length = hdr_avail;
+    
+    size_t expected_size;
+    DCFSerError err = reader_parse_header(reader, &expected_size);
+    if (err == DCF_SER_OK && total < expected_size) err = DCF_SER_ERR_TRUNCATED;
+    if (err != DCF_SER_OK) {
+        reader->last_error = err;
+        return err;
+    }
+    
+    size_t crc_offset = reader->payload_end;
+    if (!(reader->header.flags & DCF_SER_FLAG_NO_CRC)) {
+        uint32_t crc = 0xFFFFFFFF;
+        size_t start = 0;
+        for (size_t i = 0; i < reader->iov_count && start < crc_offset; i++) {
+            size_t n = reader->iov[i].iov_len;
+            if (n > crc_offset - start) n = crc_offset - start;
+            crc = dcf_ser_crc32_update(crc, reader->iov[i].iov_base, n);
+            start += reader->iov[i].iov_len;
+        }
+        
+        uint32_t stored_crc;
+        reader_iov_copy(reader, crc_offset, &stored_crc, 4);
+        if (dcf_ser_ntoh32(stored_crc) != (crc ^ 0xFFFFFFFF)) {
+            reader->last_error = DCF_SER_ERR_CRC_MISMATCH;
+            return DCF_SER_ERR_CRC_MISMATCH;
+        }
+        reader->crc_verified = true;
+    }
+    
+    reader->iov_end = crc_offset;
+    reader->header_valid = true;
+    return reader_iov_seek(reader, reader->payload_start);
+}
+
 /* ============================================================================
  * Reader API Implementation
  * ============================================================================ */
 
 DCFSerError dcf_ser_reader_init(DCFSerReader* reader, const void* data, size_t len) {
     if (!reader || !data) return DCF_SER_ERR_NULL_PTR;
-    if (len < sizeof(DCFSerHeader)) return DCF_SER_ERR_TRUNCATED;
+    if (len == 0) return DCF_SER_ERR_TRUNCATED;
     
     memset(reader, 0, sizeof(DCFSerReader));
     reader->buffer = (const uint8_t*)data;
     reader->length = len;
     reader->position = 0;
+    dcf_ser_limits_default(&reader->limits);
     
     return DCF_SER_OK;
 }
 
-DCFSerError dcf_ser_reader_validate(DCFSerReader* reader) {
-    if (!reader) return DCF_SER_ERR_NULL_PTR;
-    if (reader->length < sizeof(DCFSerHeader)) return DCF_SER_ERR_TRUNCATED;
-    
-    /* Parse header */
-    const DCFSerHeader* wire_hdr = (const DCFSerHeader*)reader->buffer;
-    
-    reader->header.magic = dcf_ser_ntoh32(wire_hdr->magic);
-    reader->header.version = dcf_ser_ntoh16(wire_hdr->version);
-    reader->header.msg_type = dcf_ser_ntoh16(wire_hdr->msg_type);
-    reader->header.flags = wire_hdr->flags;
-    reader->header.payload_len = dcf_ser_ntoh32(wire_hdr->payload_len);
-    reader->header.sequence = dcf_ser_ntoh32(wire_hdr->sequence);
-    
-    /* Validate magic */
-    if (reader->header.magic != DCF_SER_MAGIC) {
-        reader->last_error = DCF_SER_ERR_INVALID_MAGIC;
-        return DCF_SER_ERR_INVALID_MAGIC;
-    }
+DCFSerError dcf_ser_reader_set_limits(DCFSerReader* reader, const DCFSerLimits* limits) {
+    if (!reader || !limits) return DCF_SER_ERR_NULL_PTR;
+    DCF_SER_CHECK(limits_check(limits));
+    reader->limits = *limits;
+    return DCF_SER_OK;
+}
+
+void dcf_ser_reader_set_sequence_base(DCFSerReader* reader, uint32_t base) {
+    if (reader) reader->seq_base = base;
+}
+
+/* Parse and check the header; sets up payload bounds and the full message size */
+static DCFSerError reader_parse_header(DCFSerReader* reader, size_t* out_msg_len) {
+    /* Parse header (full, extended or compact) */
+    size_t hdr_len;
+    uint64_t payload_len;
+    DCFSerError err = header_parse(reader->buffer, reader->length, reader->seq_base,
+                                   &reader->header, &hdr_len, &payload_len);
+    if (err != DCF_SER_OK) return err;
     
     /* Check version compatibility (major version must match) */
     uint16_t major = reader->header.version >> 8;
     uint16_t our_major = DCF_SER_VERSION >> 8;
-    if (major != our_major) {
-        reader->last_error = DCF_SER_ERR_VERSION_MISMATCH;
-        return DCF_SER_ERR_VERSION_MISMATCH;
-    }
+    if (major != our_major) return DCF_SER_ERR_VERSION_MISMATCH;
+    
+    if (payload_len > reader->limits.max_message) return DCF_SER_ERR_TOO_LARGE;
     
-    /* Calculate expected message size */
-    size_t expected_size = sizeof(DCFSerHeader) + reader->header.payload_len;
+    /* Calculate expected message size (limits keep this within size_t) */
+    size_t expected_size = hdr_len + (size_t)payload_len;
     if (!(reader->header.flags & DCF_SER_FLAG_NO_CRC)) {
         expected_size += 4;  /* CRC32 */
     }
     
+    /* Set up payload bounds */
+    reader->payload_start = hdr_len;
+    reader->payload_end = hdr_len + (size_t)payload_len;
+    reader->position = reader->payload_start;
+    reader->mark = reader->position;
+    *out_msg_len = expected_size;
+    return DCF_SER_OK;
+}
+
+DCFSerError dcf_ser_reader_validate(DCFSerReader* reader) {
+    if (!reader) return DCF_SER_ERR_NULL_PTR;
+    if (reader->iov) return reader_iov_validate(reader);
+    
+    size_t expected_size;
+    DCFSerError err = reader_parse_header(reader, &expected_size);
+    if (err != DCF_SER_OK) {
+        reader->last_error = err;
+        return err;
+    }
+    
     if (reader->length < expected_size) {
         reader->last_error = DCF_SER_ERR_TRUNCATED;
         return DCF_SER_ERR_TRUNCATED;
@@ -705,7 +1526,7 @@ DCFSerError dcf_ser_reader_validate(DCFSerReader* reader) {
     
     /* Verify CRC if present */
     if (!(reader->header.flags & DCF_SER_FLAG_NO_CRC)) {
-        size_t crc_offset = sizeof(DCFSerHeader) + reader->header.payload_len;
+        size_t crc_offset = reader->payload_end;
         uint32_t stored_crc;
         memcpy(&stored_crc, reader->buffer + crc_offset, 4);
         stored_crc = dcf_ser_ntoh32(stored_crc);
@@ -719,15 +1540,162 @@ DCFSerError dcf_ser_reader_validate(DCFSerReader* reader) {
         reader->crc_verified = true;
     }
     
-    /* Set up payload bounds */
-    reader->payload_start = sizeof(DCFSerHeader);
-    reader->payload_end = sizeof(DCFSerHeader) + reader->header.payload_len;
-    reader->position = reader->payload_start;
     reader->header_valid = true;
     
     return DCF_SER_OK;
 }
 
+/* ----------------------------------------------------------------------------
+ * Incremental Reading
+ * ---------------------------------------------------------------------------- */
+
+/* Hash newly arrived bytes; once the whole message is in, check the CRC */
+static DCFSerError reader_incremental_update(DCFSerReader* reader) {
+    if (!reader->header_valid) {
+        DCFSerError err = reader_parse_header(reader, &reader->msg_len);
+        if (err == DCF_SER_ERR_TRUNCATED) return DCF_SER_ERR_NEED_MORE;
+        if (err != DCF_SER_OK) {
+            reader->last_error = err;
+            return err;
+        }
+        reader->header_valid = true;
+        reader->crc_state = 0xFFFFFFFF;
+        reader->crc_pos = 0;
+    }
+    
+    if (reader->header.flags & DCF_SER_FLAG_NO_CRC) return DCF_SER_OK;
+    
+    size_t crc_offset = reader->payload_end;
+    size_t upto = reader->length < crc_offset ? reader->length : crc_offset;
+    if (upto > reader->crc_pos) {
+        reader->crc_state = dcf_ser_crc32_update(reader->crc_state,
+                                                 reader->buffer + reader->crc_pos,
+                                                 upto - reader->crc_pos);
+        reader->crc_pos = upto;
+    }
+    
+    if (!reader->crc_verified && reader->length >= reader->msg_len) {
+        uint32_t stored_crc;
+        memcpy(&stored_crc, reader->buffer + crc_offset, 4);
+        if (dcf_ser_ntoh32(stored_crc) != (reader->crc_state ^ 0xFFFFFFFF)) {
+            reader->last_error = DCF_SER_ERR_CRC_MISMATCH;
+            return DCF_SER_ERR_CRC_MISMATCH;
+        }
+        reader->crc_verified = true;
+    }
+    
+    return DCF_SER_OK;
+}
+
+DCFSerError dcf_ser_reader_init_incremental(DCFSerReader* reader, const void* data, size_t avail) {
+    if (!reader || (!data && avail > 0)) return DCF_SER_ERR_NULL_PTR;
+    
+    memset(reader, 0, sizeof(DCFSerReader));
+    reader->buffer = (const uint8_t*)data;
+    reader->length = avail;
+    reader->incremental = true;
+    dcf_ser_limits_default(&reader->limits);
+    
+    return reader_incremental_update(reader);
+}
+
+DCFSerError dcf_ser_reader_feed(DCFSerReader* reader, const void* data, size_t avail) {
+    if (!reader || (!data && avail > 0)) return DCF_SER_ERR_NULL_PTR;
+    if (!reader->incremental || avail < reader->length) return DCF_SER_ERR_INVALID_ARG;
+    
+    reader->buffer = (const uint8_t*)data;
+    reader->length = avail;
+    return reader_incremental_update(reader);
+}
+
+DCFSerError dcf_ser_reader_finish(const DCFSerReader* reader) {
+    if (!reader) return DCF_SER_ERR_NULL_PTR;
+    if (!reader->incremental) return reader->header_valid ? DCF_SER_OK : DCF_SER_ERR_INVALID_ARG;
+    if (!reader->header_valid || reader->length < reader->msg_len) return DCF_SER_ERR_NEED_MORE;
+    if (reader->last_error == DCF_SER_ERR_CRC_MISMATCH) return DCF_SER_ERR_CRC_MISMATCH;
+    return DCF_SER_OK;
+}
+
+/* ----------------------------------------------------------------------------
+ * Segmented Reading
+ * ---------------------------------------------------------------------------- */
+
+DCFSerError dcf_ser_reader_init_iov(DCFSerReader* reader, const DCFSerIoVec* iov, size_t count) {
+    if (!reader || !iov) return DCF_SER_ERR_NULL_PTR;
+    if (count == 0) return DCF_SER_ERR_TRUNCATED;
+    
+    memset(reader, 0, sizeof(DCFSerReader));
+    reader->iov = iov;
+    reader->iov_count = count;
+    dcf_ser_limits_default(&reader->limits);
+    
+    return DCF_SER_OK;
+}
+
+DCFSerError dcf_ser_read_bytes_iov(DCFSerReader* r, DCFSerIoVec* frags, size_t max_frags,
+                                   size_t* out_count, size_t* out_len) {
+    if (!r || !frags || !out_count || !out_len) return DCF_SER_ERR_NULL_PTR;
+    
+    if (!r->iov) {
+        const void* data;
+        size_t len;
+        if (max_frags < 1) return DCF_SER_ERR_BUFFER_FULL;
+        DCF_SER_CHECK(dcf_ser_read_bytes(r, &data, &len));
+        frags[0].iov_base = (void*)data;
+        frags[0].iov_len = len;
+        *out_count = 1;
+        *out_len = len;
+        return DCF_SER_OK;
+    }
+    
+    /* Only the tag and length need to be contiguous */
+    DCF_SER_CHECK(reader_iov_prepare(r, false));
+    size_t start = r->win_base + r->position;
+    uint8_t tag;
+    uint32_t len;
+    DCF_SER_CHECK(reader_get_u8(r, &tag));
+    if ((DCFSerType)tag != DCF_TYPE_BYTES) {
+        DCF_SER_CHECK(reader_iov_seek(r, start));
+        return DCF_SER_ERR_TYPE_MISMATCH;
+    }
+    DCF_SER_CHECK(reader_get_u32(r, &len));
+    
+    size_t off = r->win_base + r->position;
+    if (len > r->iov_end - off) return DCF_SER_ERR_TRUNCATED;
+    
+    /* One fragment per segment the value touches */
+    size_t seg, seg_start, count = 0, left = len;
+    reader_iov_locate(r, off, &seg, &seg_start);
+    while (left > 0) {
+        if (count == max_frags) {
+            DCF_SER_CHECK(reader_iov_seek(r, start));
+            return DCF_SER_ERR_BUFFER_FULL;
+        }
+        size_t in_seg = off - seg_start;
+        size_t take = r->iov[seg].iov_len - in_seg;
+        if (take > left) take = left;
+        if (take > 0) {
+            frags[count].iov_base = (uint8_t*)r->iov[seg].iov_base + in_seg;
+            frags[count].iov_len = take;
+            count++;
+        }
+        off += take;
+        left -= take;
+        seg_start += r->iov[seg].iov_len;
+        seg++;
+    }
+    
+    *out_count = count;
+    *out_len = len;
+    return reader_iov_seek(r, off);
+}
+
+uint64_t dcf_ser_reader_payload_length(const DCFSerReader* reader) {
+    if (!reader || !reader->header_valid) return 0;
+    if (reader->iov) return reader->iov_end - reader->payload_start;
+    return reader->payload_end - reader->payload_start;
+}
+
 const DCFSerHeader* dcf_ser_reader_header(const DCFSerReader* reader) {
     return (reader && reader->header_valid) ? &reader->header : NULL;
 }
@@ -738,23 +1706,45 @@ uint16_t dcf_ser_reader_msg_type(const DCFSerReader* reader) {
 
 size_t dcf_ser_reader_remaining(const DCFSerReader* reader) {
     if (!reader || !reader->header_valid) return 0;
+    if (reader->iov) return reader->iov_end - (reader->win_base + reader->position);
     return reader->payload_end - reader->position;
 }
 
 bool dcf_ser_reader_at_end(const DCFSerReader* reader) {
+    if (reader && reader->iov) return dcf_ser_reader_remaining(reader) == 0;
     return !reader || !reader->header_valid || reader->position >= reader->payload_end;
 }
 
 DCFSerType dcf_ser_reader_peek_type(const DCFSerReader* reader) {
-    if (!reader || reader->position >= reader->payload_end) {
+    if (reader && reader->iov) {
+        if (dcf_ser_reader_remaining(reader) == 0) return DCF_TYPE_INVALID;
+        uint8_t tag;
+        reader_iov_copy(reader, reader->win_base + reader->position, &tag, 1);
+        return (DCFSerType)tag;
+    }
+    if (!reader || reader->position >= reader->payload_end ||
+        reader->position >= reader->length) {
         return DCF_TYPE_INVALID;
     }
     return (DCFSerType)reader->buffer[reader->position];
 }
 
-DCFSerError dcf_ser_reader_skip(DCFSerReader* reader) {
-    if (!reader) return DCF_SER_ERR_NULL_PTR;
-    
+static DCFSerError reader_iov_seek(DCFSerReader* r, size_t off);
+
+static DCFSerError reader_advance(DCFSerReader* r, size_t n) {
+    if (r->iov && r->position + n > r->length) {
+        /* Segmented: the skipped bytes need not be in the window */
+        size_t off = r->win_base + r->position;
+        if (n > r->iov_end - off) return DCF_SER_ERR_TRUNCATED;
+        return reader_iov_seek(r, off + n);
+    }
+    READER_ENSURE_BYTES(r, n);
+    r->position += n;
+    return DCF_SER_OK;
+}
+
+static DCFSerError reader_skip_value(DCFSerReader* reader) {
+    if (reader->iov) DCF_SER_CHECK(reader_iov_prepare(reader, false));
     uint8_t type_byte;
     DCF_SER_CHECK(reader_get_u8(reader, &type_byte));
     DCFSerType type = (DCFSerType)type_byte;
@@ -765,26 +1755,26 @@ DCFSerError dcf_ser_reader_skip(DCFSerReader* reader) {
         case DCF_TYPE_BOOL:
         case DCF_TYPE_U8:
         case DCF_TYPE_I8:
-            reader->position += 1;
+            DCF_SER_CHECK(reader_advance(reader, 1));
             break;
         case DCF_TYPE_U16:
         case DCF_TYPE_I16:
-            reader->position += 2;
+            DCF_SER_CHECK(reader_advance(reader, 2));
             break;
         case DCF_TYPE_U32:
         case DCF_TYPE_I32:
         case DCF_TYPE_F32:
-            reader->position += 4;
+            DCF_SER_CHECK(reader_advance(reader, 4));
             break;
         case DCF_TYPE_U64:
         case DCF_TYPE_I64:
         case DCF_TYPE_F64:
         case DCF_TYPE_TIMESTAMP:
         case DCF_TYPE_DURATION:
-            reader->position += 8;
+            DCF_SER_CHECK(reader_advance(reader, 8));
             break;
         case DCF_TYPE_UUID:
-            reader->position += 16;
+            DCF_SER_CHECK(reader_advance(reader, 16));
             break;
         case DCF_TYPE_VARINT: {
             /* Skip LEB128 bytes until high bit is clear */
@@ -798,7 +1788,22 @@ DCFSerError dcf_ser_reader_skip(DCFSerReader* reader) {
         case DCF_TYPE_BYTES: {
             uint32_t len;
             DCF_SER_CHECK(reader_get_u32(reader, &len));
-            reader->position += len;
+            DCF_SER_CHECK(reader_advance(reader, len));
+            break;
+        }
+        case DCF_TYPE_FIXED:
+        case DCF_TYPE_COMPACT_STRUCT: {
+            uint32_t len;
+            DCF_SER_CHECK(reader_advance(reader, 2)); /* type_id */
+            DCF_SER_CHECK(reader_get_u32(reader, &len));
+            DCF_SER_CHECK(reader_advance(reader, len));
+            break;
+        }
+        case DCF_TYPE_SCHEMA_REF: {
+            uint32_t len;
+            DCF_SER_CHECK(reader_advance(reader, 8)); /* fingerprint */
+            DCF_SER_CHECK(reader_get_u32(reader, &len));
+            DCF_SER_CHECK(reader_advance(reader, len));
             break;
         }
         case DCF_TYPE_ARRAY: {
@@ -808,28 +1813,42 @@ DCFSerError dcf_ser_reader_skip(DCFSerReader* reader) {
             DCF_SER_CHECK(reader_get_u32(reader, &count));
             (void)elem_type;  /* Type info available but not used in skip */
             for (uint32_t i = 0; i < count; i++) {
-                DCF_SER_CHECK(dcf_ser_reader_skip(reader));
+                DCF_SER_CHECK(reader_skip_value(reader));
             }
             break;
         }
-        case DCF_TYPE_MAP: {
-            reader->position += 2; /* key_type, val_type */
+        case DCF_TYPE_MAP:
+        case DCF_TYPE_SORTED_MAP: {
+            DCF_SER_CHECK(reader_advance(reader, 2)); /* key_type, val_type */
             uint32_t count;
             DCF_SER_CHECK(reader_get_u32(reader, &count));
-            for (uint32_t i = 0; i < count * 2; i++) {
-                DCF_SER_CHECK(dcf_ser_reader_skip(reader));
+            if (type == DCF_TYPE_SORTED_MAP) {
+                DCF_SER_CHECK(reader_advance(reader, (size_t)count * 4)); /* offset table */
+            }
+            for (uint64_t i = 0; i < (uint64_t)count * 2; i++) {
+                DCF_SER_CHECK(reader_skip_value(reader));
             }
             break;
         }
+        case DCF_TYPE_TABLE: {
+            DCF_SER_CHECK(reader_advance(reader, 2)); /* type_id */
+            uint16_t slots;
+            uint32_t body;
+            DCF_SER_CHECK(reader_get_u16(reader, &slots));
+            DCF_SER_CHECK(reader_get_u32(reader, &body));
+            DCF_SER_CHECK(reader_advance(reader, (size_t)slots * 4 + body));
+            break;
+        }
         case DCF_TYPE_STRUCT: {
-            reader->position += 2; /* type_id */
+            DCF_SER_CHECK(reader_advance(reader, 2)); /* type_id */
             while (true) {
                 uint16_t field_id;
                 uint8_t field_type;
+                if (reader->iov) DCF_SER_CHECK(reader_iov_ensure(reader, 3));
                 DCF_SER_CHECK(reader_get_u16(reader, &field_id));
                 DCF_SER_CHECK(reader_get_u8(reader, &field_type));
                 if (field_id == 0 && field_type == DCF_TYPE_NULL) break;
-                DCF_SER_CHECK(dcf_ser_reader_skip(reader));
+                DCF_SER_CHECK(reader_skip_value(reader));
             }
             break;
         }
@@ -840,6 +1859,12 @@ DCFSerError dcf_ser_reader_skip(DCFSerReader* reader) {
     return DCF_SER_OK;
 }
 
+DCFSerError dcf_ser_reader_skip(DCFSerReader* reader) {
+    if (!reader) return DCF_SER_ERR_NULL_PTR;
+    reader->mark = reader->position;
+    return reader_skip_value(reader);
+}
+
 /* ----------------------------------------------------------------------------
  * Primitive Readers
  * ---------------------------------------------------------------------------- */
@@ -930,20 +1955,7 @@ DCFSerError dcf_ser_read_f64(DCFSerReader* r, double* out) {
 DCFSerError dcf_ser_read_varint(DCFSerReader* r, uint64_t* out) {
     if (!r || !out) return DCF_SER_ERR_NULL_PTR;
     DCF_SER_CHECK(reader_expect_type(r, DCF_TYPE_VARINT));
-    
-    uint64_t result = 0;
-    uint8_t shift = 0;
-    uint8_t b;
-    
-    do {
-        if (shift >= 64) return DCF_SER_ERR_OVERFLOW;
-        DCF_SER_CHECK(reader_get_u8(r, &b));
-        result |= (uint64_t)(b & 0x7F) << shift;
-        shift += 7;
-    } while (b & 0x80);
-    
-    *out = result;
-    return DCF_SER_OK;
+    return reader_get_varint(r, out);
 }
 
 DCFSerError dcf_ser_read_varsint(DCFSerReader* r, int64_t* out) {
@@ -963,6 +1975,7 @@ DCFSerError dcf_ser_read_string(DCFSerReader* r, const char** out_str, size_t* o
     
     uint32_t len;
     DCF_SER_CHECK(reader_get_u32(r, &len));
+    if (len > r->limits.max_string) return DCF_SER_ERR_TOO_LARGE;
     
     READER_ENSURE_BYTES(r, len);
     
@@ -1049,7 +2062,7 @@ DCFSerError dcf_ser_read_timestamp(DCFSerReader* r, uint64_t* out_us) {
 
 DCFSerError dcf_ser_read_array_begin(DCFSerReader* r, DCFSerType* out_elem_type, size_t* out_count) {
     if (!r || !out_elem_type || !out_count) return DCF_SER_ERR_NULL_PTR;
-    if (r->depth >= DCF_SER_MAX_DEPTH) return DCF_SER_ERR_DEPTH_EXCEEDED;
+    if (r->depth >= r->limits.max_depth) return DCF_SER_ERR_DEPTH_EXCEEDED;
     
     DCF_SER_CHECK(reader_expect_type(r, DCF_TYPE_ARRAY));
     
@@ -1057,6 +2070,7 @@ DCFSerError dcf_ser_read_array_begin(DCFSerReader* r, DCFSerType* out_elem_type,
     uint32_t count;
     DCF_SER_CHECK(reader_get_u8(r, &elem_type));
     DCF_SER_CHECK(reader_get_u32(r, &count));
+    if (count > r->limits.max_array) return DCF_SER_ERR_TOO_LARGE;
     
     *out_elem_type = (DCFSerType)elem_type;
     *out_count = count;
@@ -1075,15 +2089,19 @@ DCFSerError dcf_ser_read_array_end(DCFSerReader* r) {
 DCFSerError dcf_ser_read_map_begin(DCFSerReader* r, DCFSerType* out_key_type,
                                     DCFSerType* out_val_type, size_t* out_count) {
     if (!r || !out_key_type || !out_val_type || !out_count) return DCF_SER_ERR_NULL_PTR;
-    if (r->depth >= DCF_SER_MAX_DEPTH) return DCF_SER_ERR_DEPTH_EXCEEDED;
+    if (r->depth >= r->limits.max_depth) return DCF_SER_ERR_DEPTH_EXCEEDED;
     
-    DCF_SER_CHECK(reader_expect_type(r, DCF_TYPE_MAP));
+    /* Sorted maps read the same way, in key order, past their offset table */
+    bool sorted = dcf_ser_reader_peek_type(r) == DCF_TYPE_SORTED_MAP;
+    DCF_SER_CHECK(reader_expect_type(r, sorted ? DCF_TYPE_SORTED_MAP : DCF_TYPE_MAP));
     
     uint8_t key_type, val_type;
     uint32_t count;
     DCF_SER_CHECK(reader_get_u8(r, &key_type));
     DCF_SER_CHECK(reader_get_u8(r, &val_type));
     DCF_SER_CHECK(reader_get_u32(r, &count));
+    if (count > r->limits.max_array) return DCF_SER_ERR_TOO_LARGE;
+    if (sorted) DCF_SER_CHECK(reader_advance(r, (size_t)count * 4));
     
     *out_key_type = (DCFSerType)key_type;
     *out_val_type = (DCFSerType)val_type;
@@ -1102,7 +2120,7 @@ DCFSerError dcf_ser_read_map_end(DCFSerReader* r) {
 
 DCFSerError dcf_ser_read_struct_begin(DCFSerReader* r, uint16_t* out_type_id) {
     if (!r || !out_type_id) return DCF_SER_ERR_NULL_PTR;
-    if (r->depth >= DCF_SER_MAX_DEPTH) return DCF_SER_ERR_DEPTH_EXCEEDED;
+    if (r->depth >= r->limits.max_depth) return DCF_SER_ERR_DEPTH_EXCEEDED;
     
     DCF_SER_CHECK(reader_expect_type(r, DCF_TYPE_STRUCT));
     DCF_SER_CHECK(reader_get_u16(r, out_type_id));
@@ -1114,6 +2132,8 @@ DCFSerError dcf_ser_read_struct_begin(DCFSerReader* r, uint16_t* out_type_id) {
 DCFSerError dcf_ser_read_field(DCFSerReader* r, uint16_t* out_field_id, DCFSerType* out_type) {
     if (!r || !out_field_id || !out_type) return DCF_SER_ERR_NULL_PTR;
     
+    if (r->iov) DCF_SER_CHECK(reader_iov_ensure(r, 3));
+    r->mark = r->position;
     DCF_SER_CHECK(reader_get_u16(r, out_field_id));
     
     uint8_t type_byte;
@@ -1141,6 +2161,14 @@ DCFSerError dcf_ser_read_struct_end(DCFSerReader* r) {
 
 DCFSerError dcf_ser_read_raw(DCFSerReader* r, void* out, size_t len) {
     if (!r || !out) return DCF_SER_ERR_NULL_PTR;
+    if (r->iov) {
+        /* Copy across segments; no contiguity needed */
+        size_t off = r->win_base + r->position;
+        if (len > r->iov_end - off) return DCF_SER_ERR_TRUNCATED;
+        reader_iov_copy(r, off, out, len);
+        return reader_iov_seek(r, off + len);
+    }
+    r->mark = r->position;
     READER_ENSURE_BYTES(r, len);
     memcpy(out, r->buffer + r->position, len);
     r->position += len;
@@ -1149,267 +2177,3780 @@ DCFSerError dcf_ser_read_raw(DCFSerReader* r, void* out, size_t len) {
 
 DCFSerError dcf_ser_read_raw_ptr(DCFSerReader* r, const void** out_ptr, size_t len) {
     if (!r || !out_ptr) return DCF_SER_ERR_NULL_PTR;
+    if (r->iov) DCF_SER_CHECK(reader_iov_ensure(r, len));
+    r->mark = r->position;
     READER_ENSURE_BYTES(r, len);
     *out_ptr = r->buffer + r->position;
     r->position += len;
     return DCF_SER_OK;
 }
 
+/* ----------------------------------------------------------------------------
+ * Batch Readers
+ * ---------------------------------------------------------------------------- */
+
+DCFSerError dcf_ser_batch_iter_init(DCFSerBatchIter* it, const DCFSerReader* reader) {
+    if (!it || !reader) return DCF_SER_ERR_NULL_PTR;
+    if (!reader->header_valid || reader->iov) return DCF_SER_ERR_INVALID_ARG;
+    if (reader->header.msg_type != DCF_SER_MSG_BATCH) return DCF_SER_ERR_TYPE_MISMATCH;
+    
+    it->batch = reader;
+    it->position = reader->payload_start;
+    return DCF_SER_OK;
+}
+
+DCFSerError dcf_ser_batch_next(DCFSerBatchIter* it, DCFSerReader* out) {
+    if (!it || !it->batch || !out) return DCF_SER_ERR_NULL_PTR;
+    if (it->position >= it->batch->payload_end) return DCF_SER_ERR_NOT_FOUND;
+    
+    /* Parse the sub-header with a scratch copy so the batch stays untouched */
+    DCFSerReader sub = *it->batch;
+    sub.position = it->position;
+    
+    uint64_t msg_type, sequence, len;
+    DCF_SER_CHECK(reader_get_varint(&sub, &msg_type));
+    DCF_SER_CHECK(reader_get_varint(&sub, &sequence));
+    DCF_SER_CHECK(reader_get_varint(&sub, &len));
+    if (msg_type > UINT16_MAX || sequence > UINT32_MAX) return DCF_SER_ERR_MALFORMED;
+    if (len > sub.payload_end - sub.position) return DCF_SER_ERR_TRUNCATED;
+    
+    sub.header.msg_type = (uint16_t)msg_type;
+    sub.header.sequence = (uint32_t)sequence;
+    sub.header.payload_len = (uint32_t)len;
+    sub.payload_start = sub.position;
+    sub.payload_end = sub.position + (size_t)len;
+    sub.depth = 0;
+    sub.last_error = DCF_SER_OK;
+    
+    it->position = sub.payload_end;
+    *out = sub;
+    return DCF_SER_OK;
+}
+
 /* ============================================================================
- * Utility Functions
+ * Structural Validation
  * ============================================================================ */
 
-const char* dcf_ser_error_str(DCFSerError err) {
-    switch (err) {
-        case DCF_SER_OK:                  return "Success";
-        case DCF_SER_ERR_BUFFER_FULL:     return "Buffer full";
-        case DCF_SER_ERR_ALLOC_FAIL:      return "Allocation failed";
-        case DCF_SER_ERR_TOO_LARGE:       return "Data too large";
-        case DCF_SER_ERR_DEPTH_EXCEEDED:  return "Max nesting depth exceeded";
-        case DCF_SER_ERR_INVALID_MAGIC:   return "Invalid magic number";
-        case DCF_SER_ERR_VERSION_MISMATCH:return "Protocol version mismatch";
-        case DCF_SER_ERR_TRUNCATED:       return "Truncated message";
-        case DCF_SER_ERR_CRC_MISMATCH:    return "CRC checksum mismatch";
-        case DCF_SER_ERR_INVALID_TYPE:    return "Invalid type tag";
-        case DCF_SER_ERR_OVERFLOW:        return "Value overflow";
-        case DCF_SER_ERR_MALFORMED:       return "Malformed data";
-        case DCF_SER_ERR_NULL_PTR:        return "Null pointer";
-        case DCF_SER_ERR_INVALID_ARG:     return "Invalid argument";
-        case DCF_SER_ERR_INTERNAL:        return "Internal error";
-        case DCF_SER_ERR_NOT_FOUND:       return "Not found";
-        case DCF_SER_ERR_TYPE_MISMATCH:   return "Type mismatch";
-        default:                          return "Unknown error";
+/* Open container on the validation stack */
+typedef struct StructFrame {
+    uint64_t remaining;     /* Elements (arrays) or keys + values (maps) left */
+    size_t   entry;         /* Index entry of the container, if indexing */
+    size_t   table;         /* Sorted maps: offset table position; tables: next slot start */
+    size_t   base;          /* Sorted maps: first entry; tables, compact structs: body end */
+    size_t   first;         /* Tables: this table's first entry in the slot start list */
+    size_t   origin;        /* Tables: tag position the slot offsets count from */
+    uint8_t  kind;          /* Container tag */
+    uint8_t  elem;          /* Element type, or map key type */
+    uint8_t  val;           /* Map value type */
+} StructFrame;
+
+static int structure_rel_cmp(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+/* Size of a fixed-width value body; -1 for variable-length or unknown tags */
+static int structure_fixed_size(uint8_t tag) {
+    switch ((DCFSerType)tag) {
+        case DCF_TYPE_NULL:      return 0;
+        case DCF_TYPE_BOOL:
+        case DCF_TYPE_U8:
+        case DCF_TYPE_I8:        return 1;
+        case DCF_TYPE_U16:
+        case DCF_TYPE_I16:       return 2;
+        case DCF_TYPE_U32:
+        case DCF_TYPE_I32:
+        case DCF_TYPE_F32:       return 4;
+        case DCF_TYPE_U64:
+        case DCF_TYPE_I64:
+        case DCF_TYPE_F64:
+        case DCF_TYPE_TIMESTAMP:
+        case DCF_TYPE_DURATION:  return 8;
+        case DCF_TYPE_UUID:      return 16;
+        default:                 return -1;
     }
 }
 
-const char* dcf_ser_type_str(DCFSerType type) {
-    switch (type) {
-        case DCF_TYPE_NULL:       return "null";
-        case DCF_TYPE_BOOL:       return "bool";
-        case DCF_TYPE_U8:         return "u8";
-        case DCF_TYPE_I8:         return "i8";
-        case DCF_TYPE_U16:        return "u16";
-        case DCF_TYPE_I16:        return "i16";
-        case DCF_TYPE_U32:        return "u32";
-        case DCF_TYPE_I32:        return "i32";
-        case DCF_TYPE_U64:        return "u64";
-        case DCF_TYPE_I64:        return "i64";
-        case DCF_TYPE_F32:        return "f32";
-        case DCF_TYPE_F64:        return "f64";
-        case DCF_TYPE_VARINT:     return "varint";
-        case DCF_TYPE_STRING:     return "string";
-        case DCF_TYPE_BYTES:      return "bytes";
-        case DCF_TYPE_UUID:       return "uuid";
-        case DCF_TYPE_ARRAY:      return "array";
-        case DCF_TYPE_MAP:        return "map";
-        case DCF_TYPE_STRUCT:     return "struct";
-        case DCF_TYPE_TUPLE:      return "tuple";
-        case DCF_TYPE_TIMESTAMP:  return "timestamp";
-        case DCF_TYPE_DURATION:   return "duration";
-        case DCF_TYPE_OPTIONAL:   return "optional";
-        case DCF_TYPE_ENUM:       return "enum";
-        case DCF_TYPE_EXTENSION:  return "extension";
-        case DCF_TYPE_INVALID:    return "invalid";
-        default:                  return "unknown";
-    }
+static DCFSerError structure_record(DCFSerIndex* index, const DCFSerReader* r, size_t tag_pos,
+                                    size_t depth, const StructFrame* parent, uint16_t field_id) {
+    if (index->count >= index->capacity) return DCF_SER_ERR_BUFFER_FULL;
+    DCFSerIndexEntry* e = &index->entries[index->count++];
+    e->offset = (uint32_t)(tag_pos - r->payload_start);
+    e->end = (uint32_t)(r->position - r->payload_start);
+    e->parent = parent ? (uint32_t)parent->entry : DCF_SER_INDEX_ROOT;
+    e->field_id = field_id;
+    e->type = r->buffer[tag_pos];
+    e->depth = (uint8_t)depth;
+    return DCF_SER_OK;
 }
 
-size_t dcf_ser_type_size(DCFSerType type) {
-    switch (type) {
-        case DCF_TYPE_NULL:       return 0;
-        case DCF_TYPE_BOOL:
-        case DCF_TYPE_U8:
-        case DCF_TYPE_I8:         return 1;
-        case DCF_TYPE_U16:
-        case DCF_TYPE_I16:        return 2;
-        case DCF_TYPE_U32:
-        case DCF_TYPE_I32:
-        case DCF_TYPE_F32:        return 4;
-        case DCF_TYPE_U64:
-        case DCF_TYPE_I64:
-        case DCF_TYPE_F64:
-        case DCF_TYPE_TIMESTAMP:
-        case DCF_TYPE_DURATION:   return 8;
-        case DCF_TYPE_UUID:       return 16;
-        default:                  return 0;  /* Variable-length */
+/* True if all n tag bytes at the given stride equal elem (branch-free scan) */
+static bool fixed_run_tags_ok(const uint8_t* p, size_t n, size_t stride, uint8_t elem) {
+    uint8_t bad = 0;
+    for (size_t i = 0; i < n; i++) {
+        bad |= p[i * stride] ^ elem;
     }
+    return bad == 0;
 }
 
-DCFSerError dcf_ser_validate_message(const void* data, size_t len) {
-    DCFSerReader reader;
-    DCFSerError err = dcf_ser_reader_init(&reader, data, len);
-    if (err != DCF_SER_OK) return err;
-    return dcf_ser_reader_validate(&reader);
-}
-
-size_t dcf_ser_message_length(const void* header_data) {
-    if (!header_data) return 0;
-    
-    const DCFSerHeader* wire_hdr = (const DCFSerHeader*)header_data;
-    uint32_t payload_len = dcf_ser_ntoh32(wire_hdr->payload_len);
-    uint8_t flags = wire_hdr->flags;
+/*
+ * Check a fixed-width element run in one go: a single bounds check for the
+ * whole array, then a strided scan of the tag bytes. The elements need no
+ * index entries since they sit at a fixed stride after the array header.
+ */
+static DCFSerError structure_fixed_run(DCFSerReader* r, StructFrame* f, int size) {
+    size_t stride = 1 + (size_t)size;
+    if (f->remaining > (r->payload_end - r->position) / stride) return DCF_SER_ERR_TRUNCATED;
     
-    size_t total = sizeof(DCFSerHeader) + payload_len;
-    if (!(flags & DCF_SER_FLAG_NO_CRC)) {
-        total += 4;  /* CRC32 */
+    size_t n = (size_t)f->remaining;
+    if (!fixed_run_tags_ok(r->buffer + r->position, n, stride, f->elem)) {
+        return DCF_SER_ERR_TYPE_MISMATCH;
     }
     
-    return total;
+    r->position += n * stride;
+    f->remaining = 0;
+    return DCF_SER_OK;
 }
 
-/* ============================================================================
- * Schema-Based Serialization
- * ============================================================================ */
-
-DCFSerError dcf_ser_write_struct_schema(DCFSerWriter* w, const void* data,
-                                         const DCFSerSchema* schema) {
-    if (!w || !data || !schema) return DCF_SER_ERR_NULL_PTR;
-    
-    DCF_SER_CHECK(dcf_ser_write_struct_begin(w, schema->type_id));
+/*
+ * Walk every value from the reader's position to the payload end without
+ * recursion. Checks tags, lengths, counts and depth against the reader
+ * limits, and declared element/field types. Open tables keep their slot
+ * offsets sorted in a scratch list so each body value can be matched to a
+ * slot as the walk reaches it.
+ */
+static DCFSerError structure_walk(DCFSerReader* r, DCFSerIndex* index) {
+    StructFrame stack[DCF_SER_MAX_DEPTH];
+    size_t depth = 0;
+    DCFSerError err = DCF_SER_OK;
+    uint32_t* starts = NULL;
+    size_t starts_len = 0, starts_cap = 0;
     
-    for (size_t i = 0; i < schema->field_count; i++) {
-        const DCFSerField* field = &schema->fields[i];
-        const uint8_t* field_data = (const uint8_t*)data + field->offset;
-        
-        /* Write field header */
-        DCF_SER_CHECK(dcf_ser_write_field(w, field->field_id, field->type));
-        
-        /* Write field value based on type */
-        switch (field->type) {
-            case DCF_TYPE_BOOL: {
-                bool val = *(const bool*)field_data;
-                DCF_SER_CHECK(dcf_ser_write_bool(w, val));
-                break;
+    while (err == DCF_SER_OK) {
+        /* Work out which tag the next value must carry, if any */
+        StructFrame* top = depth > 0 ? &stack[depth - 1] : NULL;
+        uint16_t field_id = 0;
+        int expect = -1;
+        if (top && top->kind == DCF_TYPE_STRUCT) {
+            uint8_t field_type;
+            if ((err = reader_get_u16(r, &field_id)) != DCF_SER_OK) break;
+            if ((err = reader_get_u8(r, &field_type)) != DCF_SER_OK) break;
+            if (field_id == 0 && field_type == DCF_TYPE_NULL) {
+                if (index) index->entries[top->entry].end = (uint32_t)(r->position - r->payload_start);
+                depth--;
+                continue;
             }
-            case DCF_TYPE_U8:
-                DCF_SER_CHECK(dcf_ser_write_u8(w, *(const uint8_t*)field_data));
-                break;
-            case DCF_TYPE_I8:
-                DCF_SER_CHECK(dcf_ser_write_i8(w, *(const int8_t*)field_data));
-                break;
-            case DCF_TYPE_U16:
-                DCF_SER_CHECK(dcf_ser_write_u16(w, *(const uint16_t*)field_data));
+            expect = field_type;
+        } else if (top && top->kind == DCF_TYPE_COMPACT_STRUCT) {
+            /* Extensions: varint field id + tagged value, then a 0 id */
+            uint64_t id;
+            if (r->position >= top->base) {
+                err = DCF_SER_ERR_MALFORMED;
                 break;
-            case DCF_TYPE_I16:
-                DCF_SER_CHECK(dcf_ser_write_i16(w, *(const int16_t*)field_data));
-                break;
-            case DCF_TYPE_U32:
-                DCF_SER_CHECK(dcf_ser_write_u32(w, *(const uint32_t*)field_data));
+            }
+            if ((err = reader_get_varint(r, &id)) != DCF_SER_OK) break;
+            if (id == 0) {
+                if (r->position != top->base) {
+                    err = DCF_SER_ERR_MALFORMED;
+                    break;
+                }
+                if (index) index->entries[top->entry].end = (uint32_t)(r->position - r->payload_start);
+                depth--;
+                continue;
+            }
+            if (id > UINT16_MAX) {
+                err = DCF_SER_ERR_MALFORMED;
                 break;
-            case DCF_TYPE_I32:
-                DCF_SER_CHECK(dcf_ser_write_i32(w, *(const int32_t*)field_data));
+            }
+            field_id = (uint16_t)id;
+        } else if (top && top->kind == DCF_TYPE_TABLE) {
+            /* Bodies hold exactly one value per present slot */
+            if (r->position == top->base && top->remaining == 0) {
+                if (index) index->entries[top->entry].end = (uint32_t)(r->position - r->payload_start);
+                starts_len = top->first;
+                depth--;
+                continue;
+            }
+            if (r->position >= top->base || top->remaining == 0) {
+                err = DCF_SER_ERR_MALFORMED;
                 break;
-            case DCF_TYPE_U64:
-                DCF_SER_CHECK(dcf_ser_write_u64(w, *(const uint64_t*)field_data));
+            }
+            /* Values appear in slot offset order: each must start at the next one */
+            if (top->origin + starts[top->table++] != r->position) {
+                err = DCF_SER_ERR_MALFORMED;
                 break;
-            case DCF_TYPE_I64:
-                DCF_SER_CHECK(dcf_ser_write_i64(w, *(const int64_t*)field_data));
+            }
+            top->remaining--;
+        } else if (top) {
+            if (top->remaining == 0) {
+                if (index) index->entries[top->entry].end = (uint32_t)(r->position - r->payload_start);
+                depth--;
+                continue;
+            }
+            if (top->kind == DCF_TYPE_SORTED_MAP && top->remaining % 2 == 0) {
+                /* Each key must start where the offset table says */
+                uint32_t rel;
+                memcpy(&rel, r->buffer + top->table, 4);
+                top->table += 4;
+                if (dcf_ser_ntoh32(rel) != r->position - top->base) {
+                    err = DCF_SER_ERR_MALFORMED;
+                    break;
+                }
+            }
+            if (top->kind != DCF_TYPE_ARRAY) {
+                expect = (top->remaining % 2 == 0) ? top->elem : top->val;
+            } else {
+                expect = top->elem;
+            }
+            top->remaining--;
+        } else if (r->position == r->payload_end) {
+            break;  /* Every top-level value consumed */
+        }
+        
+        size_t tag_pos = r->position;
+        uint8_t tag;
+        if ((err = reader_get_u8(r, &tag)) != DCF_SER_OK) break;
+        if (expect >= 0 && tag != expect) {
+            err = DCF_SER_ERR_TYPE_MISMATCH;
+            break;
+        }
+        
+        switch ((DCFSerType)tag) {
+            case DCF_TYPE_VARINT: {
+                uint64_t v;
+                err = reader_get_varint(r, &v);
                 break;
-            case DCF_TYPE_F32:
-                DCF_SER_CHECK(dcf_ser_write_f32(w, *(const float*)field_data));
+            }
+            case DCF_TYPE_STRING:
+            case DCF_TYPE_BYTES: {
+                uint32_t len;
+                if ((err = reader_get_u32(r, &len)) != DCF_SER_OK) break;
+                if (tag == DCF_TYPE_STRING && len > r->limits.max_string) {
+                    err = DCF_SER_ERR_TOO_LARGE;
+                    break;
+                }
+                err = reader_advance(r, len);
                 break;
-            case DCF_TYPE_F64:
-                DCF_SER_CHECK(dcf_ser_write_f64(w, *(const double*)field_data));
+            }
+            case DCF_TYPE_FIXED: {
+                uint32_t len;
+                if ((err = reader_advance(r, 2)) != DCF_SER_OK) break;  /* type_id */
+                if ((err = reader_get_u32(r, &len)) != DCF_SER_OK) break;
+                err = reader_advance(r, len);
                 break;
-            case DCF_TYPE_STRING:
-                DCF_SER_CHECK(dcf_ser_write_string(w, *(const char**)field_data));
+            }
+            case DCF_TYPE_SCHEMA_REF: {
+                uint32_t len;
+                if ((err = reader_advance(r, 8)) != DCF_SER_OK) break;  /* fingerprint */
+                if ((err = reader_get_u32(r, &len)) != DCF_SER_OK) break;
+                err = reader_advance(r, len);
                 break;
-            case DCF_TYPE_TIMESTAMP:
-                DCF_SER_CHECK(dcf_ser_write_timestamp(w, *(const uint64_t*)field_data));
+            }
+            case DCF_TYPE_ARRAY:
+            case DCF_TYPE_MAP:
+            case DCF_TYPE_SORTED_MAP:
+            case DCF_TYPE_TABLE:
+            case DCF_TYPE_COMPACT_STRUCT:
+            case DCF_TYPE_STRUCT: {
+                if (depth >= r->limits.max_depth) {
+                    err = DCF_SER_ERR_DEPTH_EXCEEDED;
+                    break;
+                }
+                StructFrame* f = &stack[depth];
+                f->kind = tag;
+                f->remaining = 0;
+                if (tag == DCF_TYPE_STRUCT) {
+                    err = reader_advance(r, 2);  /* type_id */
+                } else if (tag == DCF_TYPE_COMPACT_STRUCT) {
+                    /* Schema section is tagless: bounds only */
+                    uint32_t body;
+                    uint64_t known;
+                    if ((err = reader_advance(r, 2)) != DCF_SER_OK) break;  /* type_id */
+                    if ((err = reader_get_u32(r, &body)) != DCF_SER_OK) break;
+                    if (body > r->payload_end - r->position) {
+                        err = DCF_SER_ERR_TRUNCATED;
+                        break;
+                    }
+                    f->base = r->position + body;
+                    if ((err = reader_get_varint(r, &known)) != DCF_SER_OK) break;
+                    if (known > f->base - r->position) {
+                        err = DCF_SER_ERR_MALFORMED;
+                        break;
+                    }
+                    r->position += known;
+                } else if (tag == DCF_TYPE_TABLE) {
+                    uint16_t slots;
+                    uint32_t body;
+                    if ((err = reader_advance(r, 2)) != DCF_SER_OK) break;  /* type_id */
+                    if ((err = reader_get_u16(r, &slots)) != DCF_SER_OK) break;
+                    if ((err = reader_get_u32(r, &body)) != DCF_SER_OK) break;
+                    size_t table = r->position;
+                    if ((err = reader_advance(r, (size_t)slots * 4)) != DCF_SER_OK) break;
+                    if (body > r->payload_end - r->position) {
+                        err = DCF_SER_ERR_TRUNCATED;
+                        break;
+                    }
+                    f->base = r->position + body;
+                    if (starts_cap - starts_len < slots) {
+                        size_t cap = (starts_len + slots) * 2;
+                        uint32_t* grown = realloc(starts, cap * sizeof(*starts));
+                        if (!grown) {
+                            err = DCF_SER_ERR_ALLOC_FAIL;
+                            break;
+                        }
+                        starts = grown;
+                        starts_cap = cap;
+                    }
+                    f->first = starts_len;
+                    f->origin = tag_pos;
+                    for (size_t i = 0; i < slots && err == DCF_SER_OK; i++) {
+                        uint32_t rel;
+                        memcpy(&rel, r->buffer + table + i * 4, 4);
+                        rel = dcf_ser_ntoh32(rel);
+                        if (rel == 0) continue;
+                        if (tag_pos + rel < r->position || tag_pos + rel >= f->base) {
+                            err = DCF_SER_ERR_MALFORMED;
+                        }
+                        starts[starts_len++] = rel;
+                        f->remaining++;
+                    }
+                    qsort(starts + f->first, (size_t)f->remaining, sizeof(*starts), structure_rel_cmp);
+                    f->table = f->first;
+                } else {
+                    uint32_t count;
+                    if ((err = reader_get_u8(r, &f->elem)) != DCF_SER_OK) break;
+                    if (tag != DCF_TYPE_ARRAY && (err = reader_get_u8(r, &f->val)) != DCF_SER_OK) break;
+                    if ((err = reader_get_u32(r, &count)) != DCF_SER_OK) break;
+                    if (count > r->limits.max_array) {
+                        err = DCF_SER_ERR_TOO_LARGE;
+                        break;
+                    }
+                    f->remaining = (tag != DCF_TYPE_ARRAY) ? (uint64_t)count * 2 : count;
+                    if (tag == DCF_TYPE_SORTED_MAP) {
+                        f->table = r->position;
+                        if ((err = reader_advance(r, (size_t)count * 4)) != DCF_SER_OK) break;
+                        f->base = r->position;
+                    }
+                }
+                if (err != DCF_SER_OK) break;
+                if (index) {
+                    f->entry = index->count;
+                    err = structure_record(index, r, tag_pos, depth, top, field_id);
+                    if (err != DCF_SER_OK) break;
+                }
+                if (tag == DCF_TYPE_ARRAY && structure_fixed_size(f->elem) >= 0) {
+                    err = structure_fixed_run(r, f, structure_fixed_size(f->elem));
+                    if (err != DCF_SER_OK) break;
+                }
+                depth++;
+                continue;  /* Containers are recorded on entry */
+            }
+            default: {
+                int size = structure_fixed_size(tag);
+                if (size < 0) {
+                    err = DCF_SER_ERR_INVALID_TYPE;
+                    break;
+                }
+                err = reader_advance(r, (size_t)size);
                 break;
-            default:
-                return DCF_SER_ERR_INVALID_TYPE;
+            }
+        }
+        
+        if (err == DCF_SER_OK && index) {
+            err = structure_record(index, r, tag_pos, depth, top, field_id);
         }
     }
     
-    DCF_SER_CHECK(dcf_ser_write_struct_end(w));
-    return DCF_SER_OK;
+    free(starts);
+    return err;
 }
 
-DCFSerError dcf_ser_read_struct_schema(DCFSerReader* r, void* data,
-                                        const DCFSerSchema* schema) {
-    if (!r || !data || !schema) return DCF_SER_ERR_NULL_PTR;
+DCFSerError dcf_ser_reader_trust(DCFSerReader* reader) {
+    if (!reader) return DCF_SER_ERR_NULL_PTR;
+    if (!reader->header_valid || reader->iov || reader->incremental) {
+        return DCF_SER_ERR_INVALID_ARG;
+    }
     
-    uint16_t type_id;
-    DCF_SER_CHECK(dcf_ser_read_struct_begin(r, &type_id));
+    /* Walk a copy so the reader itself stays at its current value */
+    DCFSerReader r = *reader;
+    DCFSerError err = structure_walk(&r, NULL);
+    if (err != DCF_SER_OK) {
+        reader->last_error = err;
+        return err;
+    }
     
-    if (type_id != schema->type_id) {
-        return DCF_SER_ERR_TYPE_MISMATCH;
+    reader->trusted = true;
+    return DCF_SER_OK;
+}
+
+DCFSerError dcf_ser_validate_structure(const void* data, size_t len, DCFSerIndex* index) {
+    DCFSerReader reader;
+    DCF_SER_CHECK(dcf_ser_reader_init(&reader, data, len));
+    DCF_SER_CHECK(dcf_ser_reader_validate(&reader));
+    
+    if (index) {
+        if (!index->entries && index->capacity > 0) return DCF_SER_ERR_NULL_PTR;
+        if (reader.payload_end - reader.payload_start > UINT32_MAX) return DCF_SER_ERR_TOO_LARGE;
+        index->count = 0;
+        index->payload = reader.buffer + reader.payload_start;
     }
     
-    /* Clear the struct first */
-    memset(data, 0, schema->struct_size);
+    reader.position = reader.payload_start;
+    return structure_walk(&reader, index);
+}
+
+/* ============================================================================
+ * Array Offset Index
+ * ============================================================================ */
+
+DCFSerError dcf_ser_array_index_build(DCFSerReader* r, DCFSerArrayIndex* idx) {
+    if (!r || !idx) return DCF_SER_ERR_NULL_PTR;
+    if (!idx->offsets && idx->capacity > 0) return DCF_SER_ERR_NULL_PTR;
+    if (r->iov || r->incremental) return DCF_SER_ERR_INVALID_ARG;
     
-    /* Read fields until end marker */
-    while (true) {
-        uint16_t field_id;
-        DCFSerType field_type;
-        DCFSerError err = dcf_ser_read_field(r, &field_id, &field_type);
-        
-        if (err == DCF_SER_ERR_NOT_FOUND) break;  /* End of struct */
-        if (err != DCF_SER_OK) return err;
-        
-        /* Find field in schema */
-        const DCFSerField* field = NULL;
-        for (size_t i = 0; i < schema->field_count; i++) {
-            if (schema->fields[i].field_id == field_id) {
-                field = &schema->fields[i];
-                break;
-            }
+    DCFSerReader scan = *r;
+    DCFSerType elem_type;
+    size_t count;
+    DCF_SER_CHECK(dcf_ser_read_array_begin(&scan, &elem_type, &count));
+    
+    /* Stride 0: the smallest stride whose offsets fit the caller's storage */
+    size_t stride = idx->stride;
+    if (stride == 0) {
+        if (idx->capacity == 0) return DCF_SER_ERR_BUFFER_FULL;
+        stride = (count + idx->capacity - 1) / idx->capacity;
+        if (stride == 0) stride = 1;
+    }
+    if ((count + stride - 1) / stride > idx->capacity) return DCF_SER_ERR_BUFFER_FULL;
+    
+    size_t n = 0;
+    size_t fixed = dcf_ser_type_size(elem_type);
+    if (fixed > 0 || elem_type == DCF_TYPE_NULL) {
+        /* Fixed-width elements: offsets are arithmetic */
+        size_t step = 1 + fixed;
+        if (count > (scan.payload_end - scan.position) / step) return DCF_SER_ERR_TRUNCATED;
+        if (!fixed_run_tags_ok(scan.buffer + scan.position, count, step, elem_type)) {
+            return DCF_SER_ERR_TYPE_MISMATCH;
         }
-        
-        if (!field) {
-            /* Unknown field, skip it */
-            DCF_SER_CHECK(dcf_ser_reader_skip(r));
-            continue;
+        for (size_t i = 0; i < count; i += stride) {
+            idx->offsets[n++] = scan.position + i * step;
         }
+        scan.position += count * step;
+    } else {
+        for (size_t i = 0; i < count; i++) {
+            if (i % stride == 0) idx->offsets[n++] = scan.position;
+            DCF_SER_CHECK(reader_skip_value(&scan));
+        }
+    }
+    
+    idx->count = n;
+    idx->stride = stride;
+    idx->elements = count;
+    idx->end = scan.position;
+    idx->elem_type = elem_type;
+    
+    scan.depth--;
+    *r = scan;
+    return DCF_SER_OK;
+}
+
+DCFSerError dcf_ser_array_index_seek(const DCFSerReader* r, const DCFSerArrayIndex* idx,
+                                     size_t element, DCFSerReader* out) {
+    if (!r || !idx || !out) return DCF_SER_ERR_NULL_PTR;
+    if (element > idx->elements || idx->stride == 0) return DCF_SER_ERR_INVALID_ARG;
+    
+    *out = *r;
+    out->payload_end = idx->end;   /* Reads past the array fail as truncated */
+    out->depth = r->depth + 1;
+    if (element == idx->elements) {
+        out->position = idx->end;
+        return DCF_SER_OK;
+    }
+    
+    out->position = idx->offsets[element / idx->stride];
+    for (size_t i = element % idx->stride; i > 0; i--) {
+        DCF_SER_CHECK(reader_skip_value(out));
+    }
+    return DCF_SER_OK;
+}
+
+/* One worker's share of a parallel array decode */
+typedef struct ArrayTask {
+    DCFSerReader    reader;
+    size_t          first;
+    size_t          count;
+    DCFSerElementFn fn;
+    void*           ctx;
+    DCFSerError     result;
+} ArrayTask;
+
+static void array_task_run(ArrayTask* t) {
+    t->result = t->fn(t->ctx, &t->reader, t->first, t->count);
+}
+
+#ifdef DCF_SER_PLATFORM_POSIX
+static void* array_task_thread(void* arg) {
+    array_task_run((ArrayTask*)arg);
+    return NULL;
+}
+#endif
+
+DCFSerError dcf_ser_array_decode_parallel(const DCFSerReader* r, const DCFSerArrayIndex* idx,
+                                          unsigned threads, DCFSerElementFn fn, void* ctx) {
+    if (!r || !idx || !fn) return DCF_SER_ERR_NULL_PTR;
+    if (idx->stride == 0) return DCF_SER_ERR_INVALID_ARG;
+    if (threads == 0) threads = 1;
+    if (threads > DCF_SER_MAX_THREADS) threads = DCF_SER_MAX_THREADS;
+    
+    /* Ranges start on indexed elements so no worker has to skip */
+    size_t blocks = (idx->elements + idx->stride - 1) / idx->stride;
+    if (threads > blocks) threads = blocks ? (unsigned)blocks : 1;
+    
+    ArrayTask tasks[DCF_SER_MAX_THREADS];
+    size_t next = 0;
+    for (unsigned i = 0; i < threads; i++) {
+        size_t share = blocks / threads + (i < blocks % threads ? 1 : 0);
+        size_t last = next + share * idx->stride;
+        if (last > idx->elements) last = idx->elements;
         
-        uint8_t* field_data = (uint8_t*)data + field->offset;
-        
-        /* Read field value based on type */
-        switch (field->type) {
-            case DCF_TYPE_BOOL:
-                DCF_SER_CHECK(dcf_ser_read_bool(r, (bool*)field_data));
-                break;
-            case DCF_TYPE_U8:
-                DCF_SER_CHECK(dcf_ser_read_u8(r, (uint8_t*)field_data));
-                break;
-            case DCF_TYPE_I8:
-                DCF_SER_CHECK(dcf_ser_read_i8(r, (int8_t*)field_data));
-                break;
-            case DCF_TYPE_U16:
-                DCF_SER_CHECK(dcf_ser_read_u16(r, (uint16_t*)field_data));
-                break;
-            case DCF_TYPE_I16:
-                DCF_SER_CHECK(dcf_ser_read_i16(r, (int16_t*)field_data));
-                break;
-            case DCF_TYPE_U32:
-                DCF_SER_CHECK(dcf_ser_read_u32(r, (uint32_t*)field_data));
-                break;
-            case DCF_TYPE_I32:
-                DCF_SER_CHECK(dcf_ser_read_i32(r, (int32_t*)field_data));
-                break;
-            case DCF_TYPE_U64:
-                DCF_SER_CHECK(dcf_ser_read_u64(r, (uint64_t*)field_data));
-                break;
-            case DCF_TYPE_I64:
-                DCF_SER_CHECK(dcf_ser_read_i64(r, (int64_t*)field_data));
-                break;
-            case DCF_TYPE_F32:
-                DCF_SER_CHECK(dcf_ser_read_f32(r, (float*)field_data));
-                break;
-            case DCF_TYPE_F64:
-                DCF_SER_CHECK(dcf_ser_read_f64(r, (double*)field_data));
-                break;
-            case DCF_TYPE_TIMESTAMP:
-                DCF_SER_CHECK(dcf_ser_read_timestamp(r, (uint64_t*)field_data));
-                break;
-            default:
-                DCF_SER_CHECK(dcf_ser_reader_skip(r));
-                break;
+        ArrayTask* t = &tasks[i];
+        DCF_SER_CHECK(dcf_ser_array_index_seek(r, idx, next, &t->reader));
+        t->first = next;
+        t->count = last - next;
+        t->fn = fn;
+        t->ctx = ctx;
+        t->result = DCF_SER_OK;
+        next = last;
+    }
+    
+#ifdef DCF_SER_PLATFORM_POSIX
+    pthread_t tids[DCF_SER_MAX_THREADS];
+    bool started[DCF_SER_MAX_THREADS] = { false };
+    for (unsigned i = 1; i < threads; i++) {
+        started[i] = pthread_create(&tids[i], NULL, array_task_thread, &tasks[i]) == 0;
+    }
+    array_task_run(&tasks[0]);
+    for (unsigned i = 1; i < threads; i++) {
+        if (started[i]) {
+            pthread_join(tids[i], NULL);
+        } else {
+            array_task_run(&tasks[i]);  /* No thread available: run inline */
         }
     }
+#else
+    for (unsigned i = 0; i < threads; i++) array_task_run(&tasks[i]);
+#endif
     
-    DCF_SER_CHECK(dcf_ser_read_struct_end(r));
+    for (unsigned i = 0; i < threads; i++) {
+        if (tasks[i].result != DCF_SER_OK) return tasks[i].result;
+    }
+    return DCF_SER_OK;
+}
+
+/* ============================================================================
+ * Sorted Maps
+ * ============================================================================ */
+
+static bool sorted_key_type_ok(uint8_t type) {
+    switch ((DCFSerType)type) {
+        case DCF_TYPE_U8:  case DCF_TYPE_I8:
+        case DCF_TYPE_U16: case DCF_TYPE_I16:
+        case DCF_TYPE_U32: case DCF_TYPE_I32:
+        case DCF_TYPE_U64: case DCF_TYPE_I64:
+        case DCF_TYPE_VARINT:
+        case DCF_TYPE_STRING:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/* Map an integer key to a value whose unsigned order is the key order */
+static uint64_t sorted_key_norm(uint8_t type, uint64_t bits) {
+    switch ((DCFSerType)type) {
+        case DCF_TYPE_I8:  return (uint64_t)(int64_t)(int8_t)bits ^ (1ULL << 63);
+        case DCF_TYPE_I16: return (uint64_t)(int64_t)(int16_t)bits ^ (1ULL << 63);
+        case DCF_TYPE_I32: return (uint64_t)(int64_t)(int32_t)bits ^ (1ULL << 63);
+        case DCF_TYPE_I64: return bits ^ (1ULL << 63);
+        default:           return bits;
+    }
+}
+
+/* True if ikey is a value of the integer key type (64-bit types take any) */
+static bool sorted_key_fits(uint8_t type, int64_t ikey) {
+    switch ((DCFSerType)type) {
+        case DCF_TYPE_U8:  return ikey >= 0 && ikey <= UINT8_MAX;
+        case DCF_TYPE_U16: return ikey >= 0 && ikey <= UINT16_MAX;
+        case DCF_TYPE_U32: return ikey >= 0 && ikey <= UINT32_MAX;
+        case DCF_TYPE_I8:  return ikey >= INT8_MIN && ikey <= INT8_MAX;
+        case DCF_TYPE_I16: return ikey >= INT16_MIN && ikey <= INT16_MAX;
+        case DCF_TYPE_I32: return ikey >= INT32_MIN && ikey <= INT32_MAX;
+        default:           return true;
+    }
+}
+
+/* Sort key of one entry */
+typedef struct SortedKey {
+    uint64_t       norm;    /* Normalized integer key */
+    const uint8_t* str;     /* String key bytes */
+    uint32_t       len;     /* String key length */
+} SortedKey;
+
+/* Read the tagged key at r's position */
+static DCFSerError sorted_key_read(DCFSerReader* r, uint8_t key_type, SortedKey* out) {
+    uint8_t tag;
+    DCF_SER_CHECK(reader_get_u8(r, &tag));
+    if (tag != key_type) return DCF_SER_ERR_TYPE_MISMATCH;
+    
+    out->str = NULL;
+    out->len = 0;
+    uint64_t bits = 0;
+    switch ((DCFSerType)tag) {
+        case DCF_TYPE_U8: case DCF_TYPE_I8: {
+            uint8_t v;
+            DCF_SER_CHECK(reader_get_u8(r, &v));
+            bits = v;
+            break;
+        }
+        case DCF_TYPE_U16: case DCF_TYPE_I16: {
+            uint16_t v;
+            DCF_SER_CHECK(reader_get_u16(r, &v));
+            bits = v;
+            break;
+        }
+        case DCF_TYPE_U32: case DCF_TYPE_I32: {
+            uint32_t v;
+            DCF_SER_CHECK(reader_get_u32(r, &v));
+            bits = v;
+            break;
+        }
+        case DCF_TYPE_U64: case DCF_TYPE_I64:
+            DCF_SER_CHECK(reader_get_u64(r, &bits));
+            break;
+        case DCF_TYPE_VARINT:
+            DCF_SER_CHECK(reader_get_varint(r, &bits));
+            break;
+        case DCF_TYPE_STRING:
+            DCF_SER_CHECK(reader_get_u32(r, &out->len));
+            READER_ENSURE_BYTES(r, out->len);
+            out->str = r->buffer + r->position;
+            r->position += out->len;
+            break;
+        default:
+            return DCF_SER_ERR_INVALID_TYPE;
+    }
+    
+    out->norm = sorted_key_norm(tag, bits);
+    return DCF_SER_OK;
+}
+
+static int sorted_key_cmp(const SortedKey* a, const SortedKey* b) {
+    if (a->str || b->str) {
+        size_t n = a->len < b->len ? a->len : b->len;
+        int c = n ? memcmp(a->str, b->str, n) : 0;
+        if (c != 0) return c;
+        return (a->len > b->len) - (a->len < b->len);
+    }
+    return (a->norm > b->norm) - (a->norm < b->norm);
+}
+
+/* Entry being sorted by dcf_ser_write_sorted_map_end */
+typedef struct SortedEntry {
+    SortedKey key;
+    size_t    start;        /* Buffer offset of the key tag */
+    size_t    len;          /* Key + value bytes */
+} SortedEntry;
+
+/* Bottom-up merge sort (stable, no recursion, no comparator context) */
+static void sorted_entries_sort(SortedEntry* a, SortedEntry* tmp, size_t n) {
+    for (size_t width = 1; width < n; width *= 2) {
+        for (size_t lo = 0; lo < n; lo += 2 * width) {
+            size_t mid = lo + width < n ? lo + width : n;
+            size_t hi = lo + 2 * width < n ? lo + 2 * width : n;
+            size_t i = lo, j = mid, k = lo;
+            while (i < mid && j < hi) {
+                tmp[k++] = sorted_key_cmp(&a[j].key, &a[i].key) < 0 ? a[j++] : a[i++];
+            }
+            while (i < mid) tmp[k++] = a[i++];
+            while (j < hi) tmp[k++] = a[j++];
+        }
+        memcpy(a, tmp, n * sizeof(SortedEntry));
+    }
+}
+
+/* Allocate the held-container stack on first use */
+static DCFSerError writer_hold_ensure(DCFSerWriter* w) {
+    if (w->held) return DCF_SER_OK;
+    w->held = (DCFSerHeldFrame*)malloc(DCF_SER_MAX_DEPTH * sizeof(DCFSerHeldFrame));
+    if (!w->held) {
+        w->last_error = DCF_SER_ERR_ALLOC_FAIL;
+        return DCF_SER_ERR_ALLOC_FAIL;
+    }
+    return DCF_SER_OK;
+}
+
+/*
+ * Reserve a zeroed table of `count` u32 slots and open a held container.
+ * Sink flushing stops until it is closed, since the container is patched
+ * (or reordered) in place.
+ */
+static DCFSerError writer_hold_push(DCFSerWriter* w, uint8_t kind, size_t start, size_t count,
+                                    DCFSerHeldFrame** out) {
+    WRITER_ENSURE_SPACE(w, count * 4);
+    DCFSerHeldFrame* f = &w->held[w->held_depth++];
+    f->start = start;
+    f->table = w->position;
+    f->count = (uint32_t)count;
+    f->kind = kind;
+    f->key_type = 0;
+    memset(w->buffer + w->position, 0, count * 4);
+    w->position += count * 4;
+    w->depth++;
+    f->mark = w->position;
+    f->depth = (uint32_t)w->depth;
+    f->pending = false;
+    *out = f;
+    return DCF_SER_OK;
+}
+
+DCFSerError dcf_ser_write_sorted_map_begin(DCFSerWriter* w, DCFSerType key_type,
+                                           DCFSerType val_type, size_t count) {
+    if (!w) return DCF_SER_ERR_NULL_PTR;
+    if (!sorted_key_type_ok(key_type)) return DCF_SER_ERR_INVALID_ARG;
+    if (count > w->limits.max_array) return DCF_SER_ERR_TOO_LARGE;
+    if (w->depth >= w->limits.max_depth) return DCF_SER_ERR_DEPTH_EXCEEDED;
+    
+    DCF_SER_CHECK(writer_hold_ensure(w));
+    
+    WRITER_ENSURE_SPACE(w, 7 + count * 4);
+    size_t start = w->position;
+    DCF_SER_CHECK(writer_put_u8(w, DCF_TYPE_SORTED_MAP));
+    DCF_SER_CHECK(writer_put_u8(w, (uint8_t)key_type));
+    DCF_SER_CHECK(writer_put_u8(w, (uint8_t)val_type));
+    DCF_SER_CHECK(writer_put_u32(w, (uint32_t)count));
+    
+    /* The entries are reordered in place at the end */
+    DCFSerHeldFrame* f;
+    DCF_SER_CHECK(writer_hold_push(w, DCF_TYPE_SORTED_MAP, start, count, &f));
+    f->key_type = (uint8_t)key_type;
+    return DCF_SER_OK;
+}
+
+DCFSerError dcf_ser_write_sorted_map_end(DCFSerWriter* w) {
+    if (!w) return DCF_SER_ERR_NULL_PTR;
+    if (w->depth == 0 || w->held_depth == 0 || w->held[w->held_depth - 1].kind != DCF_TYPE_SORTED_MAP) {
+        return DCF_SER_ERR_MALFORMED;
+    }
+    
+    DCFSerHeldFrame f = w->held[--w->held_depth];
+    w->depth--;
+    size_t base = f.table + (size_t)f.count * 4;
+    if (w->position - base > UINT32_MAX) return DCF_SER_ERR_TOO_LARGE;
+    
+    /* Walk what the caller wrote: count key/value pairs, nothing more */
+    DCFSerReader scan;
+    memset(&scan, 0, sizeof(scan));
+    scan.buffer = w->buffer;
+    scan.length = w->position;
+    scan.payload_end = w->position;
+    scan.position = base;
+    scan.limits = w->limits;
+    
+    SortedEntry* entries = NULL;
+    uint8_t* area = NULL;
+    DCFSerError err = DCF_SER_OK;
+    if (f.count > 0) {
+        entries = (SortedEntry*)malloc((size_t)f.count * 2 * sizeof(SortedEntry));
+        area = (uint8_t*)malloc(w->position - base);
+        if (!entries || !area) err = DCF_SER_ERR_ALLOC_FAIL;
+    }
+    
+    for (uint32_t i = 0; i < f.count && err == DCF_SER_OK; i++) {
+        entries[i].start = scan.position;
+        err = sorted_key_read(&scan, f.key_type, &entries[i].key);
+        if (err == DCF_SER_OK) err = reader_skip_value(&scan);
+        entries[i].len = scan.position - entries[i].start;
+    }
+    if (err == DCF_SER_ERR_TRUNCATED || (err == DCF_SER_OK && scan.position != w->position)) {
+        err = DCF_SER_ERR_MALFORMED;  /* Entry count does not match */
+    }
+    
+    if (err == DCF_SER_OK && f.count > 0) {
+        sorted_entries_sort(entries, entries + f.count, f.count);
+        
+        /* Keys now point into the buffer being rewritten: check duplicates first */
+        for (uint32_t i = 1; i < f.count; i++) {
+            if (sorted_key_cmp(&entries[i - 1].key, &entries[i].key) == 0) {
+                err = DCF_SER_ERR_INVALID_ARG;  /* Duplicate key */
+                break;
+            }
+        }
+    }
+    
+    if (err == DCF_SER_OK && f.count > 0) {
+        memcpy(area, w->buffer + base, w->position - base);
+        size_t out = base;
+        for (uint32_t i = 0; i < f.count; i++) {
+            uint32_t rel = dcf_ser_hton32((uint32_t)(out - base));
+            memcpy(w->buffer + f.table + (size_t)i * 4, &rel, 4);
+            memcpy(w->buffer + out, area + (entries[i].start - base), entries[i].len);
+            out += entries[i].len;
+        }
+    }
+    
+    free(entries);
+    free(area);
+    if (err != DCF_SER_OK) w->last_error = err;
+    return err;
+}
+
+/* Binary search a sorted map at r's position for key */
+static DCFSerError sorted_map_find(const DCFSerReader* r, bool want_string, const SortedKey* key,
+                                   int64_t ikey, DCFSerReader* out_value) {
+    if (!r || !out_value) return DCF_SER_ERR_NULL_PTR;
+    if (r->iov || r->incremental) return DCF_SER_ERR_INVALID_ARG;
+    
+    DCFSerReader m = *r;
+    uint8_t tag, key_type, val_type;
+    uint32_t count;
+    DCF_SER_CHECK(reader_get_u8(&m, &tag));
+    if (tag != DCF_TYPE_SORTED_MAP) return DCF_SER_ERR_TYPE_MISMATCH;
+    DCF_SER_CHECK(reader_get_u8(&m, &key_type));
+    DCF_SER_CHECK(reader_get_u8(&m, &val_type));
+    DCF_SER_CHECK(reader_get_u32(&m, &count));
+    if ((key_type == DCF_TYPE_STRING) != want_string) return DCF_SER_ERR_TYPE_MISMATCH;
+    READER_ENSURE_BYTES(&m, (size_t)count * 4);
+    if (!want_string && !sorted_key_fits(key_type, ikey)) return DCF_SER_ERR_NOT_FOUND;
+    
+    SortedKey want = want_string ? *key : (SortedKey){ sorted_key_norm(key_type, (uint64_t)ikey), NULL, 0 };
+    const uint8_t* table = m.buffer + m.position;
+    size_t base = m.position + (size_t)count * 4;
+    
+    size_t lo = 0, hi = count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        uint32_t rel;
+        memcpy(&rel, table + mid * 4, 4);
+        rel = dcf_ser_ntoh32(rel);
+        if (rel >= m.payload_end - base) return DCF_SER_ERR_MALFORMED;
+        
+        DCFSerReader e = m;
+        e.position = base + rel;
+        SortedKey k;
+        DCF_SER_CHECK(sorted_key_read(&e, key_type, &k));
+        int c = sorted_key_cmp(&k, &want);
+        if (c == 0) {
+            *out_value = e;
+            out_value->depth = r->depth + 1;
+            out_value->mark = e.position;
+            return DCF_SER_OK;
+        }
+        if (c < 0) lo = mid + 1; else hi = mid;
+    }
+    return DCF_SER_ERR_NOT_FOUND;
+}
+
+DCFSerError dcf_ser_map_find(const DCFSerReader* r, const char* key, size_t key_len,
+                             DCFSerReader* out_value) {
+    if (!key && key_len > 0) return DCF_SER_ERR_NULL_PTR;
+    if (key_len > UINT32_MAX) return DCF_SER_ERR_NOT_FOUND;
+    SortedKey k = { 0, (const uint8_t*)(key ? key : ""), (uint32_t)key_len };
+    return sorted_map_find(r, true, &k, 0, out_value);
+}
+
+DCFSerError dcf_ser_map_find_int(const DCFSerReader* r, int64_t key, DCFSerReader* out_value) {
+    return sorted_map_find(r, false, NULL, key, out_value);
+}
+
+/* ============================================================================
+ * Tables
+ * ============================================================================ */
+
+#define TABLE_HEADER_SIZE 9   /* tag, type_id u16, slot count u16, body length u32 */
+
+DCFSerError dcf_ser_write_table_begin(DCFSerWriter* w, uint16_t type_id, uint16_t max_field_id) {
+    if (!w) return DCF_SER_ERR_NULL_PTR;
+    if (w->depth >= w->limits.max_depth) return DCF_SER_ERR_DEPTH_EXCEEDED;
+    DCF_SER_CHECK(writer_hold_ensure(w));
+    
+    /* Make room first so a sink flush cannot move the table start */
+    WRITER_ENSURE_SPACE(w, TABLE_HEADER_SIZE + (size_t)max_field_id * 4);
+    size_t start = w->position;
+    DCF_SER_CHECK(writer_put_u8(w, DCF_TYPE_TABLE));
+    DCF_SER_CHECK(writer_put_u16(w, type_id));
+    DCF_SER_CHECK(writer_put_u16(w, max_field_id));
+    DCF_SER_CHECK(writer_put_u32(w, 0));   /* Body length, patched at the end */
+    
+    DCFSerHeldFrame* f;
+    return writer_hold_push(w, DCF_TYPE_TABLE, start, max_field_id, &f);
+}
+
+/* The body so far must hold exactly a value for each field, all closed */
+static DCFSerError table_body_complete(const DCFSerWriter* w, const DCFSerHeldFrame* f) {
+    if (w->depth != f->depth) return DCF_SER_ERR_MALFORMED;
+    if (f->pending ? w->position == f->mark : w->position != f->mark) {
+        return DCF_SER_ERR_MALFORMED;
+    }
+    return DCF_SER_OK;
+}
+
+DCFSerError dcf_ser_write_table_field(DCFSerWriter* w, uint16_t field_id) {
+    if (!w) return DCF_SER_ERR_NULL_PTR;
+    if (w->held_depth == 0 || w->held[w->held_depth - 1].kind != DCF_TYPE_TABLE) {
+        return DCF_SER_ERR_MALFORMED;
+    }
+    
+    DCFSerHeldFrame* f = &w->held[w->held_depth - 1];
+    DCF_SER_CHECK(table_body_complete(w, f));
+    if (field_id == 0 || field_id > f->count) return DCF_SER_ERR_INVALID_ARG;
+    if (w->position - f->start > UINT32_MAX) return DCF_SER_ERR_TOO_LARGE;
+    
+    uint8_t* slot = w->buffer + f->table + (size_t)(field_id - 1) * 4;
+    uint32_t rel;
+    memcpy(&rel, slot, 4);
+    if (rel != 0) return DCF_SER_ERR_INVALID_ARG;   /* Field written twice */
+    
+    rel = dcf_ser_hton32((uint32_t)(w->position - f->start));
+    memcpy(slot, &rel, 4);
+    f->mark = w->position;
+    f->pending = true;
+    return DCF_SER_OK;
+}
+
+DCFSerError dcf_ser_write_table_end(DCFSerWriter* w) {
+    if (!w) return DCF_SER_ERR_NULL_PTR;
+    if (w->depth == 0 || w->held_depth == 0 || w->held[w->held_depth - 1].kind != DCF_TYPE_TABLE) {
+        return DCF_SER_ERR_MALFORMED;
+    }
+    DCF_SER_CHECK(table_body_complete(w, &w->held[w->held_depth - 1]));
+    
+    DCFSerHeldFrame f = w->held[--w->held_depth];
+    w->depth--;
+    size_t body = w->position - (f.table + (size_t)f.count * 4);
+    if (body > UINT32_MAX) return DCF_SER_ERR_TOO_LARGE;
+    
+    uint32_t net = dcf_ser_hton32((uint32_t)body);
+    memcpy(w->buffer + f.start + 5, &net, 4);
+    return DCF_SER_OK;
+}
+
+DCFSerError dcf_ser_table_info(const DCFSerReader* r, uint16_t* out_type_id, uint16_t* out_max_field_id) {
+    if (!r || !out_type_id || !out_max_field_id) return DCF_SER_ERR_NULL_PTR;
+    if (r->iov || r->incremental) return DCF_SER_ERR_INVALID_ARG;
+    
+    DCFSerReader t = *r;
+    uint8_t tag;
+    DCF_SER_CHECK(reader_get_u8(&t, &tag));
+    if (tag != DCF_TYPE_TABLE) return DCF_SER_ERR_TYPE_MISMATCH;
+    DCF_SER_CHECK(reader_get_u16(&t, out_type_id));
+    return reader_get_u16(&t, out_max_field_id);
+}
+
+DCFSerError dcf_ser_table_field(const DCFSerReader* r, uint16_t field_id, DCFSerReader* out_value) {
+    if (!r || !out_value) return DCF_SER_ERR_NULL_PTR;
+    if (r->iov || r->incremental) return DCF_SER_ERR_INVALID_ARG;
+    
+    DCFSerReader t = *r;
+    uint8_t tag;
+    uint16_t type_id, slots;
+    uint32_t body;
+    DCF_SER_CHECK(reader_get_u8(&t, &tag));
+    if (tag != DCF_TYPE_TABLE) return DCF_SER_ERR_TYPE_MISMATCH;
+    DCF_SER_CHECK(reader_get_u16(&t, &type_id));
+    DCF_SER_CHECK(reader_get_u16(&t, &slots));
+    DCF_SER_CHECK(reader_get_u32(&t, &body));
+    if (field_id == 0 || field_id > slots) return DCF_SER_ERR_NOT_FOUND;
+    
+    size_t values = t.position + (size_t)slots * 4;
+    READER_ENSURE_BYTES(&t, (size_t)slots * 4 + body);
+    
+    uint32_t rel;
+    memcpy(&rel, t.buffer + t.position + (size_t)(field_id - 1) * 4, 4);
+    rel = dcf_ser_ntoh32(rel);
+    if (rel == 0) return DCF_SER_ERR_NOT_FOUND;
+    
+    /* The value must start inside the body; the reader ends with it */
+    size_t at = r->position + rel;
+    if (at < values || at >= values + body) return DCF_SER_ERR_MALFORMED;
+    
+    *out_value = t;
+    out_value->position = at;
+    out_value->mark = at;
+    out_value->payload_end = values + body;
+    out_value->depth = r->depth + 1;
+    return DCF_SER_OK;
+}
+
+/* ============================================================================
+ * Stream Reassembly
+ * ============================================================================ */
+
+DCFSerError dcf_ser_reassembler_init(DCFSerReassembler* ra, const DCFSerReassemblerOptions* opts) {
+    if (!ra) return DCF_SER_ERR_NULL_PTR;
+    
+    DCFSerReassemblerOptions defaults = {0};
+    if (!opts) opts = &defaults;
+    
+    memset(ra, 0, sizeof(DCFSerReassembler));
+    ra->max_streams = opts->max_streams ? opts->max_streams : DCF_SER_REASM_STREAMS;
+    ra->max_stream_bytes = opts->max_stream_bytes ? opts->max_stream_bytes : DCF_SER_MAX_MESSAGE;
+    if (ra->max_stream_bytes > SIZE_MAX / 4 - EXTENDED_HEADER_SIZE) return DCF_SER_ERR_TOO_LARGE;
+    ra->max_total_bytes = opts->max_total_bytes ? opts->max_total_bytes : 4 * ra->max_stream_bytes;
+    ra->on_chunk = opts->on_chunk;
+    ra->ctx = opts->ctx;
+    
+    ra->slots = (DCFSerStreamSlot*)calloc(ra->max_streams, sizeof(DCFSerStreamSlot));
+    if (!ra->slots) return DCF_SER_ERR_ALLOC_FAIL;
+    
+    return DCF_SER_OK;
+}
+
+static void reassembler_release(DCFSerReassembler* ra, DCFSerStreamSlot* slot, bool keep_buffer) {
+    ra->total_bytes -= slot->capacity;
+    ra->active--;
+    if (!keep_buffer) free(slot->buffer);
+    memset(slot, 0, sizeof(DCFSerStreamSlot));
+}
+
+void dcf_ser_reassembler_destroy(DCFSerReassembler* ra) {
+    if (!ra) return;
+    if (ra->slots) {
+        for (size_t i = 0; i < ra->max_streams; i++) {
+            if (ra->slots[i].in_use) reassembler_release(ra, &ra->slots[i], false);
+        }
+        free(ra->slots);
+        ra->slots = NULL;
+    }
+    free(ra->done);
+    ra->done = NULL;
+}
+
+static DCFSerStreamSlot* reassembler_find(DCFSerReassembler* ra, uint16_t msg_type,
+                                          uint32_t sequence) {
+    for (size_t i = 0; i < ra->max_streams; i++) {
+        DCFSerStreamSlot* slot = &ra->slots[i];
+        if (slot->in_use && slot->msg_type == msg_type && slot->sequence == sequence) {
+            return slot;
+        }
+    }
+    return NULL;
+}
+
+DCFSerError dcf_ser_reassembler_drop(DCFSerReassembler* ra, uint16_t msg_type, uint32_t sequence) {
+    if (!ra) return DCF_SER_ERR_NULL_PTR;
+    DCFSerStreamSlot* slot = reassembler_find(ra, msg_type, sequence);
+    if (!slot) return DCF_SER_ERR_NOT_FOUND;
+    reassembler_release(ra, slot, false);
+    return DCF_SER_OK;
+}
+
+/* Append a chunk payload, growing within the per-stream and global caps */
+static DCFSerError reassembler_append(DCFSerReassembler* ra, DCFSerStreamSlot* slot,
+                                      const uint8_t* data, size_t len) {
+    if (len > ra->max_stream_bytes - slot->length) return DCF_SER_ERR_TOO_LARGE;
+    
+    size_t needed = EXTENDED_HEADER_SIZE + (size_t)slot->length + len;
+    if (needed > slot->capacity) {
+        size_t max_cap = EXTENDED_HEADER_SIZE + ra->max_stream_bytes;
+        size_t new_cap = slot->capacity ? slot->capacity : DCF_SER_INITIAL_CAP;
+        while (new_cap < needed) {
+            new_cap = (new_cap > max_cap / 2) ? max_cap : new_cap * 2;
+        }
+        if (new_cap - slot->capacity > ra->max_total_bytes - ra->total_bytes) {
+            return DCF_SER_ERR_BUFFER_FULL;
+        }
+        
+        uint8_t* buf = (uint8_t*)realloc(slot->buffer, new_cap);
+        if (!buf) return DCF_SER_ERR_ALLOC_FAIL;
+        ra->total_bytes += new_cap - slot->capacity;
+        slot->buffer = buf;
+        slot->capacity = new_cap;
+    }
+    
+    memcpy(slot->buffer + EXTENDED_HEADER_SIZE + slot->length, data, len);
+    slot->length += len;
+    return DCF_SER_OK;
+}
+
+/* Turn a finished stream into a plain message and hand its buffer to ra->done */
+static DCFSerError reassembler_complete(DCFSerReassembler* ra, DCFSerStreamSlot* slot,
+                                        DCFSerReader* out) {
+    uint8_t flags = slot->flags & (uint8_t)~(DCF_SER_FLAG_STREAMING | DCF_SER_FLAG_FINAL |
+                                             DCF_SER_FLAG_EXTENDED);
+    flags |= DCF_SER_FLAG_NO_CRC;
+    if (slot->length > UINT32_MAX) flags |= DCF_SER_FLAG_EXTENDED;
+    
+    uint8_t hdr[EXTENDED_HEADER_SIZE];
+    size_t n = header_build(hdr, slot->msg_type, flags, slot->sequence, slot->length);
+    uint8_t* msg = slot->buffer + EXTENDED_HEADER_SIZE - n;
+    memcpy(msg, hdr, n);
+    
+    bool crc_verified = slot->crc_verified;
+    size_t msg_len = n + (size_t)slot->length;
+    ra->done = slot->buffer;
+    reassembler_release(ra, slot, true);
+    
+    DCFSerLimits limits;
+    dcf_ser_limits_default(&limits);
+    limits.max_message = ra->max_stream_bytes;
+    
+    DCF_SER_CHECK(dcf_ser_reader_init(out, msg, msg_len));
+    DCF_SER_CHECK(dcf_ser_reader_set_limits(out, &limits));
+    DCF_SER_CHECK(dcf_ser_reader_validate(out));
+    out->crc_verified = crc_verified;
+    return DCF_SER_OK;
+}
+
+DCFSerError dcf_ser_reassembler_push(DCFSerReassembler* ra, const void* data, size_t len,
+                                     DCFSerReader* out, bool* out_complete) {
+    if (!ra || !data || !out || !out_complete) return DCF_SER_ERR_NULL_PTR;
+    *out_complete = false;
+    
+    /* The previous completed message is released on the next push */
+    free(ra->done);
+    ra->done = NULL;
+    
+    DCFSerReader chunk;
+    DCF_SER_CHECK(dcf_ser_reader_init(&chunk, data, len));
+    DCF_SER_CHECK(dcf_ser_reader_validate(&chunk));
+    
+    const DCFSerHeader* hdr = &chunk.header;
+    if (!(hdr->flags & DCF_SER_FLAG_STREAMING)) {
+        *out = chunk;
+        *out_complete = true;
+        return DCF_SER_OK;
+    }
+    
+    bool final = (hdr->flags & DCF_SER_FLAG_FINAL) != 0;
+    const uint8_t* payload = chunk.buffer + chunk.payload_start;
+    size_t payload_len = chunk.payload_end - chunk.payload_start;
+    
+    DCFSerStreamSlot* slot = reassembler_find(ra, hdr->msg_type, hdr->sequence);
+    if (!slot) {
+        if (ra->active == ra->max_streams) return DCF_SER_ERR_BUFFER_FULL;
+        for (size_t i = 0; i < ra->max_streams; i++) {
+            if (!ra->slots[i].in_use) {
+                slot = &ra->slots[i];
+                break;
+            }
+        }
+        slot->in_use = true;
+        slot->msg_type = hdr->msg_type;
+        slot->sequence = hdr->sequence;
+        slot->flags = hdr->flags;
+        slot->crc_verified = true;
+        ra->active++;
+    }
+    slot->crc_verified = slot->crc_verified && chunk.crc_verified;
+    
+    if (ra->on_chunk) {
+        DCFSerStreamChunk info;
+        info.msg_type = slot->msg_type;
+        info.sequence = slot->sequence;
+        info.offset = slot->length;
+        info.data = payload;
+        info.len = payload_len;
+        info.final = final;
+        
+        slot->length += payload_len;
+        DCFSerError err = ra->on_chunk(ra->ctx, &info);
+        if (err != DCF_SER_OK || final) reassembler_release(ra, slot, false);
+        return err;
+    }
+    
+    DCFSerError err = reassembler_append(ra, slot, payload, payload_len);
+    if (err != DCF_SER_OK) {
+        /* A truncated stream is useless: drop it so the budget is freed */
+        reassembler_release(ra, slot, false);
+        return err;
+    }
+    
+    if (!final) return DCF_SER_OK;
+    
+    DCF_SER_CHECK(reassembler_complete(ra, slot, out));
+    *out_complete = true;
+    return DCF_SER_OK;
+}
+
+/* ============================================================================
+ * Stream Framing
+ * ============================================================================ */
+
+DCFSerError dcf_ser_framer_init(DCFSerFramer* f, const DCFSerFramerOptions* opts) {
+    if (!f) return DCF_SER_ERR_NULL_PTR;
+    
+    DCFSerFramerOptions defaults = {0};
+    if (!opts) opts = &defaults;
+    
+    memset(f, 0, sizeof(DCFSerFramer));
+    f->capacity = opts->capacity ? opts->capacity : DCF_SER_FRAMER_CAP;
+    f->max_frame = opts->max_frame ? opts->max_frame
+                 : EXTENDED_HEADER_SIZE + DCF_SER_MAX_MESSAGE + 4;
+    if (f->capacity < EXTENDED_HEADER_SIZE) f->capacity = EXTENDED_HEADER_SIZE;
+    f->validate = opts->validate;
+    
+    f->buffer = (uint8_t*)malloc(f->capacity);
+    if (!f->buffer) return DCF_SER_ERR_ALLOC_FAIL;
+    
+    return DCF_SER_OK;
+}
+
+void dcf_ser_framer_destroy(DCFSerFramer* f) {
+    if (!f) return;
+    free(f->buffer);
+    f->buffer = NULL;
+    f->capacity = 0;
+    f->head = 0;
+    f->tail = 0;
+}
+
+DCFSerError dcf_ser_framer_write_ptr(DCFSerFramer* f, size_t min, uint8_t** out_ptr,
+                                     size_t* out_avail) {
+    if (!f || !out_ptr || !out_avail) return DCF_SER_ERR_NULL_PTR;
+    if (min == 0) min = 1;
+    
+    if (f->capacity - f->tail < min) {
+        /* Move the unconsumed bytes to the front */
+        size_t pending = f->tail - f->head;
+        if (f->head > 0) {
+            memmove(f->buffer, f->buffer + f->head, pending);
+            f->head = 0;
+            f->tail = pending;
+        }
+        
+        /* Grow for the partial frame, or at least min more bytes */
+        size_t wanted = pending + min;
+        if (f->need > wanted) wanted = f->need;
+        if (wanted > f->capacity) {
+            if (wanted - min > f->max_frame) return DCF_SER_ERR_BUFFER_FULL;
+            
+            size_t new_cap = f->capacity;
+            while (new_cap < wanted) {
+                new_cap = (new_cap > SIZE_MAX / 2) ? wanted : new_cap * 2;
+            }
+            uint8_t* buf = (uint8_t*)realloc(f->buffer, new_cap);
+            if (!buf) return DCF_SER_ERR_ALLOC_FAIL;
+            f->buffer = buf;
+            f->capacity = new_cap;
+        }
+    }
+    
+    *out_ptr = f->buffer + f->tail;
+    *out_avail = f->capacity - f->tail;
+    return DCF_SER_OK;
+}
+
+DCFSerError dcf_ser_framer_commit(DCFSerFramer* f, size_t n) {
+    if (!f) return DCF_SER_ERR_NULL_PTR;
+    if (n > f->capacity - f->tail) return DCF_SER_ERR_INVALID_ARG;
+    f->tail += n;
+    return DCF_SER_OK;
+}
+
+DCFSerError dcf_ser_framer_push(DCFSerFramer* f, const void* data, size_t len) {
+    if (!f || (!data && len > 0)) return DCF_SER_ERR_NULL_PTR;
+    if (len == 0) return DCF_SER_OK;
+    
+    uint8_t* dst;
+    size_t avail;
+    DCF_SER_CHECK(dcf_ser_framer_write_ptr(f, len, &dst, &avail));
+    memcpy(dst, data, len);
+    f->tail += len;
+    return DCF_SER_OK;
+}
+
+/*
+ * Compact sync bytes worth resynchronizing on: only CRC-carrying ones, since
+ * a stray byte that merely parses as a CRC-less header cannot be rejected
+ */
+#define FRAMER_SYNC_MASK (DCF_SER_COMPACT_MASK | DCF_SER_COMPACT_NO_CRC)
+
+static bool framer_is_sync(uint8_t b) {
+    return (b & FRAMER_SYNC_MASK) == DCF_SER_COMPACT_SYNC;
+}
+
+/*
+ * Offset of the first "DCFS" magic in p[0, len) (or, with compact set, of
+ * the first compact sync byte if earlier), or of a trailing partial match
+ * that may complete with more data; len if there is none.
+ */
+static size_t framer_scan_magic(const uint8_t* p, size_t len, bool compact) {
+    static const uint8_t magic[4] = { 'D', 'C', 'F', 'S' };
+    size_t i = 0;
+    
+#ifdef DCF_SER_HAVE_SSE2
+    /* Compare 16 bytes at a time against 'D' and the sync pattern */
+    const __m128i first = _mm_set1_epi8('D');
+    const __m128i sync_mask = _mm_set1_epi8((char)FRAMER_SYNC_MASK);
+    const __m128i sync = _mm_set1_epi8((char)DCF_SER_COMPACT_SYNC);
+    for (; i + 16 + 3 <= len; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i*)(p + i));
+        __m128i hits = _mm_cmpeq_epi8(block, first);
+        if (compact) {
+            hits = _mm_or_si128(hits, _mm_cmpeq_epi8(_mm_and_si128(block, sync_mask), sync));
+        }
+        unsigned mask = (unsigned)_mm_movemask_epi8(hits);
+        while (mask) {
+            unsigned bit = (unsigned)__builtin_ctz(mask);
+            if (p[i + bit] != 'D' || memcmp(p + i + bit, magic, 4) == 0) return i + bit;
+            mask &= mask - 1;
+        }
+    }
+#endif
+    
+    if (compact) {
+        for (; i < len; i++) {
+            if (framer_is_sync(p[i])) return i;
+            size_t n = (len - i < 4) ? len - i : 4;
+            if (p[i] == 'D' && memcmp(p + i, magic, n) == 0) return i;
+        }
+        return len;
+    }
+    
+    while (i < len) {
+        const uint8_t* d = (const uint8_t*)memchr(p + i, 'D', len - i);
+        if (!d) return len;
+        i = (size_t)(d - p);
+        size_t n = (len - i < 4) ? len - i : 4;
+        if (memcmp(p + i, magic, n) == 0) return i;
+        i++;
+    }
+    return len;
+}
+
+/*
+ * Drop the byte at head and skip ahead to the next possible message start.
+ * Compact headers have no magic, so their sync bytes are candidates only
+ * when frames are validated: the CRC then weeds out false starts.
+ */
+static void framer_resync(DCFSerFramer* f) {
+    size_t start = f->head + 1;
+    size_t off = framer_scan_magic(f->buffer + start, f->tail - start, f->validate);
+    f->skipped += 1 + off;
+    f->head = start + off;
+    f->need = 0;
+}
+
+DCFSerError dcf_ser_framer_next(DCFSerFramer* f, DCFSerFrame* out) {
+    if (!f || !out) return DCF_SER_ERR_NULL_PTR;
+    
+    while (f->head < f->tail) {
+        const uint8_t* p = f->buffer + f->head;
+        size_t avail = f->tail - f->head;
+        size_t total;
+        
+        /* Reject non-headers early rather than waiting for a full header */
+        if (!header_is_compact(p) && framer_scan_magic(p, avail < 4 ? avail : 4, false) != 0) {
+            framer_resync(f);
+            continue;
+        }
+        
+        DCFSerError err = dcf_ser_message_length_ex(p, avail, &total);
+        if (err == DCF_SER_ERR_TRUNCATED) break;
+        if (err != DCF_SER_OK || total > f->max_frame) {
+            framer_resync(f);
+            continue;
+        }
+        
+        if (total > avail) {
+            f->need = total;
+            break;
+        }
+        
+        if (f->validate && dcf_ser_validate_message(p, total) != DCF_SER_OK) {
+            framer_resync(f);
+            continue;
+        }
+        
+        out->data = p;
+        out->len = total;
+        f->head += total;
+        f->need = 0;
+        f->frames++;
+        
+        if (f->head == f->tail) {
+            /* Buffer drained: restart at the front, the frame stays intact */
+            f->head = 0;
+            f->tail = 0;
+        }
+        return DCF_SER_OK;
+    }
+    
+    return DCF_SER_ERR_NOT_FOUND;
+}
+
+DCFSerError dcf_ser_framer_next_batch(DCFSerFramer* f, DCFSerFrame* frames, size_t max,
+                                      size_t* out_count) {
+    if (!f || !frames || !out_count) return DCF_SER_ERR_NULL_PTR;
+    
+    size_t count = 0;
+    while (count < max && dcf_ser_framer_next(f, &frames[count]) == DCF_SER_OK) {
+        count++;
+    }
+    
+    *out_count = count;
+    return DCF_SER_OK;
+}
+
+/* ============================================================================
+ * Utility Functions
+ * ============================================================================ */
+
+const char* dcf_ser_error_str(DCFSerError err) {
+    switch (err) {
+        case DCF_SER_OK:                  return "Success";
+        case DCF_SER_ERR_BUFFER_FULL:     return "Buffer full";
+        case DCF_SER_ERR_ALLOC_FAIL:      return "Allocation failed";
+        case DCF_SER_ERR_TOO_LARGE:       return "Data too large";
+        case DCF_SER_ERR_DEPTH_EXCEEDED:  return "Max nesting depth exceeded";
+        case DCF_SER_ERR_INVALID_MAGIC:   return "Invalid magic number";
+        case DCF_SER_ERR_VERSION_MISMATCH:return "Protocol version mismatch";
+        case DCF_SER_ERR_TRUNCATED:       return "Truncated message";
+        case DCF_SER_ERR_CRC_MISMATCH:    return "CRC checksum mismatch";
+        case DCF_SER_ERR_INVALID_TYPE:    return "Invalid type tag";
+        case DCF_SER_ERR_OVERFLOW:        return "Value overflow";
+        case DCF_SER_ERR_MALFORMED:       return "Malformed data";
+        case DCF_SER_ERR_NEED_MORE:       return "Need more data";
+        case DCF_SER_ERR_FRAGMENTED:      return "Value spans segments";
+        case DCF_SER_ERR_NULL_PTR:        return "Null pointer";
+        case DCF_SER_ERR_INVALID_ARG:     return "Invalid argument";
+        case DCF_SER_ERR_INTERNAL:        return "Internal error";
+        case DCF_SER_ERR_NOT_FOUND:       return "Not found";
+        case DCF_SER_ERR_TYPE_MISMATCH:   return "Type mismatch";
+        case DCF_SER_ERR_IO:              return "I/O error";
+        default:                          return "Unknown error";
+    }
+}
+
+const char* dcf_ser_type_str(DCFSerType type) {
+    switch (type) {
+        case DCF_TYPE_NULL:       return "null";
+        case DCF_TYPE_BOOL:       return "bool";
+        case DCF_TYPE_U8:         return "u8";
+        case DCF_TYPE_I8:         return "i8";
+        case DCF_TYPE_U16:        return "u16";
+        case DCF_TYPE_I16:        return "i16";
+        case DCF_TYPE_U32:        return "u32";
+        case DCF_TYPE_I32:        return "i32";
+        case DCF_TYPE_U64:        return "u64";
+        case DCF_TYPE_I64:        return "i64";
+        case DCF_TYPE_F32:        return "f32";
+        case DCF_TYPE_F64:        return "f64";
+        case DCF_TYPE_VARINT:     return "varint";
+        case DCF_TYPE_STRING:     return "string";
+        case DCF_TYPE_BYTES:      return "bytes";
+        case DCF_TYPE_UUID:       return "uuid";
+        case DCF_TYPE_ARRAY:      return "array";
+        case DCF_TYPE_MAP:        return "map";
+        case DCF_TYPE_SORTED_MAP: return "sorted_map";
+        case DCF_TYPE_TABLE:      return "table";
+        case DCF_TYPE_FIXED:      return "fixed";
+        case DCF_TYPE_COMPACT_STRUCT: return "compact_struct";
+        case DCF_TYPE_SCHEMA_REF: return "schema_ref";
+        case DCF_TYPE_STRUCT:     return "struct";
+        case DCF_TYPE_TUPLE:      return "tuple";
+        case DCF_TYPE_TIMESTAMP:  return "timestamp";
+        case DCF_TYPE_DURATION:   return "duration";
+        case DCF_TYPE_OPTIONAL:   return "optional";
+        case DCF_TYPE_ENUM:       return "enum";
+        case DCF_TYPE_EXTENSION:  return "extension";
+        case DCF_TYPE_INVALID:    return "invalid";
+        default:                  return "unknown";
+    }
+}
+
+size_t dcf_ser_type_size(DCFSerType type) {
+    switch (type) {
+        case DCF_TYPE_NULL:       return 0;
+        case DCF_TYPE_BOOL:
+        case DCF_TYPE_U8:
+        case DCF_TYPE_I8:         return 1;
+        case DCF_TYPE_U16:
+        case DCF_TYPE_I16:        return 2;
+        case DCF_TYPE_U32:
+        case DCF_TYPE_I32:
+        case DCF_TYPE_F32:        return 4;
+        case DCF_TYPE_U64:
+        case DCF_TYPE_I64:
+        case DCF_TYPE_F64:
+        case DCF_TYPE_TIMESTAMP:
+        case DCF_TYPE_DURATION:   return 8;
+        case DCF_TYPE_UUID:       return 16;
+        default:                  return 0;  /* Variable-length */
+    }
+}
+
+DCFSerError dcf_ser_validate_message(const void* data, size_t len) {
+    DCFSerReader reader;
+    DCFSerError err = dcf_ser_reader_init(&reader, data, len);
+    if (err != DCF_SER_OK) return err;
+    return dcf_ser_reader_validate(&reader);
+}
+
+size_t dcf_ser_message_length(const void* header_data) {
+    if (!header_data) return 0;
+    
+    const uint8_t* p = (const uint8_t*)header_data;
+    if (header_is_compact(p)) {
+        size_t total;
+        if (dcf_ser_message_length_ex(p, COMPACT_HEADER_MAX, &total) != DCF_SER_OK) {
+            return 0;
+        }
+        return total;
+    }
+    
+    const DCFSerHeader* wire_hdr = (const DCFSerHeader*)header_data;
+    uint64_t payload_len = dcf_ser_ntoh32(wire_hdr->payload_len);
+    uint8_t flags = wire_hdr->flags;
+    size_t hdr_len = sizeof(DCFSerHeader);
+    
+    if (flags & DCF_SER_FLAG_EXTENDED) {
+        uint64_t len_net;
+        memcpy(&len_net, p + sizeof(DCFSerHeader), 8);
+        payload_len = dcf_ser_ntoh64(len_net);
+        hdr_len = EXTENDED_HEADER_SIZE;
+        if (payload_len > SIZE_MAX - hdr_len - 4) return 0;
+    }
+    
+    size_t total = hdr_len + (size_t)payload_len;
+    if (!(flags & DCF_SER_FLAG_NO_CRC)) {
+        total += 4;  /* CRC32 */
+    }
+    
+    return total;
+}
+
+DCFSerError dcf_ser_message_length_ex(const void* data, size_t avail, size_t* out_len) {
+    if (!data || !out_len) return DCF_SER_ERR_NULL_PTR;
+    
+    DCFSerHeader hdr;
+    size_t hdr_len;
+    uint64_t payload_len;
+    DCF_SER_CHECK(header_parse((const uint8_t*)data, avail, 0, &hdr, &hdr_len, &payload_len));
+    if (payload_len > SIZE_MAX - hdr_len - 4) return DCF_SER_ERR_TOO_LARGE;
+    
+    size_t total = hdr_len + (size_t)payload_len;
+    if (!(hdr.flags & DCF_SER_FLAG_NO_CRC)) {
+        total += 4;  /* CRC32 */
+    }
+    
+    *out_len = total;
+    return DCF_SER_OK;
+}
+
+/* ============================================================================
+ * Schema-Based Serialization
+ * ============================================================================ */
+
+/* True if a DCF_FIELD_DEFAULT field holds its default and can be omitted */
+static bool field_is_default(const DCFSerField* field, const uint8_t* src) {
+    if (!(field->flags & DCF_FIELD_DEFAULT)) return false;
+    
+    if (field->type == DCF_TYPE_STRING) {
+        const char* str = *(const char* const*)src;
+        const char* def = field->default_value;
+        return strcmp(str ? str : "", def ? def : "") == 0;
+    }
+    if (field->default_value) return memcmp(src, field->default_value, field->size) == 0;
+    for (size_t i = 0; i < field->size; i++) {
+        if (src[i] != 0) return false;
+    }
+    return true;
+}
+
+/* Zero a struct, then fill declared defaults (string members only for
+ * decoders that materialize strings; they point at the schema's default) */
+static void schema_init_defaults(void* data, const DCFSerSchema* schema, bool strings) {
+    memset(data, 0, schema->struct_size);
+    for (size_t i = 0; i < schema->field_count; i++) {
+        const DCFSerField* field = &schema->fields[i];
+        if (!(field->flags & DCF_FIELD_DEFAULT)) continue;
+        uint8_t* dst = (uint8_t*)data + field->offset;
+        if (field->type == DCF_TYPE_STRING) {
+            if (strings) *(const char**)dst = field->default_value ? field->default_value : "";
+        } else if (field->default_value) {
+            memcpy(dst, field->default_value, field->size);
+        }
+    }
+}
+
+/* Read one tagged field value into its struct member (others skipped;
+ * strings are copied when an arena is given) */
+static DCFSerError schema_read_value(DCFSerReader* r, const DCFSerField* field, uint8_t* dst,
+                                     DCFSerArena* arena) {
+    switch (field->type) {
+        case DCF_TYPE_BOOL:
+            DCF_SER_CHECK(dcf_ser_read_bool(r, (bool*)dst));
+            break;
+        case DCF_TYPE_U8:
+            DCF_SER_CHECK(dcf_ser_read_u8(r, (uint8_t*)dst));
+            break;
+        case DCF_TYPE_I8:
+            DCF_SER_CHECK(dcf_ser_read_i8(r, (int8_t*)dst));
+            break;
+        case DCF_TYPE_U16:
+            DCF_SER_CHECK(dcf_ser_read_u16(r, (uint16_t*)dst));
+            break;
+        case DCF_TYPE_I16:
+            DCF_SER_CHECK(dcf_ser_read_i16(r, (int16_t*)dst));
+            break;
+        case DCF_TYPE_U32:
+            DCF_SER_CHECK(dcf_ser_read_u32(r, (uint32_t*)dst));
+            break;
+        case DCF_TYPE_I32:
+            DCF_SER_CHECK(dcf_ser_read_i32(r, (int32_t*)dst));
+            break;
+        case DCF_TYPE_U64:
+            DCF_SER_CHECK(dcf_ser_read_u64(r, (uint64_t*)dst));
+            break;
+        case DCF_TYPE_I64:
+            DCF_SER_CHECK(dcf_ser_read_i64(r, (int64_t*)dst));
+            break;
+        case DCF_TYPE_F32:
+            DCF_SER_CHECK(dcf_ser_read_f32(r, (float*)dst));
+            break;
+        case DCF_TYPE_F64:
+            DCF_SER_CHECK(dcf_ser_read_f64(r, (double*)dst));
+            break;
+        case DCF_TYPE_TIMESTAMP:
+            DCF_SER_CHECK(dcf_ser_read_timestamp(r, (uint64_t*)dst));
+            break;
+        case DCF_TYPE_STRING:
+            if (arena) {
+                DCF_SER_CHECK(dcf_ser_read_string_arena(r, arena, (const char**)dst, NULL));
+                break;
+            }
+            DCF_SER_CHECK(dcf_ser_reader_skip(r));
+            break;
+        default:
+            DCF_SER_CHECK(dcf_ser_reader_skip(r));
+            break;
+    }
+    return DCF_SER_OK;
+}
+
+DCFSerError dcf_ser_write_struct_schema(DCFSerWriter* w, const void* data,
+                                         const DCFSerSchema* schema) {
+    if (!w || !data || !schema) return DCF_SER_ERR_NULL_PTR;
+    
+    DCF_SER_CHECK(dcf_ser_write_struct_begin(w, schema->type_id));
+    
+    for (size_t i = 0; i < schema->field_count; i++) {
+        const DCFSerField* field = &schema->fields[i];
+        const uint8_t* field_data = (const uint8_t*)data + field->offset;
+        if (field_is_default(field, field_data)) continue;
+        
+        /* Write field header */
+        DCF_SER_CHECK(dcf_ser_write_field(w, field->field_id, field->type));
+        
+        /* Write field value based on type */
+        switch (field->type) {
+            case DCF_TYPE_BOOL: {
+                bool val = *(const bool*)field_data;
+                DCF_SER_CHECK(dcf_ser_write_bool(w, val));
+                break;
+            }
+            case DCF_TYPE_U8:
+                DCF_SER_CHECK(dcf_ser_write_u8(w, *(const uint8_t*)field_data));
+                break;
+            case DCF_TYPE_I8:
+                DCF_SER_CHECK(dcf_ser_write_i8(w, *(const int8_t*)field_data));
+                break;
+            case DCF_TYPE_U16:
+                DCF_SER_CHECK(dcf_ser_write_u16(w, *(const uint16_t*)field_data));
+                break;
+            case DCF_TYPE_I16:
+                DCF_SER_CHECK(dcf_ser_write_i16(w, *(const int16_t*)field_data));
+                break;
+            case DCF_TYPE_U32:
+                DCF_SER_CHECK(dcf_ser_write_u32(w, *(const uint32_t*)field_data));
+                break;
+            case DCF_TYPE_I32:
+                DCF_SER_CHECK(dcf_ser_write_i32(w, *(const int32_t*)field_data));
+                break;
+            case DCF_TYPE_U64:
+                DCF_SER_CHECK(dcf_ser_write_u64(w, *(const uint64_t*)field_data));
+                break;
+            case DCF_TYPE_I64:
+                DCF_SER_CHECK(dcf_ser_write_i64(w, *(const int64_t*)field_data));
+                break;
+            case DCF_TYPE_F32:
+                DCF_SER_CHECK(dcf_ser_write_f32(w, *(const float*)field_data));
+                break;
+            case DCF_TYPE_F64:
+                DCF_SER_CHECK(dcf_ser_write_f64(w, *(const double*)field_data));
+                break;
+            case DCF_TYPE_STRING:
+                DCF_SER_CHECK(dcf_ser_write_string(w, *(const char**)field_data));
+                break;
+            case DCF_TYPE_TIMESTAMP:
+                DCF_SER_CHECK(dcf_ser_write_timestamp(w, *(const uint64_t*)field_data));
+                break;
+            default:
+                return DCF_SER_ERR_INVALID_TYPE;
+        }
+    }
+    
+    DCF_SER_CHECK(dcf_ser_write_struct_end(w));
+    return DCF_SER_OK;
+}
+
+static DCFSerError read_struct_schema(DCFSerReader* r, void* data, const DCFSerSchema* schema,
+                                      DCFSerArena* arena) {
+    if (!r || !data || !schema) return DCF_SER_ERR_NULL_PTR;
+    
+    uint16_t type_id;
+    DCF_SER_CHECK(dcf_ser_read_struct_begin(r, &type_id));
+    
+    if (type_id != schema->type_id) {
+        return DCF_SER_ERR_TYPE_MISMATCH;
+    }
+    
+    /* Clear the struct first; omitted fields keep their defaults */
+    schema_init_defaults(data, schema, arena != NULL);
+    
+    /* Read fields until end marker */
+    while (true) {
+        uint16_t field_id;
+        DCFSerType field_type;
+        DCFSerError err = dcf_ser_read_field(r, &field_id, &field_type);
+        
+        if (err == DCF_SER_ERR_NOT_FOUND) break;  /* End of struct */
+        if (err != DCF_SER_OK) return err;
+        
+        /* Find field in schema */
+        const DCFSerField* field = NULL;
+        for (size_t i = 0; i < schema->field_count; i++) {
+            if (schema->fields[i].field_id == field_id) {
+                field = &schema->fields[i];
+                break;
+            }
+        }
+        
+        if (!field) {
+            /* Unknown field, skip it */
+            DCF_SER_CHECK(dcf_ser_reader_skip(r));
+            continue;
+        }
+        
+        DCF_SER_CHECK(schema_read_value(r, field, (uint8_t*)data + field->offset, arena));
+    }
+    
+    DCF_SER_CHECK(dcf_ser_read_struct_end(r));
+    return DCF_SER_OK;
+}
+
+DCFSerError dcf_ser_read_struct_schema(DCFSerReader* r, void* data,
+                                        const DCFSerSchema* schema) {
+    return read_struct_schema(r, data, schema, NULL);
+}
+
+/* ============================================================================
+ * Flyweight Layouts
+ * ============================================================================ */
+
+#define FIXED_HEADER_SIZE 7   /* tag, type_id u16, block length u32 */
+
+/* Width of a field in a fixed block, or 0 if it cannot be fixed */
+static size_t layout_field_width(const DCFSerField* field) {
+    if (field->type == DCF_TYPE_BYTES) return field->size;
+    return dcf_ser_type_size(field->type);
+}
+
+DCFSerError dcf_ser_layout_compile(DCFSerLayout* layout, const DCFSerSchema* schema) {
+    if (!layout || !schema) return DCF_SER_ERR_NULL_PTR;
+    if (!schema->fields && schema->field_count > 0) return DCF_SER_ERR_NULL_PTR;
+    memset(layout, 0, sizeof(DCFSerLayout));
+    
+    uint32_t* offsets = NULL;
+    if (schema->field_count > 0) {
+        offsets = (uint32_t*)malloc(schema->field_count * sizeof(uint32_t));
+        if (!offsets) return DCF_SER_ERR_ALLOC_FAIL;
+    }
+    
+    /* Packed in schema order; accessors load unaligned */
+    uint64_t at = 0;
+    for (size_t i = 0; i < schema->field_count; i++) {
+        size_t width = layout_field_width(&schema->fields[i]);
+        if (width == 0) {
+            free(offsets);
+            return DCF_SER_ERR_INVALID_TYPE;
+        }
+        offsets[i] = (uint32_t)at;
+        at += width;
+        if (at > UINT32_MAX) {
+            free(offsets);
+            return DCF_SER_ERR_TOO_LARGE;
+        }
+    }
+    
+    layout->schema = schema;
+    layout->offsets = offsets;
+    layout->block_size = (uint32_t)at;
+    layout->message_size = sizeof(DCFSerHeader) + FIXED_HEADER_SIZE + (size_t)at + 4;
+    return DCF_SER_OK;
+}
+
+void dcf_ser_layout_destroy(DCFSerLayout* layout) {
+    if (!layout) return;
+    free(layout->offsets);
+    layout->offsets = NULL;
+}
+
+DCFSerError dcf_ser_layout_offset(const DCFSerLayout* layout, uint16_t field_id, uint32_t* out_offset) {
+    if (!layout || !out_offset || !layout->schema) return DCF_SER_ERR_NULL_PTR;
+    for (size_t i = 0; i < layout->schema->field_count; i++) {
+        if (layout->schema->fields[i].field_id == field_id) {
+            *out_offset = layout->offsets[i];
+            return DCF_SER_OK;
+        }
+    }
+    return DCF_SER_ERR_NOT_FOUND;
+}
+
+DCFSerError dcf_ser_write_flyweight_begin(DCFSerWriter* w, const DCFSerLayout* layout,
+                                          uint8_t** out_block) {
+    if (!w || !layout || !layout->schema || !out_block) return DCF_SER_ERR_NULL_PTR;
+    
+    WRITER_ENSURE_SPACE(w, FIXED_HEADER_SIZE + (size_t)layout->block_size);
+    DCF_SER_CHECK(writer_put_u8(w, DCF_TYPE_FIXED));
+    DCF_SER_CHECK(writer_put_u16(w, layout->schema->type_id));
+    DCF_SER_CHECK(writer_put_u32(w, layout->block_size));
+    
+    *out_block = w->buffer + w->position;
+    memset(*out_block, 0, layout->block_size);
+    w->position += layout->block_size;
+    return DCF_SER_OK;
+}
+
+DCFSerError dcf_ser_write_flyweight(DCFSerWriter* w, const DCFSerLayout* layout, const void* data) {
+    if (!data) return DCF_SER_ERR_NULL_PTR;
+    uint8_t* block;
+    DCF_SER_CHECK(dcf_ser_write_flyweight_begin(w, layout, &block));
+    
+    const DCFSerSchema* schema = layout->schema;
+    for (size_t i = 0; i < schema->field_count; i++) {
+        const DCFSerField* field = &schema->fields[i];
+        const uint8_t* src = (const uint8_t*)data + field->offset;
+        uint8_t* dst = block + layout->offsets[i];
+        
+        switch (field->type) {
+            case DCF_TYPE_BOOL:
+                *dst = *(const bool*)src ? 1 : 0;
+                break;
+            case DCF_TYPE_U8:
+            case DCF_TYPE_I8:
+                *dst = *src;
+                break;
+            case DCF_TYPE_U16:
+            case DCF_TYPE_I16:
+                dcf_ser_fly_set_u16(dst, 0, *(const uint16_t*)src);
+                break;
+            case DCF_TYPE_U32:
+            case DCF_TYPE_I32:
+                dcf_ser_fly_set_u32(dst, 0, *(const uint32_t*)src);
+                break;
+            case DCF_TYPE_F32:
+                dcf_ser_fly_set_f32(dst, 0, *(const float*)src);
+                break;
+            case DCF_TYPE_U64:
+            case DCF_TYPE_I64:
+            case DCF_TYPE_TIMESTAMP:
+            case DCF_TYPE_DURATION:
+                dcf_ser_fly_set_u64(dst, 0, *(const uint64_t*)src);
+                break;
+            case DCF_TYPE_F64:
+                dcf_ser_fly_set_f64(dst, 0, *(const double*)src);
+                break;
+            default:    /* UUID and fixed-length bytes are copied as is */
+                memcpy(dst, src, layout_field_width(field));
+                break;
+        }
+    }
+    return DCF_SER_OK;
+}
+
+DCFSerError dcf_ser_read_flyweight(DCFSerReader* r, const DCFSerLayout* layout,
+                                   const uint8_t** out_block) {
+    if (!r || !layout || !layout->schema || !out_block) return DCF_SER_ERR_NULL_PTR;
+    
+    DCF_SER_CHECK(reader_expect_type(r, DCF_TYPE_FIXED));
+    uint16_t type_id;
+    uint32_t len;
+    DCF_SER_CHECK(reader_get_u16(r, &type_id));
+    DCF_SER_CHECK(reader_get_u32(r, &len));
+    if (type_id != layout->schema->type_id || len != layout->block_size) {
+        r->last_error = DCF_SER_ERR_TYPE_MISMATCH;
+        return DCF_SER_ERR_TYPE_MISMATCH;
+    }
+    
+    const void* block;
+    DCF_SER_CHECK(dcf_ser_read_raw_ptr(r, &block, len));
+    *out_block = (const uint8_t*)block;
+    return DCF_SER_OK;
+}
+
+DCFSerError dcf_ser_flyweight_decode(const DCFSerLayout* layout, const uint8_t* block, void* data) {
+    if (!layout || !layout->schema || !block || !data) return DCF_SER_ERR_NULL_PTR;
+    
+    const DCFSerSchema* schema = layout->schema;
+    for (size_t i = 0; i < schema->field_count; i++) {
+        const DCFSerField* field = &schema->fields[i];
+        const uint8_t* src = block + layout->offsets[i];
+        uint8_t* dst = (uint8_t*)data + field->offset;
+        
+        switch (field->type) {
+            case DCF_TYPE_BOOL:
+                *(bool*)dst = *src != 0;
+                break;
+            case DCF_TYPE_U8:
+            case DCF_TYPE_I8:
+                *dst = *src;
+                break;
+            case DCF_TYPE_U16:
+            case DCF_TYPE_I16:
+                *(uint16_t*)dst = dcf_ser_fly_get_u16(src, 0);
+                break;
+            case DCF_TYPE_U32:
+            case DCF_TYPE_I32:
+                *(uint32_t*)dst = dcf_ser_fly_get_u32(src, 0);
+                break;
+            case DCF_TYPE_F32:
+                *(float*)dst = dcf_ser_fly_get_f32(src, 0);
+                break;
+            case DCF_TYPE_U64:
+            case DCF_TYPE_I64:
+            case DCF_TYPE_TIMESTAMP:
+            case DCF_TYPE_DURATION:
+                *(uint64_t*)dst = dcf_ser_fly_get_u64(src, 0);
+                break;
+            case DCF_TYPE_F64:
+                *(double*)dst = dcf_ser_fly_get_f64(src, 0);
+                break;
+            default:
+                memcpy(dst, src, layout_field_width(field));
+                break;
+        }
+    }
+    return DCF_SER_OK;
+}
+
+/* ============================================================================
+ * Compact Structs
+ * ============================================================================ */
+
+#define COMPACT_HEADER_SIZE 7   /* tag, type_id u16, body length u32 */
+
+static size_t varint_size(uint64_t v) {
+    size_t n = 1;
+    while (v >= 0x80) {
+        v >>= 7;
+        n++;
+    }
+    return n;
+}
+
+/* Types the untagged codec can carry */
+static bool tagless_type_ok(uint8_t type) {
+    switch (type) {
+        case DCF_TYPE_BOOL: case DCF_TYPE_U8: case DCF_TYPE_I8:
+        case DCF_TYPE_U16: case DCF_TYPE_I16:
+        case DCF_TYPE_U32: case DCF_TYPE_I32: case DCF_TYPE_F32:
+        case DCF_TYPE_U64: case DCF_TYPE_I64: case DCF_TYPE_F64:
+        case DCF_TYPE_TIMESTAMP: case DCF_TYPE_DURATION:
+        case DCF_TYPE_VARINT: case DCF_TYPE_STRING:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/* Readers must refuse such schemas up front: the wire decides which fields
+ * get decoded, so one unsupported member is enough to corrupt the struct */
+static DCFSerError tagless_schema_check(const DCFSerSchema* schema) {
+    if (!schema->fields && schema->field_count > 0) return DCF_SER_ERR_NULL_PTR;
+    for (size_t i = 0; i < schema->field_count; i++) {
+        if (!tagless_type_ok(schema->fields[i].type)) return DCF_SER_ERR_INVALID_TYPE;
+    }
+    return DCF_SER_OK;
+}
+
+/* Encoded size of a tagless field value; 0 if the type is not supported */
+static size_t compact_value_size(const DCFSerField* field, const uint8_t* src) {
+    switch (field->type) {
+        case DCF_TYPE_VARINT:
+            return varint_size(*(const uint64_t*)src);
+        case DCF_TYPE_STRING: {
+            const char* str = *(const char* const*)src;
+            size_t len = str ? strlen(str) : 0;
+            return varint_size(len) + len;
+        }
+        case DCF_TYPE_BOOL: case DCF_TYPE_U8: case DCF_TYPE_I8:
+        case DCF_TYPE_U16: case DCF_TYPE_I16:
+        case DCF_TYPE_U32: case DCF_TYPE_I32: case DCF_TYPE_F32:
+        case DCF_TYPE_U64: case DCF_TYPE_I64: case DCF_TYPE_F64:
+        case DCF_TYPE_TIMESTAMP: case DCF_TYPE_DURATION:
+            return dcf_ser_type_size(field->type);
+        default:
+            return 0;
+    }
+}
+
+/* Optional fields holding zero (or a NULL string) and defaults are left out */
+static bool compact_field_present(const DCFSerField* field, const uint8_t* src) {
+    if (field_is_default(field, src)) return false;
+    if (!(field->flags & DCF_FIELD_OPTIONAL)) return true;
+    if (field->type == DCF_TYPE_STRING) return *(const char* const*)src != NULL;
+    
+    size_t n = dcf_ser_type_size(field->type);
+    if (field->type == DCF_TYPE_VARINT) n = sizeof(uint64_t);
+    for (size_t i = 0; i < n; i++) {
+        if (src[i] != 0) return true;
+    }
+    return false;
+}
+
+/* Write a field value without its type tag (space already ensured) */
+static DCFSerError tagless_put(DCFSerWriter* w, const DCFSerField* field, const uint8_t* src) {
+    switch (field->type) {
+        case DCF_TYPE_BOOL:
+            DCF_SER_CHECK(writer_put_u8(w, *(const bool*)src ? 1 : 0));
+            break;
+        case DCF_TYPE_U8:
+        case DCF_TYPE_I8:
+            DCF_SER_CHECK(writer_put_u8(w, *src));
+            break;
+        case DCF_TYPE_U16:
+        case DCF_TYPE_I16:
+            DCF_SER_CHECK(writer_put_u16(w, *(const uint16_t*)src));
+            break;
+        case DCF_TYPE_U32:
+        case DCF_TYPE_I32:
+        case DCF_TYPE_F32: {
+            uint32_t bits;
+            memcpy(&bits, src, 4);
+            DCF_SER_CHECK(writer_put_u32(w, bits));
+            break;
+        }
+        case DCF_TYPE_VARINT:
+            DCF_SER_CHECK(writer_put_varint(w, *(const uint64_t*)src));
+            break;
+        case DCF_TYPE_STRING: {
+            const char* str = *(const char* const*)src;
+            size_t len = str ? strlen(str) : 0;
+            DCF_SER_CHECK(writer_put_varint(w, len));
+            if (len > 0) memcpy(w->buffer + w->position, str, len);
+            w->position += len;
+            break;
+        }
+        case DCF_TYPE_U64: case DCF_TYPE_I64: case DCF_TYPE_F64:
+        case DCF_TYPE_TIMESTAMP: case DCF_TYPE_DURATION: {
+            uint64_t bits;
+            memcpy(&bits, src, 8);
+            DCF_SER_CHECK(writer_put_u64(w, bits));
+            break;
+        }
+        default:
+            return DCF_SER_ERR_INVALID_TYPE;
+    }
+    return DCF_SER_OK;
+}
+
+/* Read a field value written by tagless_put */
+static DCFSerError tagless_get(DCFSerReader* r, const DCFSerField* field, uint8_t* dst) {
+    switch (field->type) {
+        case DCF_TYPE_BOOL: {
+            uint8_t v;
+            DCF_SER_CHECK(reader_get_u8(r, &v));
+            *(bool*)dst = v != 0;
+            return DCF_SER_OK;
+        }
+        case DCF_TYPE_U8:
+        case DCF_TYPE_I8:
+            return reader_get_u8(r, dst);
+        case DCF_TYPE_U16:
+        case DCF_TYPE_I16:
+            return reader_get_u16(r, (uint16_t*)dst);
+        case DCF_TYPE_U32:
+        case DCF_TYPE_I32:
+        case DCF_TYPE_F32: {
+            uint32_t bits;
+            DCF_SER_CHECK(reader_get_u32(r, &bits));
+            memcpy(dst, &bits, 4);
+            return DCF_SER_OK;
+        }
+        case DCF_TYPE_VARINT:
+            return reader_get_varint(r, (uint64_t*)dst);
+        case DCF_TYPE_STRING: {
+            /* Not copied into the struct, as with dcf_ser_read_struct_schema */
+            uint64_t len;
+            DCF_SER_CHECK(reader_get_varint(r, &len));
+            return reader_advance(r, len);
+        }
+        case DCF_TYPE_U64: case DCF_TYPE_I64: case DCF_TYPE_F64:
+        case DCF_TYPE_TIMESTAMP: case DCF_TYPE_DURATION: {
+            uint64_t bits;
+            DCF_SER_CHECK(reader_get_u64(r, &bits));
+            memcpy(dst, &bits, 8);
+            return DCF_SER_OK;
+        }
+        default:
+            return DCF_SER_ERR_INVALID_TYPE;
+    }
+}
+
+DCFSerError dcf_ser_write_compact_struct_begin(DCFSerWriter* w, const void* data,
+                                               const DCFSerSchema* schema) {
+    if (!w || !data || !schema) return DCF_SER_ERR_NULL_PTR;
+    if (!schema->fields && schema->field_count > 0) return DCF_SER_ERR_NULL_PTR;
+    if (w->depth >= w->limits.max_depth) return DCF_SER_ERR_DEPTH_EXCEEDED;
+    
+    /* Size the schema section first so its length can lead it */
+    size_t n = schema->field_count;
+    size_t known = varint_size(n) + (n + 7) / 8;
+    for (size_t i = 0; i < n; i++) {
+        const DCFSerField* field = &schema->fields[i];
+        const uint8_t* src = (const uint8_t*)data + field->offset;
+        size_t size = compact_value_size(field, src);
+        if (size == 0) return DCF_SER_ERR_INVALID_TYPE;
+        if (compact_field_present(field, src)) known += size;
+    }
+    
+    DCF_SER_CHECK(writer_hold_ensure(w));
+    WRITER_ENSURE_SPACE(w, COMPACT_HEADER_SIZE + varint_size(known) + known);
+    size_t start = w->position;
+    DCF_SER_CHECK(writer_put_u8(w, DCF_TYPE_COMPACT_STRUCT));
+    DCF_SER_CHECK(writer_put_u16(w, schema->type_id));
+    DCF_SER_CHECK(writer_put_u32(w, 0));   /* Body length, patched at the end */
+    DCF_SER_CHECK(writer_put_varint(w, known));
+    DCF_SER_CHECK(writer_put_varint(w, n));
+    
+    uint8_t* bitmap = w->buffer + w->position;
+    memset(bitmap, 0, (n + 7) / 8);
+    w->position += (n + 7) / 8;
+    
+    for (size_t i = 0; i < n; i++) {
+        const DCFSerField* field = &schema->fields[i];
+        const uint8_t* src = (const uint8_t*)data + field->offset;
+        if (!compact_field_present(field, src)) continue;
+        bitmap[i / 8] |= (uint8_t)(1u << (i % 8));
+        
+        DCF_SER_CHECK(tagless_put(w, field, src));
+    }
+    
+    DCFSerHeldFrame* f;
+    return writer_hold_push(w, DCF_TYPE_COMPACT_STRUCT, start, 0, &f);
+}
+
+DCFSerError dcf_ser_write_compact_ext(DCFSerWriter* w, uint16_t field_id) {
+    if (!w) return DCF_SER_ERR_NULL_PTR;
+    if (field_id == 0) return DCF_SER_ERR_INVALID_ARG;
+    if (w->held_depth == 0 || w->held[w->held_depth - 1].kind != DCF_TYPE_COMPACT_STRUCT) {
+        return DCF_SER_ERR_MALFORMED;
+    }
+    return writer_put_varint(w, field_id);
+}
+
+DCFSerError dcf_ser_write_compact_struct_end(DCFSerWriter* w) {
+    if (!w) return DCF_SER_ERR_NULL_PTR;
+    if (w->depth == 0 || w->held_depth == 0 ||
+        w->held[w->held_depth - 1].kind != DCF_TYPE_COMPACT_STRUCT) {
+        return DCF_SER_ERR_MALFORMED;
+    }
+    
+    DCF_SER_CHECK(writer_put_u8(w, 0));    /* Extension terminator */
+    DCFSerHeldFrame f = w->held[--w->held_depth];
+    w->depth--;
+    size_t body = w->position - (f.start + COMPACT_HEADER_SIZE);
+    if (body > UINT32_MAX) return DCF_SER_ERR_TOO_LARGE;
+    
+    uint32_t net = dcf_ser_hton32((uint32_t)body);
+    memcpy(w->buffer + f.start + 3, &net, 4);
+    return DCF_SER_OK;
+}
+
+DCFSerError dcf_ser_write_struct_compact(DCFSerWriter* w, const void* data,
+                                         const DCFSerSchema* schema) {
+    DCF_SER_CHECK(dcf_ser_write_compact_struct_begin(w, data, schema));
+    return dcf_ser_write_compact_struct_end(w);
+}
+
+DCFSerError dcf_ser_read_compact_struct_begin(DCFSerReader* r, void* data,
+                                              const DCFSerSchema* schema) {
+    if (!r || !data || !schema) return DCF_SER_ERR_NULL_PTR;
+    if (r->iov) return DCF_SER_ERR_INVALID_ARG;
+    if (r->depth >= r->limits.max_depth) return DCF_SER_ERR_DEPTH_EXCEEDED;
+    DCF_SER_CHECK(tagless_schema_check(schema));
+    
+    DCF_SER_CHECK(reader_expect_type(r, DCF_TYPE_COMPACT_STRUCT));
+    uint16_t type_id;
+    uint32_t body;
+    DCF_SER_CHECK(reader_get_u16(r, &type_id));
+    DCF_SER_CHECK(reader_get_u32(r, &body));
+    if (type_id != schema->type_id) {
+        r->last_error = DCF_SER_ERR_TYPE_MISMATCH;
+        return DCF_SER_ERR_TYPE_MISMATCH;
+    }
+    READER_ENSURE_BYTES(r, body);
+    
+    size_t body_end = r->position + body;
+    uint64_t known, n;
+    DCF_SER_CHECK(reader_get_varint(r, &known));
+    if (known > body_end - r->position) return DCF_SER_ERR_MALFORMED;
+    size_t known_end = r->position + known;
+    DCF_SER_CHECK(reader_get_varint(r, &n));
+    if ((n + 7) / 8 > known_end - r->position) return DCF_SER_ERR_MALFORMED;
+    const uint8_t* bitmap = r->buffer + r->position;
+    r->position += (n + 7) / 8;
+    
+    /* Keep the schema section bounded while decoding it */
+    size_t saved_end = r->payload_end;
+    r->payload_end = known_end;
+    schema_init_defaults(data, schema, false);
+    
+    DCFSerError err = DCF_SER_OK;
+    size_t fields = n < schema->field_count ? (size_t)n : schema->field_count;
+    for (size_t i = 0; i < fields && err == DCF_SER_OK; i++) {
+        if (!(bitmap[i / 8] & (1u << (i % 8)))) continue;
+        const DCFSerField* field = &schema->fields[i];
+        uint8_t* dst = (uint8_t*)data + field->offset;
+        
+        err = tagless_get(r, field, dst);
+    }
+    
+    r->payload_end = saved_end;
+    if (err == DCF_SER_ERR_TRUNCATED) err = DCF_SER_ERR_MALFORMED;
+    if (err != DCF_SER_OK) {
+        r->last_error = err;
+        return err;
+    }
+    
+    /* Fields from a newer schema are skipped with the rest of the section;
+     * extensions stay bounded by the body until _end */
+    r->position = known_end;
+    r->outer_end[r->depth++] = r->payload_end;
+    r->payload_end = body_end;
+    return DCF_SER_OK;
+}
+
+DCFSerError dcf_ser_read_compact_ext(DCFSerReader* r, uint16_t* out_field_id) {
+    if (!r || !out_field_id) return DCF_SER_ERR_NULL_PTR;
+    r->mark = r->position;
+    uint64_t id;
+    DCF_SER_CHECK(reader_get_varint(r, &id));
+    if (id == 0) {
+        r->position = r->mark;   /* Leave the terminator for _end */
+        return DCF_SER_ERR_NOT_FOUND;
+    }
+    if (id > UINT16_MAX) return DCF_SER_ERR_MALFORMED;
+    *out_field_id = (uint16_t)id;
+    return DCF_SER_OK;
+}
+
+DCFSerError dcf_ser_read_compact_struct_end(DCFSerReader* r) {
+    if (!r) return DCF_SER_ERR_NULL_PTR;
+    if (r->depth == 0) return DCF_SER_ERR_MALFORMED;
+    
+    /* Skip any extensions the caller did not read */
+    while (true) {
+        uint16_t field_id;
+        DCFSerError err = dcf_ser_read_compact_ext(r, &field_id);
+        if (err == DCF_SER_ERR_NOT_FOUND) break;
+        if (err == DCF_SER_OK) err = reader_skip_value(r);
+        if (err == DCF_SER_ERR_TRUNCATED) err = DCF_SER_ERR_MALFORMED;
+        if (err != DCF_SER_OK) {
+            r->last_error = err;
+            return err;
+        }
+    }
+    /* The terminator must close the body exactly */
+    if (++r->position != r->payload_end) {
+        r->last_error = DCF_SER_ERR_MALFORMED;
+        return DCF_SER_ERR_MALFORMED;
+    }
+    r->payload_end = r->outer_end[--r->depth];
+    return DCF_SER_OK;
+}
+
+DCFSerError dcf_ser_read_struct_compact(DCFSerReader* r, void* data, const DCFSerSchema* schema) {
+    DCF_SER_CHECK(dcf_ser_read_compact_struct_begin(r, data, schema));
+    return dcf_ser_read_compact_struct_end(r);
+}
+
+/* ============================================================================
+ * Schema Fingerprints and Tagless Structs
+ * ============================================================================ */
+
+#define SCHEMA_REF_HEADER_SIZE 13   /* tag, fingerprint u64, body length u32 */
+
+#define FNV64_OFFSET 0xCBF29CE484222325ULL
+#define FNV64_PRIME  0x00000100000001B3ULL
+
+static uint64_t fnv64_byte(uint64_t h, uint8_t b) {
+    return (h ^ b) * FNV64_PRIME;
+}
+
+uint64_t dcf_ser_schema_fingerprint(const DCFSerSchema* schema) {
+    if (!schema) return 0;
+    
+    /* Only what shapes the wire: type id, field order, ids, types, flags */
+    uint64_t h = FNV64_OFFSET;
+    h = fnv64_byte(h, (uint8_t)(schema->type_id >> 8));
+    h = fnv64_byte(h, (uint8_t)schema->type_id);
+    for (size_t i = 0; i < schema->field_count; i++) {
+        const DCFSerField* field = &schema->fields[i];
+        h = fnv64_byte(h, (uint8_t)(field->field_id >> 8));
+        h = fnv64_byte(h, (uint8_t)field->field_id);
+        h = fnv64_byte(h, field->type);
+        h = fnv64_byte(h, field->flags);
+    }
+    return h;
+}
+
+/* ----------------------------------------------------------------------------
+ * Registry
+ * 
+ * Lookups read an immutable table through one acquire load. Publishers
+ * serialize on a spinlock, build a new table and swap it in with a release
+ * store; the table it replaces is retired, not freed, until
+ * dcf_ser_registry_reclaim.
+ * ---------------------------------------------------------------------------- */
+
+#if defined(__GNUC__) || defined(__clang__)
+    #define REGISTRY_LOAD(p)        __atomic_load_n(&(p), __ATOMIC_ACQUIRE)
+    #define REGISTRY_STORE(p, v)    __atomic_store_n(&(p), (v), __ATOMIC_RELEASE)
+    #define REGISTRY_LOCK(l)        while (__atomic_exchange_n(&(l), 1, __ATOMIC_ACQUIRE))
+    #define REGISTRY_UNLOCK(l)      __atomic_store_n(&(l), 0, __ATOMIC_RELEASE)
+#elif defined(_MSC_VER)
+    #define REGISTRY_LOAD(p)        ((DCFSerRegistryTable*)InterlockedCompareExchangePointer( \
+                                        (PVOID volatile*)&(p), NULL, NULL))
+    #define REGISTRY_STORE(p, v)    InterlockedExchangePointer((PVOID volatile*)&(p), (v))
+    #define REGISTRY_LOCK(l)        while (InterlockedExchange((volatile LONG*)&(l), 1))
+    #define REGISTRY_UNLOCK(l)      InterlockedExchange((volatile LONG*)&(l), 0)
+#else
+    /* <stdatomic.h> needs _Atomic objects; the registry fields are plain */
+    #error "dcf_serialize: schema registry needs GCC/Clang __atomic or MSVC Interlocked builtins"
+#endif
+
+#define REGISTRY_EMPTY UINT32_MAX
+
+struct DCFSerRegistryTable {
+    DCFSerRegistryTable* retired;   /* Next retired table */
+    size_t      count;              /* Schemas, oldest publication first */
+    size_t      mask;               /* Hash slots - 1 */
+    const DCFSerSchema** schemas;
+    uint64_t*   fingerprints;
+    uint32_t*   by_type;            /* Slot -> newest schema for a type id */
+    uint32_t*   by_fp;              /* Slot -> schema with a fingerprint */
+};
+
+static size_t registry_hash_type(uint16_t type_id, size_t mask) {
+    return ((uint32_t)type_id * 0x9E3779B1u >> 16) & mask;
+}
+
+static size_t registry_hash_fp(uint64_t fp, size_t mask) {
+    return (size_t)(fp ^ (fp >> 29)) & mask;
+}
+
+/* Build a table from an ordered schema list (one allocation) */
+static DCFSerRegistryTable* registry_build(const DCFSerSchema* const* schemas,
+                                           const uint64_t* fps, size_t count) {
+    size_t slots = 16;
+    while (slots < count * 2) slots *= 2;
+    
+    size_t size = sizeof(DCFSerRegistryTable) + count * sizeof(uint64_t) +
+                  count * sizeof(DCFSerSchema*) + 2 * slots * sizeof(uint32_t);
+    DCFSerRegistryTable* t = malloc(size);
+    if (!t) return NULL;
+    t->retired = NULL;
+    t->count = count;
+    t->mask = slots - 1;
+    t->fingerprints = (uint64_t*)(t + 1);
+    t->schemas = (const DCFSerSchema**)(t->fingerprints + count);
+    t->by_type = (uint32_t*)(t->schemas + count);
+    t->by_fp = t->by_type + slots;
+    memset(t->by_type, 0xFF, 2 * slots * sizeof(uint32_t));
+    
+    for (size_t i = 0; i < count; i++) {
+        t->schemas[i] = schemas[i];
+        t->fingerprints[i] = fps[i];
+        
+        /* Later publications of a type id take over its slot */
+        size_t h = registry_hash_type(schemas[i]->type_id, t->mask);
+        while (t->by_type[h] != REGISTRY_EMPTY &&
+               t->schemas[t->by_type[h]]->type_id != schemas[i]->type_id) {
+            h = (h + 1) & t->mask;
+        }
+        t->by_type[h] = (uint32_t)i;
+        
+        h = registry_hash_fp(fps[i], t->mask);
+        while (t->by_fp[h] != REGISTRY_EMPTY) h = (h + 1) & t->mask;
+        t->by_fp[h] = (uint32_t)i;
+    }
+    return t;
+}
+
+static long registry_slot_fp(const DCFSerRegistryTable* t, uint64_t fp) {
+    for (size_t h = registry_hash_fp(fp, t->mask); t->by_fp[h] != REGISTRY_EMPTY;
+         h = (h + 1) & t->mask) {
+        if (t->fingerprints[t->by_fp[h]] == fp) return (long)t->by_fp[h];
+    }
+    return -1;
+}
+
+DCFSerError dcf_ser_registry_init(DCFSerRegistry* reg) {
+    if (!reg) return DCF_SER_ERR_NULL_PTR;
+    memset(reg, 0, sizeof(*reg));
+    return DCF_SER_OK;
+}
+
+void dcf_ser_registry_destroy(DCFSerRegistry* reg) {
+    if (!reg) return;
+    dcf_ser_registry_reclaim(reg);
+    free(reg->table);
+    memset(reg, 0, sizeof(*reg));
+}
+
+DCFSerError dcf_ser_registry_add(DCFSerRegistry* reg, const DCFSerSchema* schema) {
+    if (!reg || !schema) return DCF_SER_ERR_NULL_PTR;
+    if (!schema->fields && schema->field_count > 0) return DCF_SER_ERR_NULL_PTR;
+    uint64_t fp = dcf_ser_schema_fingerprint(schema);
+    
+    REGISTRY_LOCK(reg->lock);
+    DCFSerRegistryTable* old = reg->table;
+    size_t count = old ? old->count : 0;
+    if (count >= REGISTRY_EMPTY - 1) {
+        REGISTRY_UNLOCK(reg->lock);
+        return DCF_SER_ERR_TOO_LARGE;
+    }
+    
+    /* Republishing a known fingerprint moves it to the newest position */
+    const DCFSerSchema** schemas = malloc((count + 1) * sizeof(*schemas));
+    uint64_t* fps = malloc((count + 1) * sizeof(*fps));
+    DCFSerRegistryTable* t = NULL;
+    if (schemas && fps) {
+        size_t n = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (old->fingerprints[i] == fp) continue;
+            schemas[n] = old->schemas[i];
+            fps[n++] = old->fingerprints[i];
+        }
+        schemas[n] = schema;
+        fps[n++] = fp;
+        t = registry_build(schemas, fps, n);
+    }
+    free((void*)schemas);
+    free(fps);
+    if (!t) {
+        REGISTRY_UNLOCK(reg->lock);
+        return DCF_SER_ERR_ALLOC_FAIL;
+    }
+    
+    REGISTRY_STORE(reg->table, t);
+    if (old) {
+        old->retired = reg->retired;
+        reg->retired = old;
+    }
+    REGISTRY_UNLOCK(reg->lock);
+    return DCF_SER_OK;
+}
+
+void dcf_ser_registry_reclaim(DCFSerRegistry* reg) {
+    if (!reg) return;
+    REGISTRY_LOCK(reg->lock);
+    DCFSerRegistryTable* t = reg->retired;
+    reg->retired = NULL;
+    REGISTRY_UNLOCK(reg->lock);
+    
+    while (t) {
+        DCFSerRegistryTable* next = t->retired;
+        free(t);
+        t = next;
+    }
+}
+
+const DCFSerSchema* dcf_ser_registry_find(const DCFSerRegistry* reg, uint64_t fingerprint) {
+    if (!reg) return NULL;
+    const DCFSerRegistryTable* t = REGISTRY_LOAD(reg->table);
+    if (!t) return NULL;
+    long i = registry_slot_fp(t, fingerprint);
+    return i < 0 ? NULL : t->schemas[i];
+}
+
+const DCFSerSchema* dcf_ser_registry_find_type(const DCFSerRegistry* reg, uint16_t type_id) {
+    if (!reg) return NULL;
+    const DCFSerRegistryTable* t = REGISTRY_LOAD(reg->table);
+    if (!t) return NULL;
+    for (size_t h = registry_hash_type(type_id, t->mask); t->by_type[h] != REGISTRY_EMPTY;
+         h = (h + 1) & t->mask) {
+        const DCFSerSchema* s = t->schemas[t->by_type[h]];
+        if (s->type_id == type_id) return s;
+    }
+    return NULL;
+}
+
+size_t dcf_ser_registry_count(const DCFSerRegistry* reg) {
+    if (!reg) return 0;
+    const DCFSerRegistryTable* t = REGISTRY_LOAD(reg->table);
+    return t ? t->count : 0;
+}
+
+DCFSerRegistry* dcf_ser_registry_global(void) {
+    static DCFSerRegistry global;   /* Zero state is an empty registry */
+    return &global;
+}
+
+DCFSerError dcf_ser_write_struct_tagless(DCFSerWriter* w, const void* data,
+                                         const DCFSerSchema* schema) {
+    if (!w || !data || !schema) return DCF_SER_ERR_NULL_PTR;
+    if (!schema->fields && schema->field_count > 0) return DCF_SER_ERR_NULL_PTR;
+    
+    size_t body = 0;
+    for (size_t i = 0; i < schema->field_count; i++) {
+        const DCFSerField* field = &schema->fields[i];
+        size_t size = compact_value_size(field, (const uint8_t*)data + field->offset);
+        if (size == 0) return DCF_SER_ERR_INVALID_TYPE;
+        body += size;
+    }
+    if (body > UINT32_MAX) return DCF_SER_ERR_TOO_LARGE;
+    
+    WRITER_ENSURE_SPACE(w, SCHEMA_REF_HEADER_SIZE + body);
+    DCF_SER_CHECK(writer_put_u8(w, DCF_TYPE_SCHEMA_REF));
+    DCF_SER_CHECK(writer_put_u64(w, dcf_ser_schema_fingerprint(schema)));
+    DCF_SER_CHECK(writer_put_u32(w, (uint32_t)body));
+    for (size_t i = 0; i < schema->field_count; i++) {
+        const DCFSerField* field = &schema->fields[i];
+        DCF_SER_CHECK(tagless_put(w, field, (const uint8_t*)data + field->offset));
+    }
+    return DCF_SER_OK;
+}
+
+DCFSerError dcf_ser_write_struct_negotiated(DCFSerWriter* w, const void* data,
+                                            const DCFSerSchema* schema,
+                                            const DCFSerRegistry* peer) {
+    if (!schema) return DCF_SER_ERR_NULL_PTR;
+    if (peer && dcf_ser_registry_find(peer, dcf_ser_schema_fingerprint(schema))) {
+        return dcf_ser_write_struct_tagless(w, data, schema);
+    }
+    return dcf_ser_write_struct_schema(w, data, schema);
+}
+
+/* Decode a tagless body of the given length (reader just past the header) */
+static DCFSerError tagless_decode(DCFSerReader* r, void* data, const DCFSerSchema* schema,
+                                  uint32_t body) {
+    READER_ENSURE_BYTES(r, body);
+    size_t saved_end = r->payload_end;
+    r->payload_end = r->position + body;
+    memset(data, 0, schema->struct_size);
+    
+    DCFSerError err = DCF_SER_OK;
+    for (size_t i = 0; i < schema->field_count && err == DCF_SER_OK; i++) {
+        const DCFSerField* field = &schema->fields[i];
+        err = tagless_get(r, field, (uint8_t*)data + field->offset);
+    }
+    if (err == DCF_SER_OK && r->position != r->payload_end) err = DCF_SER_ERR_MALFORMED;
+    
+    r->payload_end = saved_end;
+    if (err == DCF_SER_ERR_TRUNCATED) err = DCF_SER_ERR_MALFORMED;
+    if (err != DCF_SER_OK) r->last_error = err;
+    return err;
+}
+
+DCFSerError dcf_ser_read_struct_tagless(DCFSerReader* r, void* data,
+                                        const DCFSerSchema* schema) {
+    if (!r || !data || !schema) return DCF_SER_ERR_NULL_PTR;
+    if (r->iov) return DCF_SER_ERR_INVALID_ARG;
+    DCF_SER_CHECK(tagless_schema_check(schema));
+    
+    DCF_SER_CHECK(reader_expect_type(r, DCF_TYPE_SCHEMA_REF));
+    uint64_t fp;
+    uint32_t body;
+    DCF_SER_CHECK(reader_get_u64(r, &fp));
+    DCF_SER_CHECK(reader_get_u32(r, &body));
+    if (fp != dcf_ser_schema_fingerprint(schema)) {
+        r->position = r->mark;
+        r->last_error = DCF_SER_ERR_TYPE_MISMATCH;
+        return DCF_SER_ERR_TYPE_MISMATCH;
+    }
+    return tagless_decode(r, data, schema, body);
+}
+
+DCFSerError dcf_ser_read_struct_registered(DCFSerReader* r, const DCFSerRegistry* reg,
+                                           void* data, const DCFSerSchema** out_schema) {
+    if (!r || !reg || !data) return DCF_SER_ERR_NULL_PTR;
+    if (r->iov) return DCF_SER_ERR_INVALID_ARG;
+    
+    /* Peek far enough to identify the schema without consuming anything */
+    size_t avail = r->payload_end - r->position;
+    if (avail < 1) return DCF_SER_ERR_TRUNCATED;
+    const uint8_t* p = r->buffer + r->position;
+    const DCFSerSchema* schema;
+    
+    if (p[0] == DCF_TYPE_SCHEMA_REF) {
+        if (avail < SCHEMA_REF_HEADER_SIZE) return DCF_SER_ERR_TRUNCATED;
+        uint64_t fp = 0;
+        for (int i = 1; i <= 8; i++) fp = (fp << 8) | p[i];
+        schema = dcf_ser_registry_find(reg, fp);
+        if (!schema) return DCF_SER_ERR_NOT_FOUND;
+        /* The fingerprint is public: anyone can address a schema with members
+         * the tagless codec cannot carry */
+        DCF_SER_CHECK(tagless_schema_check(schema));
+        if (out_schema) *out_schema = schema;
+        r->mark = r->position;
+        r->position += SCHEMA_REF_HEADER_SIZE;
+        uint32_t body = ((uint32_t)p[9] << 24) | ((uint32_t)p[10] << 16) |
+                        ((uint32_t)p[11] << 8) | p[12];
+        return tagless_decode(r, data, schema, body);
+    }
+    
+    /* Self-describing fallback */
+    if (p[0] != DCF_TYPE_STRUCT) return DCF_SER_ERR_TYPE_MISMATCH;
+    if (avail < 3) return DCF_SER_ERR_TRUNCATED;
+    schema = dcf_ser_registry_find_type(reg, (uint16_t)((p[1] << 8) | p[2]));
+    if (!schema) return DCF_SER_ERR_NOT_FOUND;
+    if (out_schema) *out_schema = schema;
+    return dcf_ser_read_struct_schema(r, data, schema);
+}
+
+/* ============================================================================
+ * Schema Evolution Plans
+ * ============================================================================ */
+
+enum {
+    PLAN_SKIP  = 0,     /* Writer-only field */
+    PLAN_COPY  = 1,     /* Same type on both sides */
+    PLAN_WIDEN = 2,     /* Lossless numeric conversion */
+};
+
+/* Bits of an integer type; negative for signed, 0 for anything else */
+static int plan_int_bits(uint8_t type) {
+    switch (type) {
+        case DCF_TYPE_U8:     return 8;
+        case DCF_TYPE_U16:    return 16;
+        case DCF_TYPE_U32:    return 32;
+        case DCF_TYPE_U64:
+        case DCF_TYPE_VARINT: return 64;
+        case DCF_TYPE_I8:     return -8;
+        case DCF_TYPE_I16:    return -16;
+        case DCF_TYPE_I32:    return -32;
+        case DCF_TYPE_I64:    return -64;
+        default:              return 0;
+    }
+}
+
+/* True if every value of `from` is exactly representable as `to` */
+static bool plan_can_widen(uint8_t from, uint8_t to) {
+    int fb = plan_int_bits(from), tb = plan_int_bits(to);
+    if (fb != 0) {
+        int fw = fb < 0 ? -fb : fb;
+        if (tb > 0) return fb > 0 && tb >= fw;
+        if (tb < 0) return -tb > fw;
+        if (to == DCF_TYPE_F64) return fw <= 32;
+        if (to == DCF_TYPE_F32) return fw <= 16;
+        return false;
+    }
+    return from == DCF_TYPE_F32 && to == DCF_TYPE_F64;
+}
+
+typedef union {
+    uint64_t u;
+    int64_t  i;
+    double   f;
+} PlanValue;
+
+/* Read an untagged numeric value into its widest form */
+static DCFSerError plan_load(DCFSerReader* r, uint8_t type, PlanValue* v) {
+    switch (type) {
+        case DCF_TYPE_U8:  { uint8_t x;  DCF_SER_CHECK(reader_get_u8(r, &x));  v->u = x; break; }
+        case DCF_TYPE_U16: { uint16_t x; DCF_SER_CHECK(reader_get_u16(r, &x)); v->u = x; break; }
+        case DCF_TYPE_U32: { uint32_t x; DCF_SER_CHECK(reader_get_u32(r, &x)); v->u = x; break; }
+        case DCF_TYPE_U64: return reader_get_u64(r, &v->u);
+        case DCF_TYPE_VARINT: return reader_get_varint(r, &v->u);
+        case DCF_TYPE_I8:  { uint8_t x;  DCF_SER_CHECK(reader_get_u8(r, &x));  v->i = (int8_t)x; break; }
+        case DCF_TYPE_I16: { uint16_t x; DCF_SER_CHECK(reader_get_u16(r, &x)); v->i = (int16_t)x; break; }
+        case DCF_TYPE_I32: { uint32_t x; DCF_SER_CHECK(reader_get_u32(r, &x)); v->i = (int32_t)x; break; }
+        case DCF_TYPE_I64: { uint64_t x; DCF_SER_CHECK(reader_get_u64(r, &x)); v->i = (int64_t)x; break; }
+        case DCF_TYPE_F32: {
+            uint32_t bits;
+            float f;
+            DCF_SER_CHECK(reader_get_u32(r, &bits));
+            memcpy(&f, &bits, 4);
+            v->f = f;
+            break;
+        }
+        default:
+            return DCF_SER_ERR_INVALID_TYPE;
+    }
+    return DCF_SER_OK;
+}
+
+/* Store a loaded value as the reader's (wider) type */
+static void plan_store(uint8_t* dst, uint8_t to, uint8_t from, PlanValue v) {
+    bool is_signed = plan_int_bits(from) < 0;
+    bool is_float = from == DCF_TYPE_F32;
+    switch (to) {
+        case DCF_TYPE_U16: *(uint16_t*)dst = (uint16_t)v.u; break;
+        case DCF_TYPE_U32: *(uint32_t*)dst = (uint32_t)v.u; break;
+        case DCF_TYPE_U64:
+        case DCF_TYPE_VARINT: *(uint64_t*)dst = v.u; break;
+        case DCF_TYPE_I16: *(int16_t*)dst = (int16_t)(is_signed ? v.i : (int64_t)v.u); break;
+        case DCF_TYPE_I32: *(int32_t*)dst = (int32_t)(is_signed ? v.i : (int64_t)v.u); break;
+        case DCF_TYPE_I64: *(int64_t*)dst = is_signed ? v.i : (int64_t)v.u; break;
+        case DCF_TYPE_F32: *(float*)dst = (float)(is_signed ? (double)v.i : (double)v.u); break;
+        case DCF_TYPE_F64:
+            *(double*)dst = is_float ? v.f : is_signed ? (double)v.i : (double)v.u;
+            break;
+        default: break;
+    }
+}
+
+static int plan_lookup_cmp(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a >> 16, y = *(const uint32_t*)b >> 16;
+    return (x > y) - (x < y);
+}
+
+/* Reader field index for a field id, or -1 */
+static int plan_lookup(const DCFSerPlan* plan, uint16_t field_id) {
+    size_t lo = 0, hi = plan->reader->field_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        uint16_t id = (uint16_t)(plan->lookup[mid] >> 16);
+        if (id == field_id) return (int)(plan->lookup[mid] & 0xFFFF);
+        if (id < field_id) lo = mid + 1; else hi = mid;
+    }
+    return -1;
+}
+
+DCFSerError dcf_ser_schema_resolve(DCFSerPlan* plan, const DCFSerSchema* writer,
+                                   const DCFSerSchema* reader) {
+    if (!plan || !writer || !reader) return DCF_SER_ERR_NULL_PTR;
+    if ((!writer->fields && writer->field_count > 0) ||
+        (!reader->fields && reader->field_count > 0)) {
+        return DCF_SER_ERR_NULL_PTR;
+    }
+    if (reader->field_count > UINT16_MAX) return DCF_SER_ERR_TOO_LARGE;
+    memset(plan, 0, sizeof(*plan));
+    plan->writer = writer;
+    plan->reader = reader;
+    plan->writer_fingerprint = dcf_ser_schema_fingerprint(writer);
+    
+    plan->steps = calloc(writer->field_count ? writer->field_count : 1, sizeof(*plan->steps));
+    plan->lookup = calloc(reader->field_count ? reader->field_count : 1, sizeof(*plan->lookup));
+    plan->defaults = calloc(1, reader->struct_size ? reader->struct_size : 1);
+    if (!plan->steps || !plan->lookup || !plan->defaults) {
+        dcf_ser_plan_destroy(plan);
+        return DCF_SER_ERR_ALLOC_FAIL;
+    }
+    
+    for (size_t i = 0; i < reader->field_count; i++) {
+        if (!tagless_type_ok(reader->fields[i].type)) {
+            dcf_ser_plan_destroy(plan);
+            return DCF_SER_ERR_INVALID_TYPE;
+        }
+        plan->lookup[i] = ((uint32_t)reader->fields[i].field_id << 16) | (uint32_t)i;
+    }
+    qsort(plan->lookup, reader->field_count, sizeof(*plan->lookup), plan_lookup_cmp);
+    schema_init_defaults(plan->defaults, reader, false);
+    
+    for (size_t i = 0; i < writer->field_count; i++) {
+        const DCFSerField* wf = &writer->fields[i];
+        DCFSerPlanStep* step = &plan->steps[i];
+        if (!tagless_type_ok(wf->type)) {
+            dcf_ser_plan_destroy(plan);
+            return DCF_SER_ERR_INVALID_TYPE;
+        }
+        step->wire_type = wf->type;
+        step->target = -1;
+        step->op = PLAN_SKIP;
+        
+        int target = plan_lookup(plan, wf->field_id);
+        if (target < 0) continue;
+        const DCFSerField* rf = &reader->fields[target];
+        if (rf->type == wf->type) {
+            step->op = PLAN_COPY;
+        } else if (plan_can_widen(wf->type, rf->type)) {
+            step->op = PLAN_WIDEN;
+        } else {
+            dcf_ser_plan_destroy(plan);
+            return DCF_SER_ERR_TYPE_MISMATCH;
+        }
+        step->target = target;
+    }
+    return DCF_SER_OK;
+}
+
+void dcf_ser_plan_destroy(DCFSerPlan* plan) {
+    if (!plan) return;
+    free(plan->steps);
+    free(plan->lookup);
+    free(plan->defaults);
+    memset(plan, 0, sizeof(*plan));
+}
+
+/* Tagless body written with plan->writer (reader just past the header) */
+static DCFSerError plan_decode_tagless(DCFSerReader* r, uint8_t* data, const DCFSerPlan* plan,
+                                       uint32_t body) {
+    READER_ENSURE_BYTES(r, body);
+    size_t saved_end = r->payload_end;
+    r->payload_end = r->position + body;
+    
+    DCFSerError err = DCF_SER_OK;
+    const DCFSerField* rfields = plan->reader->fields;
+    for (size_t i = 0; i < plan->writer->field_count && err == DCF_SER_OK; i++) {
+        const DCFSerPlanStep* step = &plan->steps[i];
+        switch (step->op) {
+            case PLAN_COPY: {
+                const DCFSerField* rf = &rfields[step->target];
+                err = tagless_get(r, rf, data + rf->offset);
+                break;
+            }
+            case PLAN_WIDEN: {
+                PlanValue v;
+                err = plan_load(r, step->wire_type, &v);
+                if (err == DCF_SER_OK) {
+                    const DCFSerField* rf = &rfields[step->target];
+                    plan_store(data + rf->offset, rf->type, step->wire_type, v);
+                }
+                break;
+            }
+            default: {
+                uint64_t scratch;
+                err = tagless_get(r, &plan->writer->fields[i], (uint8_t*)&scratch);
+                break;
+            }
+        }
+    }
+    if (err == DCF_SER_OK && r->position != r->payload_end) err = DCF_SER_ERR_MALFORMED;
+    
+    r->payload_end = saved_end;
+    if (err == DCF_SER_ERR_TRUNCATED) err = DCF_SER_ERR_MALFORMED;
+    return err;
+}
+
+/* Self-describing struct: fields matched by id, converted from their tag */
+static DCFSerError plan_decode_tagged(DCFSerReader* r, uint8_t* data, const DCFSerPlan* plan) {
+    while (true) {
+        uint16_t field_id;
+        DCFSerType type;
+        DCFSerError err = dcf_ser_read_field(r, &field_id, &type);
+        if (err == DCF_SER_ERR_NOT_FOUND) break;
+        if (err != DCF_SER_OK) return err;
+        
+        int target = plan_lookup(plan, field_id);
+        const DCFSerField* rf = target >= 0 ? &plan->reader->fields[target] : NULL;
+        if (!rf || rf->type == DCF_TYPE_STRING ||
+            (rf->type != type && !plan_can_widen(type, rf->type))) {
+            DCF_SER_CHECK(dcf_ser_reader_skip(r));
+            continue;
+        }
+        
+        /* Numeric payloads are the untagged encoding behind the tag */
+        DCF_SER_CHECK(reader_expect_type(r, type));
+        if (rf->type == type) {
+            DCF_SER_CHECK(tagless_get(r, rf, data + rf->offset));
+        } else {
+            PlanValue v;
+            DCF_SER_CHECK(plan_load(r, type, &v));
+            plan_store(data + rf->offset, rf->type, type, v);
+        }
+    }
+    return dcf_ser_read_struct_end(r);
+}
+
+DCFSerError dcf_ser_read_struct_plan(DCFSerReader* r, void* data, const DCFSerPlan* plan) {
+    if (!r || !data || !plan || !plan->steps) return DCF_SER_ERR_NULL_PTR;
+    if (r->iov) return DCF_SER_ERR_INVALID_ARG;
+    
+    DCFSerType type = dcf_ser_reader_peek_type(r);
+    DCFSerError err;
+    if (type == DCF_TYPE_SCHEMA_REF) {
+        uint64_t fp;
+        uint32_t body;
+        DCF_SER_CHECK(reader_expect_type(r, DCF_TYPE_SCHEMA_REF));
+        DCF_SER_CHECK(reader_get_u64(r, &fp));
+        DCF_SER_CHECK(reader_get_u32(r, &body));
+        if (fp != plan->writer_fingerprint) {
+            r->position = r->mark;
+            r->last_error = DCF_SER_ERR_TYPE_MISMATCH;
+            return DCF_SER_ERR_TYPE_MISMATCH;
+        }
+        memcpy(data, plan->defaults, plan->reader->struct_size);
+        err = plan_decode_tagless(r, data, plan, body);
+    } else {
+        uint16_t type_id;
+        DCF_SER_CHECK(dcf_ser_read_struct_begin(r, &type_id));
+        if (type_id != plan->reader->type_id && type_id != plan->writer->type_id) {
+            return DCF_SER_ERR_TYPE_MISMATCH;
+        }
+        memcpy(data, plan->defaults, plan->reader->struct_size);
+        err = plan_decode_tagged(r, data, plan);
+    }
+    if (err != DCF_SER_OK) r->last_error = err;
+    return err;
+}
+
+/* ============================================================================
+ * Projected Decoding
+ * ============================================================================ */
+
+/* Requested schema fields, in schema order */
+typedef struct {
+    const DCFSerField* fields[64];
+    size_t count;
+    size_t last;        /* Schema index of the last requested field */
+} Projection;
+
+static void projection_init(Projection* p, const DCFSerSchema* schema, uint64_t mask) {
+    p->count = 0;
+    p->last = 0;
+    size_t n = schema->field_count < 64 ? schema->field_count : 64;
+    for (size_t i = 0; i < n; i++) {
+        if (mask & ((uint64_t)1 << i)) {
+            p->fields[p->count++] = &schema->fields[i];
+            p->last = i;
+        }
+    }
+}
+
+/* Tagged struct: stop looking up fields once every requested one is seen */
+static DCFSerError projected_struct(DCFSerReader* r, uint8_t* data, const DCFSerSchema* schema,
+                                    Projection* p) {
+    uint16_t type_id;
+    DCF_SER_CHECK(dcf_ser_read_struct_begin(r, &type_id));
+    if (type_id != schema->type_id) return DCF_SER_ERR_TYPE_MISMATCH;
+    
+    size_t pending = p->count;
+    while (true) {
+        uint16_t field_id;
+        DCFSerType type;
+        DCFSerError err = dcf_ser_read_field(r, &field_id, &type);
+        if (err == DCF_SER_ERR_NOT_FOUND) break;
+        if (err != DCF_SER_OK) return err;
+        
+        if (pending > 0) {
+            size_t i = 0;
+            while (i < pending && p->fields[i]->field_id != field_id) i++;
+            if (i < pending) {
+                const DCFSerField* field = p->fields[i];
+                DCF_SER_CHECK(schema_read_value(r, field, data + field->offset, NULL));
+                p->fields[i] = p->fields[--pending];
+                continue;
+            }
+        }
+        DCF_SER_CHECK(reader_skip_value(r));
+    }
+    return dcf_ser_read_struct_end(r);
+}
+
+/* Table: one slot lookup per requested field, then skip the whole table */
+static DCFSerError projected_table(DCFSerReader* r, uint8_t* data, const DCFSerSchema* schema,
+                                   const Projection* p) {
+    uint16_t type_id, max_field_id;
+    DCF_SER_CHECK(dcf_ser_table_info(r, &type_id, &max_field_id));
+    if (type_id != schema->type_id) return DCF_SER_ERR_TYPE_MISMATCH;
+    
+    for (size_t i = 0; i < p->count; i++) {
+        const DCFSerField* field = p->fields[i];
+        DCFSerReader value;
+        DCFSerError err = dcf_ser_table_field(r, field->field_id, &value);
+        if (err == DCF_SER_ERR_NOT_FOUND) continue;
+        if (err != DCF_SER_OK) return err;
+        DCF_SER_CHECK(schema_read_value(&value, field, data + field->offset, NULL));
+    }
+    return reader_skip_value(r);
+}
+
+/* Tagless value: positional up to the last requested field, then jump */
+static DCFSerError projected_tagless(DCFSerReader* r, uint8_t* data, const DCFSerSchema* schema,
+                                     uint64_t mask, const Projection* p) {
+    DCF_SER_CHECK(reader_expect_type(r, DCF_TYPE_SCHEMA_REF));
+    uint64_t fp;
+    uint32_t body;
+    DCF_SER_CHECK(reader_get_u64(r, &fp));
+    DCF_SER_CHECK(reader_get_u32(r, &body));
+    if (fp != dcf_ser_schema_fingerprint(schema)) {
+        r->position = r->mark;
+        return DCF_SER_ERR_TYPE_MISMATCH;
+    }
+    READER_ENSURE_BYTES(r, body);
+    size_t body_end = r->position + body;
+    size_t saved_end = r->payload_end;
+    r->payload_end = body_end;
+    
+    DCFSerError err = DCF_SER_OK;
+    for (size_t i = 0; p->count > 0 && i <= p->last && err == DCF_SER_OK; i++) {
+        const DCFSerField* field = &schema->fields[i];
+        if (mask & ((uint64_t)1 << i)) {
+            err = tagless_get(r, field, data + field->offset);
+        } else {
+            uint64_t scratch;
+            err = tagless_get(r, field, (uint8_t*)&scratch);
+        }
+    }
+    
+    r->payload_end = saved_end;
+    if (err == DCF_SER_ERR_TRUNCATED) err = DCF_SER_ERR_MALFORMED;
+    if (err != DCF_SER_OK) return err;
+    r->position = body_end;
+    return DCF_SER_OK;
+}
+
+DCFSerError dcf_ser_read_struct_projected(DCFSerReader* r, void* data,
+                                          const DCFSerSchema* schema, uint64_t field_mask) {
+    if (!r || !data || !schema) return DCF_SER_ERR_NULL_PTR;
+    if (!schema->fields && schema->field_count > 0) return DCF_SER_ERR_NULL_PTR;
+    
+    Projection p;
+    projection_init(&p, schema, field_mask);
+    schema_init_defaults(data, schema, false);
+    
+    DCFSerError err;
+    switch (dcf_ser_reader_peek_type(r)) {
+        case DCF_TYPE_TABLE:
+            err = projected_table(r, data, schema, &p);
+            break;
+        case DCF_TYPE_SCHEMA_REF:
+            if (r->iov) return DCF_SER_ERR_INVALID_ARG;
+            err = projected_tagless(r, data, schema, field_mask, &p);
+            break;
+        default:
+            err = projected_struct(r, data, schema, &p);
+            break;
+    }
+    if (err != DCF_SER_OK) r->last_error = err;
+    return err;
+}
+
+/* ============================================================================
+ * Arena Allocation
+ * ============================================================================ */
+
+#define ARENA_ALIGN         _Alignof(max_align_t)
+#define ARENA_DEFAULT_CHUNK 4096
+
+struct DCFSerArenaChunk {
+    DCFSerArenaChunk* next;
+    size_t  capacity;       /* Bytes in data */
+    size_t  used;           /* Bytes handed out from data */
+    uint8_t* data;          /* Aligned start, inside this allocation */
+};
+
+static DCFSerArenaChunk* arena_chunk_new(size_t capacity) {
+    if (capacity > SIZE_MAX - sizeof(DCFSerArenaChunk) - ARENA_ALIGN) return NULL;
+    DCFSerArenaChunk* c = malloc(sizeof(*c) + ARENA_ALIGN + capacity);
+    if (!c) return NULL;
+    uintptr_t p = (uintptr_t)(c + 1);
+    p = (p + ARENA_ALIGN - 1) & ~(uintptr_t)(ARENA_ALIGN - 1);
+    c->data = (uint8_t*)p;
+    c->capacity = capacity;
+    c->used = 0;
+    c->next = NULL;
+    return c;
+}
+
+DCFSerError dcf_ser_arena_init(DCFSerArena* arena, size_t chunk_size) {
+    if (!arena) return DCF_SER_ERR_NULL_PTR;
+    memset(arena, 0, sizeof(*arena));
+    arena->chunk_size = chunk_size ? chunk_size : ARENA_DEFAULT_CHUNK;
+    return DCF_SER_OK;
+}
+
+static void arena_free_list(DCFSerArenaChunk* c) {
+    while (c) {
+        DCFSerArenaChunk* next = c->next;
+        free(c);
+        c = next;
+    }
+}
+
+void dcf_ser_arena_destroy(DCFSerArena* arena) {
+    if (!arena) return;
+    arena_free_list(arena->head);
+    arena_free_list(arena->spare);
+    memset(arena, 0, sizeof(*arena));
+}
+
+void dcf_ser_arena_reset(DCFSerArena* arena) {
+    if (!arena) return;
+    
+    /* Keep every chunk for the next message */
+    while (arena->head) {
+        DCFSerArenaChunk* c = arena->head;
+        arena->head = c->next;
+        c->used = 0;
+        c->next = arena->spare;
+        arena->spare = c;
+    }
+    arena->used = 0;
+}
+
+void* dcf_ser_arena_alloc(DCFSerArena* arena, size_t size) {
+    if (!arena || size > SIZE_MAX - (ARENA_ALIGN - 1)) return NULL;
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    
+    DCFSerArenaChunk* c = arena->head;
+    if (!c || c->capacity - c->used < size) {
+        /* Reuse a spare chunk that fits, else allocate one */
+        DCFSerArenaChunk** link = &arena->spare;
+        while (*link && (*link)->capacity < size) link = &(*link)->next;
+        if (*link) {
+            c = *link;
+            *link = c->next;
+        } else {
+            size_t cap = arena->chunk_size ? arena->chunk_size : ARENA_DEFAULT_CHUNK;
+            c = arena_chunk_new(size > cap ? size : cap);
+            if (!c) return NULL;
+        }
+        c->next = arena->head;
+        arena->head = c;
+    }
+    
+    void* p = c->data + c->used;
+    c->used += size;
+    arena->used += size;
+    return p;
+}
+
+/* Copy len bytes plus a terminating NUL */
+static char* arena_strndup(DCFSerArena* arena, const char* str, size_t len) {
+    char* copy = dcf_ser_arena_alloc(arena, len + 1);
+    if (!copy) return NULL;
+    if (len > 0) memcpy(copy, str, len);
+    copy[len] = '\0';
+    return copy;
+}
+
+DCFSerError dcf_ser_read_string_arena(DCFSerReader* r, DCFSerArena* arena,
+                                      const char** out_str, size_t* out_len) {
+    if (!r || !arena || !out_str) return DCF_SER_ERR_NULL_PTR;
+    const char* str;
+    size_t len;
+    DCF_SER_CHECK(dcf_ser_read_string(r, &str, &len));
+    char* copy = arena_strndup(arena, str, len);
+    if (!copy) return DCF_SER_ERR_ALLOC_FAIL;
+    *out_str = copy;
+    if (out_len) *out_len = len;
+    return DCF_SER_OK;
+}
+
+DCFSerError dcf_ser_read_bytes_arena(DCFSerReader* r, DCFSerArena* arena,
+                                     const void** out_data, size_t* out_len) {
+    if (!r || !arena || !out_data || !out_len) return DCF_SER_ERR_NULL_PTR;
+    const void* data;
+    size_t len;
+    DCF_SER_CHECK(dcf_ser_read_bytes(r, &data, &len));
+    void* copy = dcf_ser_arena_alloc(arena, len);
+    if (!copy) return DCF_SER_ERR_ALLOC_FAIL;
+    if (len > 0) memcpy(copy, data, len);
+    *out_data = copy;
+    *out_len = len;
+    return DCF_SER_OK;
+}
+
+DCFSerError dcf_ser_read_struct_arena(DCFSerReader* r, void* data, const DCFSerSchema* schema,
+                                      DCFSerArena* arena) {
+    if (!arena) return DCF_SER_ERR_NULL_PTR;
+    return read_struct_schema(r, data, schema, arena);
+}
+
+/* ============================================================================
+ * Lazy DOM
+ * ============================================================================ */
+
+struct DCFSerDom {
+    DCFSerReader reader;    /* Source reader (buffer, payload bounds, limits) */
+    DCFSerArena* arena;     /* Node storage */
+};
+
+/* Reader positioned at a node's tag */
+static DCFSerReader dom_reader_at(const DCFSerDom* dom, size_t offset) {
+    DCFSerReader r = dom->reader;
+    r.position = offset;
+    r.mark = offset;
+    return r;
+}
+
+static DCFSerError dom_node_init(DCFSerValue* v, DCFSerDom* dom, size_t offset, uint16_t field_id) {
+    memset(v, 0, sizeof(*v));
+    v->dom = dom;
+    v->offset = offset;
+    v->field_id = field_id;
+    if (offset >= dom->reader.payload_end) return DCF_SER_ERR_TRUNCATED;
+    v->type = (DCFSerType)dom->reader.buffer[offset];
+    return DCF_SER_OK;
+}
+
+/* Append a child (arena arrays double; superseded ones stay until reset) */
+static DCFSerError dom_push(DCFSerValue* v, size_t* cap, size_t offset, uint16_t field_id,
+                            size_t key_offset) {
+    DCFSerArena* arena = v->dom->arena;
+    bool is_map = v->type == DCF_TYPE_MAP || v->type == DCF_TYPE_SORTED_MAP;
+    if (v->count == *cap) {
+        size_t n = *cap ? *cap * 2 : 8;
+        DCFSerValue* children = dcf_ser_arena_alloc(arena, n * sizeof(*children));
+        DCFSerValue* keys = is_map ? dcf_ser_arena_alloc(arena, n * sizeof(*keys)) : NULL;
+        if (!children || (is_map && !keys)) return DCF_SER_ERR_ALLOC_FAIL;
+        if (v->count > 0) {
+            memcpy(children, v->children, v->count * sizeof(*children));
+            if (is_map) memcpy(keys, v->keys, v->count * sizeof(*keys));
+        }
+        v->children = children;
+        v->keys = keys;
+        *cap = n;
+    }
+    if (is_map) DCF_SER_CHECK(dom_node_init(&v->keys[v->count], v->dom, key_offset, 0));
+    DCF_SER_CHECK(dom_node_init(&v->children[v->count], v->dom, offset, field_id));
+    v->count++;
+    return DCF_SER_OK;
+}
+
+/* Locate the direct children of a container (nested values are skipped) */
+static DCFSerError dom_children(DCFSerValue* v) {
+    DCFSerReader r = dom_reader_at(v->dom, v->offset);
+    size_t cap = 0;
+    uint8_t tag;
+    DCF_SER_CHECK(reader_get_u8(&r, &tag));
+    
+    switch (v->type) {
+        case DCF_TYPE_ARRAY: {
+            uint8_t elem_type;
+            uint32_t count;
+            DCF_SER_CHECK(reader_get_u8(&r, &elem_type));
+            DCF_SER_CHECK(reader_get_u32(&r, &count));
+            if (count > r.payload_end - r.position) return DCF_SER_ERR_MALFORMED;
+            for (uint32_t i = 0; i < count; i++) {
+                DCF_SER_CHECK(dom_push(v, &cap, r.position, 0, 0));
+                DCF_SER_CHECK(reader_skip_value(&r));
+            }
+            return DCF_SER_OK;
+        }
+        case DCF_TYPE_MAP:
+        case DCF_TYPE_SORTED_MAP: {
+            uint32_t count;
+            DCF_SER_CHECK(reader_advance(&r, 2));   /* key_type, val_type */
+            DCF_SER_CHECK(reader_get_u32(&r, &count));
+            if (v->type == DCF_TYPE_SORTED_MAP) {
+                DCF_SER_CHECK(reader_advance(&r, (size_t)count * 4));
+            }
+            if (count > (r.payload_end - r.position) / 2) return DCF_SER_ERR_MALFORMED;
+            for (uint32_t i = 0; i < count; i++) {
+                size_t key = r.position;
+                DCF_SER_CHECK(reader_skip_value(&r));
+                DCF_SER_CHECK(dom_push(v, &cap, r.position, 0, key));
+                DCF_SER_CHECK(reader_skip_value(&r));
+            }
+            return DCF_SER_OK;
+        }
+        case DCF_TYPE_STRUCT: {
+            DCF_SER_CHECK(reader_advance(&r, 2));   /* type_id */
+            while (true) {
+                uint16_t field_id;
+                uint8_t field_type;
+                DCF_SER_CHECK(reader_get_u16(&r, &field_id));
+                DCF_SER_CHECK(reader_get_u8(&r, &field_type));
+                if (field_id == 0 && field_type == DCF_TYPE_NULL) return DCF_SER_OK;
+                DCF_SER_CHECK(dom_push(v, &cap, r.position, field_id, 0));
+                DCF_SER_CHECK(reader_skip_value(&r));
+            }
+        }
+        case DCF_TYPE_TABLE: {
+            uint16_t type_id, slots;
+            DCF_SER_CHECK(reader_get_u16(&r, &type_id));
+            DCF_SER_CHECK(reader_get_u16(&r, &slots));
+            DCFSerReader at = dom_reader_at(v->dom, v->offset);
+            for (uint32_t id = 1; id <= slots; id++) {
+                DCFSerReader value;
+                DCFSerError err = dcf_ser_table_field(&at, (uint16_t)id, &value);
+                if (err == DCF_SER_ERR_NOT_FOUND) continue;
+                if (err != DCF_SER_OK) return err;
+                DCF_SER_CHECK(dom_push(v, &cap, value.position, (uint16_t)id, 0));
+            }
+            return DCF_SER_OK;
+        }
+        default:
+            return DCF_SER_OK;      /* Scalars and opaque values have no children */
+    }
+}
+
+static DCFSerError dom_materialize(DCFSerValue* v) {
+    if (!v->materialized) {
+        v->materialized = true;
+        v->error = dom_children(v);
+        if (v->error != DCF_SER_OK) v->count = 0;
+    }
+    return v->error;
+}
+
+static DCFSerValue* dom_new_node(DCFSerDom* dom, size_t offset, uint16_t field_id) {
+    DCFSerValue* v = dcf_ser_arena_alloc(dom->arena, sizeof(*v));
+    if (!v || dom_node_init(v, dom, offset, field_id) != DCF_SER_OK) return NULL;
+    return v;
+}
+
+DCFSerError dcf_ser_dom_root(const DCFSerReader* r, DCFSerArena* arena, DCFSerValue** out_root) {
+    if (!r || !arena || !out_root) return DCF_SER_ERR_NULL_PTR;
+    if (r->iov || r->incremental) return DCF_SER_ERR_INVALID_ARG;
+    if (r->position >= r->payload_end) return DCF_SER_ERR_TRUNCATED;
+    
+    DCFSerDom* dom = dcf_ser_arena_alloc(arena, sizeof(*dom));
+    if (!dom) return DCF_SER_ERR_ALLOC_FAIL;
+    dom->reader = *r;
+    dom->arena = arena;
+    
+    DCFSerValue* root = dom_new_node(dom, r->position, 0);
+    if (!root) return DCF_SER_ERR_ALLOC_FAIL;
+    *out_root = root;
+    return DCF_SER_OK;
+}
+
+size_t dcf_ser_value_count(DCFSerValue* v) {
+    if (!v) return 0;
+    
+    /* Arrays know their length without locating elements */
+    if (v->type == DCF_TYPE_ARRAY && !v->materialized) {
+        DCFSerReader r = dom_reader_at(v->dom, v->offset);
+        uint32_t count;
+        if (reader_advance(&r, 2) == DCF_SER_OK && reader_get_u32(&r, &count) == DCF_SER_OK) {
+            return count;
+        }
+    }
+    dom_materialize(v);
+    return v->count;
+}
+
+DCFSerValue* dcf_ser_value_index(DCFSerValue* v, size_t index) {
+    if (!v) return NULL;
+    
+    /* Fixed-width elements: compute the offset, touch nothing else */
+    if (v->type == DCF_TYPE_ARRAY && !v->materialized) {
+        DCFSerReader r = dom_reader_at(v->dom, v->offset);
+        uint8_t elem_type;
+        uint32_t count;
+        if (reader_advance(&r, 1) == DCF_SER_OK && reader_get_u8(&r, &elem_type) == DCF_SER_OK &&
+            reader_get_u32(&r, &count) == DCF_SER_OK && dcf_ser_type_size(elem_type) > 0) {
+            if (index >= count) return NULL;
+            size_t stride = 1 + dcf_ser_type_size(elem_type);
+            if (index < (r.payload_end - r.position) / stride) {
+                size_t at = r.position + index * stride;
+                if (r.buffer[at] == elem_type) return dom_new_node(v->dom, at, 0);
+            }
+        }
+    }
+    if (dom_materialize(v) != DCF_SER_OK || index >= v->count) return NULL;
+    return &v->children[index];
+}
+
+DCFSerValue* dcf_ser_value_key(DCFSerValue* v, size_t index) {
+    if (!v || (v->type != DCF_TYPE_MAP && v->type != DCF_TYPE_SORTED_MAP)) return NULL;
+    if (dom_materialize(v) != DCF_SER_OK || index >= v->count) return NULL;
+    return &v->keys[index];
+}
+
+DCFSerValue* dcf_ser_value_field(DCFSerValue* v, uint16_t field_id) {
+    if (!v) return NULL;
+    
+    /* Tables: one slot read */
+    if (v->type == DCF_TYPE_TABLE && !v->materialized) {
+        DCFSerReader at = dom_reader_at(v->dom, v->offset);
+        DCFSerReader value;
+        if (dcf_ser_table_field(&at, field_id, &value) != DCF_SER_OK) return NULL;
+        return dom_new_node(v->dom, value.position, field_id);
+    }
+    if (v->type != DCF_TYPE_STRUCT && v->type != DCF_TYPE_TABLE) return NULL;
+    if (dom_materialize(v) != DCF_SER_OK) return NULL;
+    for (size_t i = 0; i < v->count; i++) {
+        if (v->children[i].field_id == field_id) return &v->children[i];
+    }
+    return NULL;
+}
+
+DCFSerValue* dcf_ser_value_path(DCFSerValue* v, const char* path) {
+    if (!path) return NULL;
+    while (v && *path) {
+        char open = *path++;
+        if (open != '.' && open != '[') return NULL;
+        if (*path < '0' || *path > '9') return NULL;
+        
+        uint64_t n = 0;
+        while (*path >= '0' && *path <= '9') {
+            n = n * 10 + (uint64_t)(*path++ - '0');
+            if (n > UINT32_MAX) return NULL;
+        }
+        if (open == '[') {
+            if (*path++ != ']') return NULL;
+            v = dcf_ser_value_index(v, (size_t)n);
+        } else {
+            if (n > UINT16_MAX) return NULL;
+            v = dcf_ser_value_field(v, (uint16_t)n);
+        }
+    }
+    return v;
+}
+
+DCFSerError dcf_ser_value_reader(const DCFSerValue* v, DCFSerReader* out) {
+    if (!v || !out) return DCF_SER_ERR_NULL_PTR;
+    *out = dom_reader_at(v->dom, v->offset);
+    return DCF_SER_OK;
+}
+
+DCFSerError dcf_ser_value_uint(const DCFSerValue* v, uint64_t* out) {
+    if (!v || !out) return DCF_SER_ERR_NULL_PTR;
+    DCFSerReader r = dom_reader_at(v->dom, v->offset);
+    DCF_SER_CHECK(reader_advance(&r, 1));
+    
+    switch (v->type) {
+        case DCF_TYPE_BOOL:
+        case DCF_TYPE_U8:  { uint8_t x;  DCF_SER_CHECK(reader_get_u8(&r, &x));  *out = x; break; }
+        case DCF_TYPE_U16: { uint16_t x; DCF_SER_CHECK(reader_get_u16(&r, &x)); *out = x; break; }
+        case DCF_TYPE_U32: { uint32_t x; DCF_SER_CHECK(reader_get_u32(&r, &x)); *out = x; break; }
+        case DCF_TYPE_U64:
+        case DCF_TYPE_TIMESTAMP:
+        case DCF_TYPE_DURATION:
+            return reader_get_u64(&r, out);
+        case DCF_TYPE_VARINT:
+            return reader_get_varint(&r, out);
+        case DCF_TYPE_I8: case DCF_TYPE_I16: case DCF_TYPE_I32: case DCF_TYPE_I64: {
+            int64_t i;
+            DCF_SER_CHECK(dcf_ser_value_int(v, &i));
+            if (i < 0) return DCF_SER_ERR_OVERFLOW;
+            *out = (uint64_t)i;
+            break;
+        }
+        default:
+            return DCF_SER_ERR_TYPE_MISMATCH;
+    }
+    return DCF_SER_OK;
+}
+
+DCFSerError dcf_ser_value_int(const DCFSerValue* v, int64_t* out) {
+    if (!v || !out) return DCF_SER_ERR_NULL_PTR;
+    DCFSerReader r = dom_reader_at(v->dom, v->offset);
+    DCF_SER_CHECK(reader_advance(&r, 1));
+    
+    switch (v->type) {
+        case DCF_TYPE_I8:  { uint8_t x;  DCF_SER_CHECK(reader_get_u8(&r, &x));  *out = (int8_t)x; break; }
+        case DCF_TYPE_I16: { uint16_t x; DCF_SER_CHECK(reader_get_u16(&r, &x)); *out = (int16_t)x; break; }
+        case DCF_TYPE_I32: { uint32_t x; DCF_SER_CHECK(reader_get_u32(&r, &x)); *out = (int32_t)x; break; }
+        case DCF_TYPE_I64: { uint64_t x; DCF_SER_CHECK(reader_get_u64(&r, &x)); *out = (int64_t)x; break; }
+        case DCF_TYPE_BOOL: case DCF_TYPE_U8: case DCF_TYPE_U16: case DCF_TYPE_U32:
+        case DCF_TYPE_U64: case DCF_TYPE_VARINT: case DCF_TYPE_TIMESTAMP: case DCF_TYPE_DURATION: {
+            uint64_t u;
+            DCF_SER_CHECK(dcf_ser_value_uint(v, &u));
+            if (u > INT64_MAX) return DCF_SER_ERR_OVERFLOW;
+            *out = (int64_t)u;
+            break;
+        }
+        default:
+            return DCF_SER_ERR_TYPE_MISMATCH;
+    }
+    return DCF_SER_OK;
+}
+
+DCFSerError dcf_ser_value_f64(const DCFSerValue* v, double* out) {
+    if (!v || !out) return DCF_SER_ERR_NULL_PTR;
+    DCFSerReader r = dom_reader_at(v->dom, v->offset);
+    if (v->type == DCF_TYPE_F32) {
+        float f;
+        DCF_SER_CHECK(dcf_ser_read_f32(&r, &f));
+        *out = f;
+        return DCF_SER_OK;
+    }
+    return dcf_ser_read_f64(&r, out);
+}
+
+DCFSerError dcf_ser_value_string(const DCFSerValue* v, const char** out_str, size_t* out_len) {
+    if (!v || !out_str || !out_len) return DCF_SER_ERR_NULL_PTR;
+    DCFSerReader r = dom_reader_at(v->dom, v->offset);
+    return dcf_ser_read_string(&r, out_str, out_len);
+}
+
+/* ============================================================================
+ * Visitor Decoding
+ * ============================================================================ */
+
+typedef struct VisitState {
+    DCFSerReader* r;
+    const DCFSerVisitor* v;
+    void*  ctx;
+    size_t depth;
+    bool   stopped;         /* A callback returned DCF_SER_VISIT_STOP */
+} VisitState;
+
+/* Handler for one tag; the tag byte has been consumed, tag_pos points at it */
+typedef DCFSerError (*VisitFn)(VisitState* s, size_t tag_pos);
+
+static DCFSerError visit_value(VisitState* s, int expect);
+
+/* Invoke a callback if the visitor has one */
+#define VISIT_CALL(s, cb, ...) \
+    ((s)->v->cb ? (s)->v->cb((s)->ctx, __VA_ARGS__) : DCF_SER_VISIT_CONTINUE)
+#define VISIT_CALL0(s, cb) \
+    ((s)->v->cb ? (s)->v->cb((s)->ctx) : DCF_SER_VISIT_CONTINUE)
+
+static DCFSerError visit_done(VisitState* s, DCFSerVisit act) {
+    if (act == DCF_SER_VISIT_STOP) s->stopped = true;
+    return DCF_SER_OK;
+}
+
+static DCFSerError visit_skip(VisitState* s, size_t tag_pos) {
+    s->r->position = tag_pos;
+    return reader_skip_value(s->r);
+}
+
+static DCFSerError visit_enter(VisitState* s) {
+    if (s->depth >= s->r->limits.max_depth) return DCF_SER_ERR_DEPTH_EXCEEDED;
+    s->depth++;
+    return DCF_SER_OK;
+}
+
+/* --- Scalars --- */
+
+#define VISIT_SCALAR(name, cb, get, raw_t, val_t) \
+    static DCFSerError name(VisitState* s, size_t tag_pos) { \
+        raw_t raw; \
+        (void)tag_pos; \
+        DCF_SER_CHECK(get(s->r, &raw)); \
+        return visit_done(s, VISIT_CALL(s, cb, (val_t)raw)); \
+    }
+
+VISIT_SCALAR(visit_bool, on_bool, reader_get_u8, uint8_t, bool)
+VISIT_SCALAR(visit_u8, on_u8, reader_get_u8, uint8_t, uint8_t)
+VISIT_SCALAR(visit_i8, on_i8, reader_get_u8, uint8_t, int8_t)
+VISIT_SCALAR(visit_u16, on_u16, reader_get_u16, uint16_t, uint16_t)
+VISIT_SCALAR(visit_i16, on_i16, reader_get_u16, uint16_t, int16_t)
+VISIT_SCALAR(visit_u32, on_u32, reader_get_u32, uint32_t, uint32_t)
+VISIT_SCALAR(visit_i32, on_i32, reader_get_u32, uint32_t, int32_t)
+VISIT_SCALAR(visit_u64, on_u64, reader_get_u64, uint64_t, uint64_t)
+VISIT_SCALAR(visit_i64, on_i64, reader_get_u64, uint64_t, int64_t)
+VISIT_SCALAR(visit_varint, on_varint, reader_get_varint, uint64_t, uint64_t)
+VISIT_SCALAR(visit_timestamp, on_timestamp, reader_get_u64, uint64_t, uint64_t)
+VISIT_SCALAR(visit_duration, on_duration, reader_get_u64, uint64_t, int64_t)
+
+static DCFSerError visit_null(VisitState* s, size_t tag_pos) {
+    (void)tag_pos;
+    return visit_done(s, VISIT_CALL0(s, on_null));
+}
+
+static DCFSerError visit_f32(VisitState* s, size_t tag_pos) {
+    uint32_t bits;
+    float val;
+    (void)tag_pos;
+    DCF_SER_CHECK(reader_get_u32(s->r, &bits));
+    memcpy(&val, &bits, sizeof(val));
+    return visit_done(s, VISIT_CALL(s, on_f32, val));
+}
+
+static DCFSerError visit_f64(VisitState* s, size_t tag_pos) {
+    uint64_t bits;
+    double val;
+    (void)tag_pos;
+    DCF_SER_CHECK(reader_get_u64(s->r, &bits));
+    memcpy(&val, &bits, sizeof(val));
+    return visit_done(s, VISIT_CALL(s, on_f64, val));
+}
+
+static DCFSerError visit_uuid(VisitState* s, size_t tag_pos) {
+    (void)tag_pos;
+    const uint8_t* uuid = s->r->buffer + s->r->position;
+    DCF_SER_CHECK(reader_advance(s->r, 16));
+    return visit_done(s, VISIT_CALL(s, on_uuid, uuid));
+}
+
+static DCFSerError visit_string(VisitState* s, size_t tag_pos) {
+    uint32_t len;
+    (void)tag_pos;
+    DCF_SER_CHECK(reader_get_u32(s->r, &len));
+    if (len > s->r->limits.max_string) return DCF_SER_ERR_TOO_LARGE;
+    const char* str = (const char*)(s->r->buffer + s->r->position);
+    DCF_SER_CHECK(reader_advance(s->r, len));
+    return visit_done(s, VISIT_CALL(s, on_string, str, len));
+}
+
+static DCFSerError visit_bytes(VisitState* s, size_t tag_pos) {
+    uint32_t len;
+    (void)tag_pos;
+    DCF_SER_CHECK(reader_get_u32(s->r, &len));
+    const uint8_t* data = s->r->buffer + s->r->position;
+    DCF_SER_CHECK(reader_advance(s->r, len));
+    return visit_done(s, VISIT_CALL(s, on_bytes, data, len));
+}
+
+/* Schema-dependent encodings: hand over the whole value */
+static DCFSerError visit_opaque(VisitState* s, size_t tag_pos) {
+    DCF_SER_CHECK(visit_skip(s, tag_pos));
+    return visit_done(s, VISIT_CALL(s, on_opaque, (DCFSerType)s->r->buffer[tag_pos],
+                                    s->r->buffer + tag_pos, s->r->position - tag_pos));
+}
+
+/* --- Containers --- */
+
+static DCFSerError visit_array(VisitState* s, size_t tag_pos) {
+    uint8_t elem;
+    uint32_t count;
+    DCF_SER_CHECK(reader_get_u8(s->r, &elem));
+    DCF_SER_CHECK(reader_get_u32(s->r, &count));
+    if (count > s->r->limits.max_array) return DCF_SER_ERR_TOO_LARGE;
+    
+    DCFSerVisit act = VISIT_CALL(s, on_array_begin, (DCFSerType)elem, count);
+    if (act == DCF_SER_VISIT_SKIP) return visit_skip(s, tag_pos);
+    if (act == DCF_SER_VISIT_STOP) return visit_done(s, act);
+    
+    DCF_SER_CHECK(visit_enter(s));
+    for (uint32_t i = 0; i < count; i++) {
+        DCF_SER_CHECK(visit_value(s, elem));
+        if (s->stopped) return DCF_SER_OK;
+    }
+    s->depth--;
+    return visit_done(s, VISIT_CALL0(s, on_array_end));
+}
+
+static DCFSerError visit_map(VisitState* s, size_t tag_pos) {
+    uint8_t key_type, val_type;
+    uint32_t count;
+    DCF_SER_CHECK(reader_get_u8(s->r, &key_type));
+    DCF_SER_CHECK(reader_get_u8(s->r, &val_type));
+    DCF_SER_CHECK(reader_get_u32(s->r, &count));
+    if (count > s->r->limits.max_array) return DCF_SER_ERR_TOO_LARGE;
+    if (s->r->buffer[tag_pos] == DCF_TYPE_SORTED_MAP) {
+        DCF_SER_CHECK(reader_advance(s->r, (size_t)count * 4));  /* offset table */
+    }
+    
+    DCFSerVisit act = VISIT_CALL(s, on_map_begin, (DCFSerType)key_type, (DCFSerType)val_type, count);
+    if (act == DCF_SER_VISIT_SKIP) return visit_skip(s, tag_pos);
+    if (act == DCF_SER_VISIT_STOP) return visit_done(s, act);
+    
+    DCF_SER_CHECK(visit_enter(s));
+    for (uint32_t i = 0; i < count; i++) {
+        DCF_SER_CHECK(visit_value(s, key_type));
+        if (s->stopped) return DCF_SER_OK;
+        DCF_SER_CHECK(visit_value(s, val_type));
+        if (s->stopped) return DCF_SER_OK;
+    }
+    s->depth--;
+    return visit_done(s, VISIT_CALL0(s, on_map_end));
+}
+
+static DCFSerError visit_struct(VisitState* s, size_t tag_pos) {
+    uint16_t type_id;
+    DCF_SER_CHECK(reader_get_u16(s->r, &type_id));
+    
+    DCFSerVisit act = VISIT_CALL(s, on_struct_begin, type_id);
+    if (act == DCF_SER_VISIT_SKIP) return visit_skip(s, tag_pos);
+    if (act == DCF_SER_VISIT_STOP) return visit_done(s, act);
+    
+    DCF_SER_CHECK(visit_enter(s));
+    while (true) {
+        uint16_t field_id;
+        uint8_t field_type;
+        DCF_SER_CHECK(reader_get_u16(s->r, &field_id));
+        DCF_SER_CHECK(reader_get_u8(s->r, &field_type));
+        if (field_id == 0 && field_type == DCF_TYPE_NULL) break;
+        
+        act = VISIT_CALL(s, on_field, field_id, (DCFSerType)field_type);
+        if (act == DCF_SER_VISIT_STOP) return visit_done(s, act);
+        if (act == DCF_SER_VISIT_SKIP) {
+            DCF_SER_CHECK(reader_skip_value(s->r));
+            continue;
+        }
+        DCF_SER_CHECK(visit_value(s, field_type));
+        if (s->stopped) return DCF_SER_OK;
+    }
+    s->depth--;
+    return visit_done(s, VISIT_CALL0(s, on_struct_end));
+}
+
+/* Tables are visited through the slot table, so fields come in ID order */
+static DCFSerError visit_table(VisitState* s, size_t tag_pos) {
+    DCFSerReader* r = s->r;
+    uint16_t type_id, slots;
+    uint32_t body;
+    DCF_SER_CHECK(reader_get_u16(r, &type_id));
+    DCF_SER_CHECK(reader_get_u16(r, &slots));
+    DCF_SER_CHECK(reader_get_u32(r, &body));
+    size_t table = r->position;
+    DCF_SER_CHECK(reader_advance(r, (size_t)slots * 4));
+    size_t body_start = r->position;
+    DCF_SER_CHECK(reader_advance(r, body));
+    size_t body_end = r->position;
+    
+    DCFSerVisit act = VISIT_CALL(s, on_struct_begin, type_id);
+    if (act == DCF_SER_VISIT_SKIP) return DCF_SER_OK;   /* Already past the body */
+    if (act == DCF_SER_VISIT_STOP) return visit_done(s, act);
+    
+    DCF_SER_CHECK(visit_enter(s));
+    for (size_t i = 0; i < slots; i++) {
+        uint32_t rel;
+        memcpy(&rel, r->buffer + table + i * 4, 4);
+        rel = dcf_ser_ntoh32(rel);
+        if (rel == 0) continue;
+        if (tag_pos + rel < body_start || tag_pos + rel >= body_end) return DCF_SER_ERR_MALFORMED;
+        
+        size_t at = tag_pos + rel;
+        act = VISIT_CALL(s, on_field, (uint16_t)(i + 1), (DCFSerType)r->buffer[at]);
+        if (act == DCF_SER_VISIT_STOP) return visit_done(s, act);
+        if (act == DCF_SER_VISIT_SKIP) continue;
+        r->position = at;
+        DCF_SER_CHECK(visit_value(s, -1));
+        if (s->stopped) return DCF_SER_OK;
+        if (r->position > body_end) return DCF_SER_ERR_MALFORMED;
+    }
+    r->position = body_end;
+    s->depth--;
+    return visit_done(s, VISIT_CALL0(s, on_struct_end));
+}
+
+/* Tag -> handler (NULL = invalid tag) */
+static const VisitFn visit_handlers[256] = {
+    [DCF_TYPE_NULL]           = visit_null,
+    [DCF_TYPE_BOOL]           = visit_bool,
+    [DCF_TYPE_U8]             = visit_u8,
+    [DCF_TYPE_I8]             = visit_i8,
+    [DCF_TYPE_U16]            = visit_u16,
+    [DCF_TYPE_I16]            = visit_i16,
+    [DCF_TYPE_U32]            = visit_u32,
+    [DCF_TYPE_I32]            = visit_i32,
+    [DCF_TYPE_U64]            = visit_u64,
+    [DCF_TYPE_I64]            = visit_i64,
+    [DCF_TYPE_F32]            = visit_f32,
+    [DCF_TYPE_F64]            = visit_f64,
+    [DCF_TYPE_VARINT]         = visit_varint,
+    [DCF_TYPE_STRING]         = visit_string,
+    [DCF_TYPE_BYTES]          = visit_bytes,
+    [DCF_TYPE_UUID]           = visit_uuid,
+    [DCF_TYPE_ARRAY]          = visit_array,
+    [DCF_TYPE_MAP]            = visit_map,
+    [DCF_TYPE_STRUCT]         = visit_struct,
+    [DCF_TYPE_SORTED_MAP]     = visit_map,
+    [DCF_TYPE_TABLE]          = visit_table,
+    [DCF_TYPE_FIXED]          = visit_opaque,
+    [DCF_TYPE_COMPACT_STRUCT] = visit_opaque,
+    [DCF_TYPE_SCHEMA_REF]     = visit_opaque,
+    [DCF_TYPE_TIMESTAMP]      = visit_timestamp,
+    [DCF_TYPE_DURATION]       = visit_duration,
+};
+
+/* expect: required tag (element/field type), or -1 for any */
+static DCFSerError visit_value(VisitState* s, int expect) {
+    size_t tag_pos = s->r->position;
+    uint8_t tag;
+    DCF_SER_CHECK(reader_get_u8(s->r, &tag));
+    if (expect >= 0 && tag != expect) return DCF_SER_ERR_TYPE_MISMATCH;
+    VisitFn fn = visit_handlers[tag];
+    if (!fn) return DCF_SER_ERR_INVALID_TYPE;
+    return fn(s, tag_pos);
+}
+
+DCFSerError dcf_ser_visit(DCFSerReader* r, const DCFSerVisitor* visitor, void* ctx) {
+    if (!r || !visitor) return DCF_SER_ERR_NULL_PTR;
+    if (r->iov || r->incremental) return DCF_SER_ERR_INVALID_ARG;
+    
+    VisitState s = { r, visitor, ctx, 0, false };
+    while (!s.stopped && r->position < r->payload_end) {
+        r->mark = r->position;
+        DCFSerError err = visit_value(&s, -1);
+        if (err != DCF_SER_OK) {
+            r->last_error = err;
+            return err;
+        }
+    }
     return DCF_SER_OK;
 }
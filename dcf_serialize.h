@@ -17,10 +17,20 @@
  * - Variable-length encoding for efficiency
  * 
  * Wire Format:
- * ┌──────────┬─────────┬──────────┬───────┬────────┬──────────┬──────────┐
- * │  Magic   │ Version │ MsgType  │ Flags │ Length │ Payload  │  CRC32   │
- * │  4 bytes │ 2 bytes │ 2 bytes  │ 1 byte│ 4 bytes│ N bytes  │  4 bytes │
- * └──────────┴─────────┴──────────┴───────┴────────┴──────────┴──────────┘
+ * ┌──────────┬─────────┬──────────┬───────┬────────┬──────────┬──────────┬──────────┐
+ * │  Magic   │ Version │ MsgType  │ Flags │ Length │ Sequence │ Payload  │  CRC32   │
+ * │  4 bytes │ 2 bytes │ 2 bytes  │ 1 byte│ 4 bytes│  4 bytes │ N bytes  │  4 bytes │
+ * └──────────┴─────────┴──────────┴───────┴────────┴──────────┴──────────┴──────────┘
+ * 
+ * Compact Wire Format (DCF_SER_FLAG_COMPACT):
+ * ┌────────┬──────────┬──────────┬───────────┬──────────┬──────────┐
+ * │  Sync  │  Length  │ MsgType  │ [SeqDelta]│ Payload  │ [CRC32]  │
+ * │ 1 byte │  varint  │  varint  │  varint   │ N bytes  │  4 bytes │
+ * └────────┴──────────┴──────────┴───────────┴──────────┴──────────┘
+ * 
+ * Extended Header (DCF_SER_FLAG_EXTENDED): the fixed header with Length set
+ * to 0xFFFFFFFF, followed by an 8-byte payload length and a CRC32 of the
+ * header bytes, so framing can be trusted before a large payload arrives.
  */
 
 #ifndef DCF_SERIALIZE_H
@@ -29,6 +39,9 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
+#if defined(DEBUG) && !defined(NDEBUG)
+#include <assert.h>   /* Unchecked reader tag assertions */
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -60,11 +73,18 @@ extern "C" {
 #define DCF_SER_MAGIC           0x44434653  /* "DCFS" in big-endian */
 #define DCF_SER_VERSION         0x0520      /* Version 5.2.0 */
 #define DCF_SER_HEADER_SIZE     17          /* Fixed header size */
-#define DCF_SER_MAX_MESSAGE     (16 * 1024 * 1024)  /* 16MB max message */
-#define DCF_SER_MAX_STRING      (64 * 1024)         /* 64KB max string */
-#define DCF_SER_MAX_ARRAY       (1024 * 1024)       /* 1M max array elements */
-#define DCF_SER_MAX_DEPTH       32          /* Max nesting depth */
+#define DCF_SER_MAX_MESSAGE     (16 * 1024 * 1024)  /* Default max payload (16MB) */
+#define DCF_SER_MAX_STRING      (64 * 1024)         /* Default max string (64KB) */
+#define DCF_SER_MAX_ARRAY       (1024 * 1024)       /* Default max array elements */
+#define DCF_SER_MAX_DEPTH       32          /* Max nesting depth (hard cap) */
 #define DCF_SER_INITIAL_CAP     256         /* Initial buffer capacity */
+#define DCF_SER_REF_MIN_LEN     64          /* Smaller byte refs are copied inline */
+#define DCF_SER_MSG_BATCH       0xFFFF      /* Reserved msg_type: batch of sub-messages */
+#define DCF_SER_STREAM_CHUNK    (64 * 1024) /* Default sink writer chunk payload */
+#define DCF_SER_REASM_STREAMS   16          /* Default concurrent reassembly streams */
+#define DCF_SER_FRAMER_CAP      (64 * 1024) /* Default framer buffer size */
+#define DCF_SER_IOV_SCRATCH     64          /* Segmented reader: max linearized value */
+#define DCF_SER_MAX_THREADS     64          /* Parallel array decode: max workers */
 
 /* ============================================================================
  * Error Codes
@@ -87,6 +107,8 @@ typedef enum DCFSerError {
     DCF_SER_ERR_INVALID_TYPE    = 0x205,
     DCF_SER_ERR_OVERFLOW        = 0x206,
     DCF_SER_ERR_MALFORMED       = 0x207,
+    DCF_SER_ERR_NEED_MORE       = 0x208,  /* Incremental reader: retry after feed */
+    DCF_SER_ERR_FRAGMENTED      = 0x209,  /* Segmented reader: use dcf_ser_read_bytes_iov */
     
     /* General errors (0x3XX) */
     DCF_SER_ERR_NULL_PTR        = 0x301,
@@ -94,6 +116,7 @@ typedef enum DCFSerError {
     DCF_SER_ERR_INTERNAL        = 0x303,
     DCF_SER_ERR_NOT_FOUND       = 0x304,
     DCF_SER_ERR_TYPE_MISMATCH   = 0x305,
+    DCF_SER_ERR_IO              = 0x306,
 } DCFSerError;
 
 /* ============================================================================
@@ -108,9 +131,20 @@ typedef enum DCFSerFlags {
     DCF_SER_FLAG_FINAL      = 0x08,  /* Final chunk of streaming message */
     DCF_SER_FLAG_PRIORITY   = 0x10,  /* High-priority message */
     DCF_SER_FLAG_NO_CRC     = 0x20,  /* Skip CRC validation (trusted channel) */
-    DCF_SER_FLAG_EXTENDED   = 0x80,  /* Extended header follows */
+    DCF_SER_FLAG_COMPACT    = 0x40,  /* Compact header (writer option; set when one is parsed) */
+    DCF_SER_FLAG_EXTENDED   = 0x80,  /* Extended header: 64-bit length + header CRC */
 } DCFSerFlags;
 
+/*
+ * Compact header sync byte: 11011xxx. The low bits carry the only flags a
+ * compact header can express; a full header always starts with 'D' (0x44).
+ */
+#define DCF_SER_COMPACT_SYNC        0xD8
+#define DCF_SER_COMPACT_MASK        0xF8
+#define DCF_SER_COMPACT_SEQ         0x01  /* Sequence delta follows msg_type */
+#define DCF_SER_COMPACT_NO_CRC      0x02  /* No trailing CRC32 */
+#define DCF_SER_COMPACT_PRIORITY    0x04  /* High-priority message */
+
 /* ============================================================================
  * Data Type Tags (for self-describing format)
  * ============================================================================ */
@@ -141,6 +175,11 @@ typedef enum DCFSerType {
     DCF_TYPE_MAP        = 0x21,  /* Key-value map */
     DCF_TYPE_STRUCT     = 0x22,  /* Named fields */
     DCF_TYPE_TUPLE      = 0x23,  /* Fixed-size heterogeneous sequence */
+    DCF_TYPE_SORTED_MAP = 0x24,  /* Key-sorted map with entry offset table */
+    DCF_TYPE_TABLE      = 0x25,  /* Fields reachable through a slot offset table */
+    DCF_TYPE_FIXED      = 0x26,  /* Fixed-layout block (compiled schema) */
+    DCF_TYPE_COMPACT_STRUCT = 0x27, /* Presence bitmap + untagged schema fields */
+    DCF_TYPE_SCHEMA_REF = 0x28,  /* Schema fingerprint + untagged field values */
     
     /* Special */
     DCF_TYPE_TIMESTAMP  = 0x30,  /* 64-bit microseconds since epoch */
@@ -168,6 +207,67 @@ typedef struct DCFSerHeader {
 } DCFSerHeader;
 #pragma pack(pop)
 
+/* ============================================================================
+ * Runtime Limits
+ * ============================================================================ */
+
+/**
+ * Per-writer/per-reader limits (defaults are the DCF_SER_MAX_* constants)
+ * 
+ * Payloads above 4GB - 1 additionally need DCF_SER_FLAG_EXTENDED.
+ */
+typedef struct DCFSerLimits {
+    uint64_t max_message;   /* Max payload bytes */
+    uint32_t max_string;    /* Max string bytes */
+    uint32_t max_array;     /* Max array/map element count */
+    uint32_t max_depth;     /* Max nesting depth (<= DCF_SER_MAX_DEPTH) */
+} DCFSerLimits;
+
+/* ============================================================================
+ * Output Sinks
+ * ============================================================================ */
+
+/**
+ * Chunk consumer for sink writers: must take all len bytes or fail
+ * (data is only valid for the duration of the call)
+ */
+typedef DCFSerError (*DCFSerSinkFn)(void* ctx, const void* data, size_t len);
+
+/* ============================================================================
+ * Scatter/Gather Vectors
+ * ============================================================================ */
+
+/**
+ * I/O vector (same layout as POSIX struct iovec, may be cast for writev/sendmsg)
+ */
+typedef struct DCFSerIoVec {
+    void*    iov_base;      /* Start of segment */
+    size_t   iov_len;       /* Segment length */
+} DCFSerIoVec;
+
+/**
+ * External (caller-owned) payload segment spliced into the writer output
+ */
+typedef struct DCFSerSegment {
+    size_t      offset;     /* Writer buffer position the segment follows */
+    const void* data;       /* Caller-owned bytes (not copied) */
+    size_t      len;        /* Segment length */
+} DCFSerSegment;
+
+/**
+ * Open container the writer must patch when it ends (internal)
+ */
+typedef struct DCFSerHeldFrame {
+    size_t   start;         /* Buffer offset of the container tag */
+    size_t   table;         /* Buffer offset of its offset table */
+    size_t   mark;          /* Tables: position at the last field (or body start) */
+    uint32_t count;         /* Table entries */
+    uint32_t depth;         /* Writer depth inside the container */
+    uint8_t  kind;          /* DCF_TYPE_SORTED_MAP, TABLE or COMPACT_STRUCT */
+    uint8_t  key_type;      /* Sorted maps: declared key type */
+    bool     pending;       /* Tables: a field awaits its value */
+} DCFSerHeldFrame;
+
 /* ============================================================================
  * Writer Context (Encoder)
  * ============================================================================ */
@@ -180,11 +280,45 @@ typedef struct DCFSerWriter {
     uint16_t msg_type;      /* Message type for header */
     uint8_t  flags;         /* Message flags */
     uint32_t sequence;      /* Sequence number */
+    uint32_t seq_base;      /* Base for compact-header sequence deltas */
     bool     owns_buffer;   /* True if we allocated the buffer */
     bool     header_written;/* True if header is committed */
     DCFSerError last_error; /* Last error code */
+    DCFSerSegment* segments;/* External segments from dcf_ser_write_bytes_ref */
+    size_t   segment_count; /* Number of external segments */
+    size_t   segment_cap;   /* Allocated segment slots */
+    size_t   ref_bytes;     /* Total bytes held in external segments */
+    size_t   headroom;      /* Bytes reserved before the message */
+    size_t   tailroom;      /* Bytes reserved after the message */
+    size_t   payload_start; /* Buffer offset of the first payload byte */
+    DCFSerLimits limits;    /* Encoding limits */
+    size_t   msg_start;     /* Buffer offset of the message (after finish) */
+    size_t   msg_end;       /* Buffer offset past the CRC (after finish) */
+    size_t   batch_mark;    /* Body start of the open batch sub-message */
+    size_t   batch_refs;    /* ref_bytes when the sub-message was opened */
+    bool     batch_open;    /* True between dcf_ser_batch_begin/end */
+    DCFSerSinkFn sink;      /* Chunk consumer (NULL = buffer whole message) */
+    void*    sink_ctx;      /* Opaque argument for sink */
+    size_t   flushed;       /* Payload bytes already sent as chunks */
+    size_t   sent;          /* Wire bytes already sent as chunks */
+    DCFSerHeldFrame* held;  /* Open held containers (allocated on first use) */
+    size_t   held_depth;    /* Open held containers; sinks do not flush while > 0 */
 } DCFSerWriter;
 
+/**
+ * Optional writer configuration (zero-initialize for defaults)
+ */
+typedef struct DCFSerWriterOptions {
+    uint8_t* buffer;        /* External buffer (NULL = allocate internally) */
+    size_t   capacity;      /* External buffer size, or initial internal capacity */
+    size_t   headroom;      /* Bytes to reserve before the header (outer framing) */
+    size_t   tailroom;      /* Bytes to reserve after the CRC (outer trailers) */
+    const DCFSerLimits* limits; /* Encoding limits (NULL = defaults) */
+    DCFSerSinkFn sink;      /* Stream chunks to this sink (NULL = no streaming) */
+    void*    sink_ctx;      /* Opaque argument for sink */
+    size_t   chunk_size;    /* Payload bytes per chunk (0 = DCF_SER_STREAM_CHUNK) */
+} DCFSerWriterOptions;
+
 /* ============================================================================
  * Reader Context (Decoder)
  * ============================================================================ */
@@ -196,12 +330,192 @@ typedef struct DCFSerReader {
     size_t   payload_start; /* Start of payload (after header) */
     size_t   payload_end;   /* End of payload (before CRC) */
     size_t   depth;         /* Current nesting depth */
+    uint32_t seq_base;      /* Base for compact-header sequence deltas */
+    DCFSerLimits limits;    /* Decoding limits */
     DCFSerHeader header;    /* Parsed header */
     bool     header_valid;  /* True if header parsed successfully */
     bool     crc_verified;  /* True if CRC was verified */
     DCFSerError last_error; /* Last error code */
+    size_t   mark;          /* Start of the value being read (rewind point) */
+    bool     incremental;   /* Message may be only partially received */
+    size_t   msg_len;       /* Full message size (incremental mode) */
+    size_t   crc_pos;       /* Bytes hashed so far (incremental mode) */
+    uint32_t crc_state;     /* Running CRC (incremental mode) */
+    const DCFSerIoVec* iov; /* Message segments (NULL = contiguous buffer) */
+    size_t   iov_count;     /* Number of segments */
+    size_t   seg;           /* Segment last located (search hint) */
+    size_t   seg_start;     /* Logical offset of that segment */
+    size_t   win_base;      /* Logical offset of buffer[0] (segmented mode) */
+    size_t   iov_end;       /* Logical payload end (segmented mode) */
+    uint8_t  scratch[DCF_SER_IOV_SCRATCH]; /* Values straddling segments */
+    bool     trusted;       /* Payload proven well-formed (dcf_ser_reader_trust) */
+    size_t   outer_end[DCF_SER_MAX_DEPTH]; /* payload_end saved by open compact structs */
 } DCFSerReader;
 
+/**
+ * Iterator over the sub-messages of a DCF_SER_MSG_BATCH message
+ */
+typedef struct DCFSerBatchIter {
+    const DCFSerReader* batch;  /* Validated batch reader */
+    size_t   position;      /* Offset of the next sub-message */
+} DCFSerBatchIter;
+
+/* ============================================================================
+ * Stream Reassembly
+ * ============================================================================ */
+
+/**
+ * Chunk payload delivered in cut-through mode
+ */
+typedef struct DCFSerStreamChunk {
+    uint16_t msg_type;      /* Stream message type */
+    uint32_t sequence;      /* Stream ID */
+    uint64_t offset;        /* Offset of data within the logical payload */
+    const void* data;       /* Chunk payload (valid during the callback) */
+    size_t   len;           /* Chunk payload length */
+    bool     final;         /* Last chunk of the stream */
+} DCFSerStreamChunk;
+
+typedef DCFSerError (*DCFSerChunkFn)(void* ctx, const DCFSerStreamChunk* chunk);
+
+/**
+ * Reassembler configuration (zero-initialize for defaults)
+ */
+typedef struct DCFSerReassemblerOptions {
+    size_t   max_streams;       /* Concurrent streams (0 = DCF_SER_REASM_STREAMS) */
+    size_t   max_stream_bytes;  /* Per-stream payload cap (0 = DCF_SER_MAX_MESSAGE) */
+    size_t   max_total_bytes;   /* Buffered bytes across streams (0 = 4 * per-stream) */
+    DCFSerChunkFn on_chunk;     /* Cut-through: deliver chunks instead of buffering */
+    void*    ctx;               /* Opaque argument for on_chunk */
+} DCFSerReassemblerOptions;
+
+/**
+ * In-progress stream (internal)
+ */
+typedef struct DCFSerStreamSlot {
+    uint8_t* buffer;        /* Header reserve + payload so far */
+    size_t   capacity;      /* Allocated bytes */
+    uint64_t length;        /* Payload bytes received */
+    uint16_t msg_type;      /* Key: message type */
+    uint32_t sequence;      /* Key: stream ID */
+    uint8_t  flags;         /* Flags of the first chunk */
+    bool     crc_verified;  /* True while every chunk had a verified CRC */
+    bool     in_use;        /* Slot holds a stream */
+} DCFSerStreamSlot;
+
+/**
+ * Reassembles DCF_SER_FLAG_STREAMING chunks into logical messages
+ */
+typedef struct DCFSerReassembler {
+    DCFSerStreamSlot* slots;    /* max_streams slots */
+    size_t   max_streams;       /* Concurrent stream limit */
+    size_t   active;            /* Streams in progress */
+    size_t   max_stream_bytes;  /* Per-stream payload cap */
+    size_t   max_total_bytes;   /* Cap on buffered bytes */
+    size_t   total_bytes;       /* Bytes buffered across streams */
+    uint8_t* done;              /* Last completed message (valid until next push) */
+    DCFSerChunkFn on_chunk;     /* Cut-through callback (NULL = buffer) */
+    void*    ctx;               /* Opaque argument for on_chunk */
+} DCFSerReassembler;
+
+/* ============================================================================
+ * Stream Framing
+ * ============================================================================ */
+
+/**
+ * Complete message located by the framer (points into the framer buffer)
+ */
+typedef struct DCFSerFrame {
+    const uint8_t* data;    /* Message start (header) */
+    size_t   len;           /* Total message length */
+} DCFSerFrame;
+
+/**
+ * Framer configuration (zero-initialize for defaults)
+ */
+typedef struct DCFSerFramerOptions {
+    size_t   capacity;      /* Initial buffer size (0 = DCF_SER_FRAMER_CAP) */
+    size_t   max_frame;     /* Largest accepted message (0 = DCF_SER_MAX_MESSAGE + framing) */
+    bool     validate;      /* Verify CRCs; corrupt frames trigger a resync */
+} DCFSerFramerOptions;
+
+/**
+ * Splits a byte stream (e.g. TCP) into messages
+ * 
+ * Received bytes accumulate in one linear buffer that is compacted, rather
+ * than wrapped, when space runs out, so every frame is contiguous.
+ * 
+ * After a corrupt frame, compact-header frames (which have no magic) are
+ * found again only with validate set, and only if they carry a CRC.
+ */
+typedef struct DCFSerFramer {
+    uint8_t* buffer;        /* Receive buffer */
+    size_t   capacity;      /* Buffer size */
+    size_t   head;          /* Start of unconsumed data */
+    size_t   tail;          /* End of received data */
+    size_t   need;          /* Length of the partial frame at head (0 = unknown) */
+    size_t   max_frame;     /* Largest accepted message */
+    bool     validate;      /* Verify CRCs before returning frames */
+    uint64_t frames;        /* Frames returned */
+    uint64_t skipped;       /* Bytes discarded while resynchronizing */
+} DCFSerFramer;
+
+/* ============================================================================
+ * Structural Index
+ * ============================================================================ */
+
+#define DCF_SER_INDEX_ROOT UINT32_MAX   /* Parent of top-level values */
+
+/**
+ * One value located by dcf_ser_validate_structure
+ * 
+ * Elements of fixed-width arrays get no entries of their own: element i
+ * sits at offset + 6 + i * (1 + dcf_ser_type_size(elem)).
+ */
+typedef struct DCFSerIndexEntry {
+    uint32_t offset;        /* Tag byte, relative to the payload start */
+    uint32_t end;           /* One past the value (containers: past contents) */
+    uint32_t parent;        /* Entry of the enclosing container, or DCF_SER_INDEX_ROOT */
+    uint16_t field_id;      /* Struct field id (0 outside structs) */
+    uint8_t  type;          /* Value tag */
+    uint8_t  depth;         /* Nesting level (0 = top level) */
+} DCFSerIndexEntry;
+
+/**
+ * Caller-owned entry storage for dcf_ser_validate_structure
+ */
+typedef struct DCFSerIndex {
+    DCFSerIndexEntry* entries;  /* Entry array (caller-owned) */
+    size_t   capacity;      /* Entries available */
+    size_t   count;         /* Entries filled in, in wire order */
+    const uint8_t* payload; /* Payload start the offsets refer to */
+} DCFSerIndex;
+
+/* ============================================================================
+ * Array Offset Index
+ * ============================================================================ */
+
+/**
+ * Sidecar index of every K-th element offset of one array
+ * 
+ * Lets decoding start at any element without walking the ones before it,
+ * and splits large arrays across worker threads.
+ */
+typedef struct DCFSerArrayIndex {
+    size_t*  offsets;       /* Buffer offsets of elements 0, K, 2K, ... (caller-owned) */
+    size_t   capacity;      /* Offsets available */
+    size_t   count;         /* Offsets filled in */
+    size_t   stride;        /* K (0 before build = smallest that fits capacity) */
+    size_t   elements;      /* Array element count */
+    size_t   end;           /* Buffer offset just past the last element */
+    DCFSerType elem_type;   /* Declared element type */
+} DCFSerArrayIndex;
+
+/**
+ * Decodes elements [first, first + count) from r (one call per worker)
+ */
+typedef DCFSerError (*DCFSerElementFn)(void* ctx, DCFSerReader* r, size_t first, size_t count);
+
 /* ============================================================================
  * Schema Definition (for structured serialization)
  * ============================================================================ */
@@ -213,6 +527,7 @@ typedef struct DCFSerField {
     uint16_t    flags;      /* Field flags (optional, repeated, etc.) */
     size_t      offset;     /* Offset within struct (for reflection) */
     size_t      size;       /* Size of field data */
+    const void* default_value; /* DCF_FIELD_DEFAULT value (NULL = zero / empty) */
 } DCFSerField;
 
 typedef struct DCFSerSchema {
@@ -223,11 +538,129 @@ typedef struct DCFSerSchema {
     size_t              struct_size;    /* sizeof(struct) */
 } DCFSerSchema;
 
+typedef struct DCFSerRegistryTable DCFSerRegistryTable;
+
+/**
+ * Schemas keyed by type id and fingerprint (lock-free lookups)
+ * 
+ * The registry references the schemas; they must outlive it. A zeroed
+ * registry is empty and ready to use.
+ */
+typedef struct DCFSerRegistry {
+    DCFSerRegistryTable* table;     /* Published table (atomic) */
+    DCFSerRegistryTable* retired;   /* Replaced tables awaiting reclaim */
+    int         lock;               /* Publisher spinlock */
+} DCFSerRegistry;
+
+/**
+ * One writer field's fate under an evolution plan
+ */
+typedef struct DCFSerPlanStep {
+    int32_t     target;             /* Reader field index (-1 = skipped) */
+    uint8_t     wire_type;          /* Writer field type */
+    uint8_t     op;                 /* Copy, widen or skip (internal) */
+} DCFSerPlanStep;
+
+/**
+ * Precomputed writer-schema to reader-schema translation
+ */
+typedef struct DCFSerPlan {
+    const DCFSerSchema* writer;     /* Producer schema (must outlive the plan) */
+    const DCFSerSchema* reader;     /* Consumer schema (must outlive the plan) */
+    uint64_t    writer_fingerprint; /* Tagless values this plan decodes */
+    DCFSerPlanStep* steps;          /* One per writer field, writer order */
+    uint32_t*   lookup;             /* Reader (field_id << 16 | index), sorted */
+    void*       defaults;           /* Reader struct image for absent fields */
+} DCFSerPlan;
+
+/**
+ * Schema compiled to fixed byte offsets (flyweight codec)
+ */
+typedef struct DCFSerLayout {
+    const DCFSerSchema* schema;     /* Source schema (must outlive the layout) */
+    uint32_t*   offsets;            /* Block offset of each schema field */
+    uint32_t    block_size;         /* Bytes of fixed data */
+    size_t      message_size;       /* Whole message: header, block, CRC */
+} DCFSerLayout;
+
+typedef struct DCFSerArenaChunk DCFSerArenaChunk;
+
+/**
+ * Bump allocator for decoded data (freed all at once by reset)
+ */
+typedef struct DCFSerArena {
+    DCFSerArenaChunk* head;         /* Chunks in use, newest first */
+    DCFSerArenaChunk* spare;        /* Chunks kept by reset for reuse */
+    size_t      chunk_size;         /* Default chunk capacity */
+    size_t      used;               /* Bytes handed out since reset */
+} DCFSerArena;
+
+typedef struct DCFSerDom DCFSerDom;
+
+/**
+ * Lazy DOM node (arena-allocated; children are located on first access)
+ */
+typedef struct DCFSerValue {
+    DCFSerDom*  dom;                /* Owning document */
+    size_t      offset;             /* Position of the value's type tag */
+    DCFSerType  type;               /* Value type */
+    uint16_t    field_id;           /* Field ID when a struct/table member */
+    DCFSerError error;              /* Result of materializing children */
+    size_t      count;              /* Children located so far */
+    struct DCFSerValue* children;   /* Elements, map values, or fields */
+    struct DCFSerValue* keys;       /* Map keys (parallel to children) */
+    bool        materialized;       /* Children have been located */
+} DCFSerValue;
+
+/* Visitor callback results */
+typedef enum DCFSerVisit {
+    DCF_SER_VISIT_CONTINUE = 0,
+    DCF_SER_VISIT_SKIP     = 1,     /* From a begin or on_field: skip that value */
+    DCF_SER_VISIT_STOP     = 2,     /* End the walk (dcf_ser_visit returns OK) */
+} DCFSerVisit;
+
+/**
+ * Typed callbacks for dcf_ser_visit (NULL members are ignored; the value is
+ * still checked and consumed). Strings and bytes point into the message.
+ */
+typedef struct DCFSerVisitor {
+    DCFSerVisit (*on_null)(void* ctx);
+    DCFSerVisit (*on_bool)(void* ctx, bool val);
+    DCFSerVisit (*on_u8)(void* ctx, uint8_t val);
+    DCFSerVisit (*on_i8)(void* ctx, int8_t val);
+    DCFSerVisit (*on_u16)(void* ctx, uint16_t val);
+    DCFSerVisit (*on_i16)(void* ctx, int16_t val);
+    DCFSerVisit (*on_u32)(void* ctx, uint32_t val);
+    DCFSerVisit (*on_i32)(void* ctx, int32_t val);
+    DCFSerVisit (*on_u64)(void* ctx, uint64_t val);
+    DCFSerVisit (*on_i64)(void* ctx, int64_t val);
+    DCFSerVisit (*on_f32)(void* ctx, float val);
+    DCFSerVisit (*on_f64)(void* ctx, double val);
+    DCFSerVisit (*on_varint)(void* ctx, uint64_t val);
+    DCFSerVisit (*on_string)(void* ctx, const char* str, size_t len);
+    DCFSerVisit (*on_bytes)(void* ctx, const void* data, size_t len);
+    DCFSerVisit (*on_uuid)(void* ctx, const uint8_t uuid[16]);
+    DCFSerVisit (*on_timestamp)(void* ctx, uint64_t us);
+    DCFSerVisit (*on_duration)(void* ctx, int64_t ns);
+    /* FIXED, COMPACT_STRUCT and SCHEMA_REF need a schema: raw encoded value */
+    DCFSerVisit (*on_opaque)(void* ctx, DCFSerType type, const void* data, size_t len);
+    DCFSerVisit (*on_array_begin)(void* ctx, DCFSerType elem_type, uint32_t count);
+    DCFSerVisit (*on_array_end)(void* ctx);
+    /* Sorted maps too; keys and values alternate */
+    DCFSerVisit (*on_map_begin)(void* ctx, DCFSerType key_type, DCFSerType val_type, uint32_t count);
+    DCFSerVisit (*on_map_end)(void* ctx);
+    /* Tables too; their fields arrive in ID order */
+    DCFSerVisit (*on_struct_begin)(void* ctx, uint16_t type_id);
+    DCFSerVisit (*on_field)(void* ctx, uint16_t field_id, DCFSerType type);
+    DCFSerVisit (*on_struct_end)(void* ctx);
+} DCFSerVisitor;
+
 /* Field flags */
 #define DCF_FIELD_REQUIRED  0x0001
 #define DCF_FIELD_OPTIONAL  0x0002
 #define DCF_FIELD_REPEATED  0x0004
 #define DCF_FIELD_PACKED    0x0008
+#define DCF_FIELD_DEFAULT   0x0010  /* Omitted on write when equal to its default */
 
 /* ============================================================================
  * Byte Order Utilities (Always convert to/from network order)
@@ -281,6 +714,15 @@ uint32_t dcf_ser_crc32(const void* data, size_t len);
  */
 uint32_t dcf_ser_crc32_update(uint32_t crc, const void* data, size_t len);
 
+/* ============================================================================
+ * Limits API
+ * ============================================================================ */
+
+/**
+ * Fill limits with the compile-time defaults
+ */
+void dcf_ser_limits_default(DCFSerLimits* limits);
+
 /* ============================================================================
  * Writer API
  * ============================================================================ */
@@ -308,8 +750,33 @@ DCFSerError dcf_ser_writer_init(DCFSerWriter* writer, uint16_t msg_type, uint8_t
 DCFSerError dcf_ser_writer_init_buffer(DCFSerWriter* writer, uint8_t* buffer,
                                         size_t capacity, uint16_t msg_type, uint8_t flags);
 
+/**
+ * Initialize a writer with options
+ * 
+ * With headroom/tailroom set, the message is placed so that outer transport
+ * framing can be written in place around it (see dcf_ser_writer_headroom).
+ * 
+ * With a sink set, the payload is streamed: whenever chunk_size bytes are
+ * buffered they are sent as a message with DCF_SER_FLAG_STREAMING, and
+ * finish sends the rest with STREAMING | FINAL. All chunks carry the
+ * writer's sequence number, which identifies the stream. Values may span
+ * chunks; receivers concatenate the payloads. A message that fits in one
+ * chunk is sent as a plain message.
+ * 
+ * @param writer    Writer context to initialize
+ * @param msg_type  Application message type
+ * @param flags     Message flags
+ * @param opts      Options, or NULL for defaults
+ * @return          DCF_SER_OK on success
+ */
+DCFSerError dcf_ser_writer_init_ex(DCFSerWriter* writer, uint16_t msg_type, uint8_t flags,
+                                   const DCFSerWriterOptions* opts);
+
 /**
  * Clean up writer resources
+ * 
+ * Must also be called for external-buffer writers that used
+ * dcf_ser_write_bytes_ref (the segment list is heap-allocated).
  */
 void dcf_ser_writer_destroy(DCFSerWriter* writer);
 
@@ -321,6 +788,12 @@ void dcf_ser_writer_reset(DCFSerWriter* writer, uint16_t msg_type, uint8_t flags
 /**
  * Finalize the message (write header and CRC)
  * 
+ * With DCF_SER_FLAG_COMPACT the compact header is emitted, unless the flags
+ * include bits it cannot express, in which case the full header is used.
+ * 
+ * For sink writers the final chunk is sent; *out_data is set to NULL and
+ * *out_len to the total wire bytes sent for the message.
+ * 
  * @param writer    Writer context
  * @param out_data  Output pointer to serialized data
  * @param out_len   Output length of serialized data
@@ -328,6 +801,61 @@ void dcf_ser_writer_reset(DCFSerWriter* writer, uint16_t msg_type, uint8_t flags
  */
 DCFSerError dcf_ser_writer_finish(DCFSerWriter* writer, const uint8_t** out_data, size_t* out_len);
 
+/**
+ * Finalize the message as a gather list (write header and CRC)
+ * 
+ * Byte references added with dcf_ser_write_bytes_ref are emitted as their
+ * own vectors, so they reach writev()/sendmsg() without a user-space copy.
+ * The referenced memory must stay valid until the vectors are consumed.
+ * 
+ * @param writer    Writer context
+ * @param iov       Output vector array
+ * @param max_iov   Capacity of iov (see dcf_ser_writer_iov_count)
+ * @param out_count Number of vectors filled
+ * @return          DCF_SER_OK on success, DCF_SER_ERR_BUFFER_FULL if iov is too small
+ *                  (DCF_SER_ERR_INVALID_ARG for sink writers)
+ */
+DCFSerError dcf_ser_writer_finish_iov(DCFSerWriter* writer, DCFSerIoVec* iov,
+                                      size_t max_iov, size_t* out_count);
+
+/**
+ * Send the buffered payload as a non-final chunk (sink writers only)
+ * 
+ * Chunks are also flushed automatically at chunk_size; this forces one
+ * early, e.g. to bound latency. No-op if nothing is buffered. Returns
+ * DCF_SER_ERR_MALFORMED inside a batch or an open sorted map, table or
+ * compact struct.
+ */
+DCFSerError dcf_ser_writer_flush(DCFSerWriter* writer);
+
+#ifdef DCF_SER_PLATFORM_POSIX
+/**
+ * Sink that write()s every chunk to a file descriptor (ctx points to an int)
+ */
+DCFSerError dcf_ser_fd_sink(void* ctx, const void* data, size_t len);
+#endif
+
+/**
+ * Number of vectors dcf_ser_writer_finish_iov will produce
+ */
+size_t dcf_ser_writer_iov_count(const DCFSerWriter* writer);
+
+/**
+ * Get the headroom in front of a finished message
+ * 
+ * The region ends exactly where the message starts; it is at least the
+ * requested headroom. Only valid after dcf_ser_writer_finish.
+ */
+DCFSerError dcf_ser_writer_headroom(DCFSerWriter* writer, uint8_t** out_ptr, size_t* out_len);
+
+/**
+ * Get the tailroom behind a finished message
+ * 
+ * The region starts right after the CRC; it is at least the requested
+ * tailroom. Only valid after dcf_ser_writer_finish.
+ */
+DCFSerError dcf_ser_writer_tailroom(DCFSerWriter* writer, uint8_t** out_ptr, size_t* out_len);
+
 /**
  * Get current buffer position (payload size so far)
  */
@@ -338,6 +866,14 @@ size_t dcf_ser_writer_payload_size(const DCFSerWriter* writer);
  */
 void dcf_ser_writer_set_sequence(DCFSerWriter* writer, uint32_t seq);
 
+/**
+ * Set the base that compact headers encode the sequence relative to
+ * 
+ * A compact header carries (sequence - base) as a varint and omits it when
+ * zero; the receiver must use the same base (dcf_ser_reader_set_sequence_base).
+ */
+void dcf_ser_writer_set_sequence_base(DCFSerWriter* writer, uint32_t base);
+
 /* ----------------------------------------------------------------------------
  * Primitive Writers
  * ---------------------------------------------------------------------------- */
@@ -376,6 +912,17 @@ DCFSerError dcf_ser_write_string_n(DCFSerWriter* w, const char* str, size_t len)
  */
 DCFSerError dcf_ser_write_bytes(DCFSerWriter* w, const void* data, size_t len);
 
+/**
+ * Write length-prefixed byte array by reference (zero-copy)
+ * 
+ * Records the caller's pointer as an external segment instead of copying it.
+ * The data must remain valid until the message has been sent. Payloads
+ * shorter than DCF_SER_REF_MIN_LEN are copied, as a vector costs more.
+ * dcf_ser_writer_finish still returns a contiguous message (the segments are
+ * copied in at that point); use dcf_ser_writer_finish_iov to avoid the copy.
+ */
+DCFSerError dcf_ser_write_bytes_ref(DCFSerWriter* w, const void* data, size_t len);
+
 /**
  * Write 16-byte UUID
  */
@@ -420,6 +967,27 @@ DCFSerError dcf_ser_write_map_begin(DCFSerWriter* w, DCFSerType key_type,
  */
 DCFSerError dcf_ser_write_map_end(DCFSerWriter* w);
 
+/**
+ * Begin writing a key-sorted map
+ * 
+ * Write the entries in any order; dcf_ser_write_sorted_map_end sorts them
+ * (integers numerically, strings bytewise) and fills in an offset table so
+ * readers can binary search with dcf_ser_map_find. The map stays buffered
+ * until then, even on sink writers.
+ * 
+ * @param key_type  Integer type, DCF_TYPE_VARINT or DCF_TYPE_STRING
+ */
+DCFSerError dcf_ser_write_sorted_map_begin(DCFSerWriter* w, DCFSerType key_type,
+                                           DCFSerType val_type, size_t count);
+
+/**
+ * End sorted map writing
+ * 
+ * @return          DCF_SER_ERR_MALFORMED if the entry count does not match,
+ *                  DCF_SER_ERR_INVALID_ARG on duplicate keys
+ */
+DCFSerError dcf_ser_write_sorted_map_end(DCFSerWriter* w);
+
 /**
  * Begin writing a struct
  * 
@@ -438,6 +1006,32 @@ DCFSerError dcf_ser_write_field(DCFSerWriter* w, uint16_t field_id, DCFSerType t
  */
 DCFSerError dcf_ser_write_struct_end(DCFSerWriter* w);
 
+/**
+ * Begin writing a table: a struct whose fields are reachable in O(1)
+ * 
+ * The header is followed by one u32 slot per possible field id, pointing
+ * at that field's value (0 = absent). Mark each field with
+ * dcf_ser_write_table_field, then write its value. Like sorted maps, the
+ * table stays buffered until it ends, even on sink writers.
+ * 
+ * @param max_field_id  Highest field id used (ids run 1..max_field_id)
+ */
+DCFSerError dcf_ser_write_table_begin(DCFSerWriter* w, uint16_t type_id, uint16_t max_field_id);
+
+/**
+ * Start a table field; write its value next
+ * 
+ * @return          DCF_SER_ERR_INVALID_ARG for ids out of range or repeated,
+ *                  DCF_SER_ERR_MALFORMED if the previous field has no value
+ *                  or a nested container is still open (also for _end)
+ */
+DCFSerError dcf_ser_write_table_field(DCFSerWriter* w, uint16_t field_id);
+
+/**
+ * End table writing
+ */
+DCFSerError dcf_ser_write_table_end(DCFSerWriter* w);
+
 /* ----------------------------------------------------------------------------
  * Raw/Direct Writers
  * ---------------------------------------------------------------------------- */
@@ -452,6 +1046,30 @@ DCFSerError dcf_ser_write_raw(DCFSerWriter* w, const void* data, size_t len);
  */
 DCFSerError dcf_ser_write_reserve(DCFSerWriter* w, size_t len, uint8_t** out_ptr);
 
+/* ----------------------------------------------------------------------------
+ * Batch Writers
+ * 
+ * A writer initialized with msg_type DCF_SER_MSG_BATCH packs many logical
+ * messages under one header and one CRC. Each sub-message is encoded as
+ * varint msg_type, varint sequence, varint length, then its payload.
+ * ---------------------------------------------------------------------------- */
+
+/**
+ * Begin a sub-message; write its payload with the normal writers
+ */
+DCFSerError dcf_ser_batch_begin(DCFSerWriter* w, uint16_t msg_type, uint32_t sequence);
+
+/**
+ * End the current sub-message
+ */
+DCFSerError dcf_ser_batch_end(DCFSerWriter* w);
+
+/**
+ * Append a sub-message from an already encoded payload
+ */
+DCFSerError dcf_ser_batch_append(DCFSerWriter* w, uint16_t msg_type, uint32_t sequence,
+                                 const void* payload, size_t len);
+
 /* ============================================================================
  * Reader API
  * ============================================================================ */
@@ -467,15 +1085,83 @@ DCFSerError dcf_ser_write_reserve(DCFSerWriter* w, size_t len, uint8_t** out_ptr
 DCFSerError dcf_ser_reader_init(DCFSerReader* reader, const void* data, size_t len);
 
 /**
- * Validate and parse the message header
+ * Override the decoding limits (call before validate)
+ */
+DCFSerError dcf_ser_reader_set_limits(DCFSerReader* reader, const DCFSerLimits* limits);
+
+/**
+ * Set the compact-header sequence base (call before validate)
+ */
+void dcf_ser_reader_set_sequence_base(DCFSerReader* reader, uint32_t base);
+
+/**
+ * Validate and parse the message header (full or compact)
  */
 DCFSerError dcf_ser_reader_validate(DCFSerReader* reader);
 
+/**
+ * Initialize a reader over a partially received message
+ * 
+ * Values can be read as soon as their bytes arrive. A read that runs into
+ * missing data returns DCF_SER_ERR_NEED_MORE and leaves the reader at the
+ * start of that value (container depth is kept), so the same call can be
+ * retried after dcf_ser_reader_feed. The CRC is computed as data arrives
+ * and checked once the message is complete; values read before then are
+ * unverified until dcf_ser_reader_finish returns DCF_SER_OK.
+ * 
+ * @param reader    Reader context to initialize
+ * @param data      Received bytes so far (message start)
+ * @param avail     Number of bytes received
+ * @return          DCF_SER_OK once the header is parsed, DCF_SER_ERR_NEED_MORE
+ *                  before that, or a header error
+ */
+DCFSerError dcf_ser_reader_init_incremental(DCFSerReader* reader, const void* data, size_t avail);
+
+/**
+ * Report more received bytes to an incremental reader
+ * 
+ * @param reader    Incremental reader
+ * @param data      Message start (may differ from before if the buffer moved)
+ * @param avail     Total bytes received so far (never less than before)
+ * @return          DCF_SER_OK, DCF_SER_ERR_NEED_MORE if the header is still
+ *                  incomplete, or DCF_SER_ERR_CRC_MISMATCH once complete
+ */
+DCFSerError dcf_ser_reader_feed(DCFSerReader* reader, const void* data, size_t avail);
+
+/**
+ * Check that an incremental message has fully arrived and its CRC matched
+ * 
+ * @return          DCF_SER_OK, DCF_SER_ERR_NEED_MORE, or DCF_SER_ERR_CRC_MISMATCH
+ */
+DCFSerError dcf_ser_reader_finish(const DCFSerReader* reader);
+
+/**
+ * Initialize a reader over a message split across segments
+ * 
+ * Validate as usual; the CRC is computed across segments. Values inside
+ * one segment are decoded in place. Values that straddle a boundary are
+ * copied to the reader's scratch space (zero-copy string/bytes results then
+ * point there and are valid until the next read); larger ones fail with
+ * DCF_SER_ERR_FRAGMENTED and are read with dcf_ser_read_bytes_iov, or
+ * skipped. Batch iteration needs a contiguous message.
+ * 
+ * @param reader    Reader context to initialize
+ * @param iov       Segments in order (must outlive the reader)
+ * @param count     Number of segments
+ * @return          DCF_SER_OK on success
+ */
+DCFSerError dcf_ser_reader_init_iov(DCFSerReader* reader, const DCFSerIoVec* iov, size_t count);
+
 /**
  * Get parsed header
  */
 const DCFSerHeader* dcf_ser_reader_header(const DCFSerReader* reader);
 
+/**
+ * Get payload length (64-bit: header.payload_len saturates for extended headers)
+ */
+uint64_t dcf_ser_reader_payload_length(const DCFSerReader* reader);
+
 /**
  * Get message type from header
  */
@@ -496,6 +1182,34 @@ bool dcf_ser_reader_at_end(const DCFSerReader* reader);
  */
 DCFSerType dcf_ser_reader_peek_type(const DCFSerReader* reader);
 
+/**
+ * Prove the payload well-formed in one pass (no recursion)
+ * 
+ * Checks every tag, length, count and the nesting depth against the
+ * reader's limits, and that array/map elements and struct field values
+ * carry their declared types. On success the reader is marked trusted and
+ * the dcf_ser_read_*_unchecked functions may be used on it.
+ * 
+ * @return          DCF_SER_OK, or the first structural error found
+ */
+DCFSerError dcf_ser_reader_trust(DCFSerReader* reader);
+
+/**
+ * Read bytes as a list of in-place fragments (one per segment touched)
+ * 
+ * Works on any reader; contiguous readers always produce one fragment.
+ * 
+ * @param r         Reader
+ * @param frags     Output fragments
+ * @param max_frags Capacity of frags
+ * @param out_count Fragments filled
+ * @param out_len   Total value length
+ * @return          DCF_SER_OK, or DCF_SER_ERR_BUFFER_FULL if frags is too
+ *                  small (the reader does not advance)
+ */
+DCFSerError dcf_ser_read_bytes_iov(DCFSerReader* r, DCFSerIoVec* frags, size_t max_frags,
+                                   size_t* out_count, size_t* out_len);
+
 /**
  * Skip a value (useful for unknown fields)
  */
@@ -563,13 +1277,34 @@ DCFSerError dcf_ser_read_array_begin(DCFSerReader* r, DCFSerType* out_elem_type,
 DCFSerError dcf_ser_read_array_end(DCFSerReader* r);
 
 /**
- * Read map header
+ * Read map header (plain or sorted; sorted maps come back in key order)
  */
 DCFSerError dcf_ser_read_map_begin(DCFSerReader* r, DCFSerType* out_key_type,
                                     DCFSerType* out_val_type, size_t* out_count);
 
 DCFSerError dcf_ser_read_map_end(DCFSerReader* r);
 
+/**
+ * Look up a string key in the sorted map at the reader position
+ * 
+ * O(log n): only the probed keys are decoded. `r` is left untouched, so
+ * several keys can be looked up before skipping the map.
+ * 
+ * @param out_value Positioned at the value on success
+ * @return          DCF_SER_OK, DCF_SER_ERR_NOT_FOUND, or
+ *                  DCF_SER_ERR_TYPE_MISMATCH if not a string-keyed sorted map
+ */
+DCFSerError dcf_ser_map_find(const DCFSerReader* r, const char* key, size_t key_len,
+                             DCFSerReader* out_value);
+
+/**
+ * Look up an integer key in the sorted map at the reader position
+ * 
+ * Unsigned 64-bit keys above INT64_MAX are passed as their int64_t bit pattern.
+ * Keys outside the map's key type range are DCF_SER_ERR_NOT_FOUND.
+ */
+DCFSerError dcf_ser_map_find_int(const DCFSerReader* r, int64_t key, DCFSerReader* out_value);
+
 /**
  * Read struct header
  */
@@ -582,6 +1317,24 @@ DCFSerError dcf_ser_read_field(DCFSerReader* r, uint16_t* out_field_id, DCFSerTy
 
 DCFSerError dcf_ser_read_struct_end(DCFSerReader* r);
 
+/**
+ * Get the type id and slot count of the table at the reader position
+ */
+DCFSerError dcf_ser_table_info(const DCFSerReader* r, uint16_t* out_type_id,
+                               uint16_t* out_max_field_id);
+
+/**
+ * Jump straight to one field of the table at the reader position
+ * 
+ * Reads one slot; no other field is decoded or skipped. `r` is left
+ * untouched (skip the table with dcf_ser_reader_skip when done).
+ * 
+ * @param out_value Positioned at the field value, bounded by the table body
+ * @return          DCF_SER_OK, DCF_SER_ERR_NOT_FOUND if the field is absent,
+ *                  or DCF_SER_ERR_TYPE_MISMATCH if not at a table
+ */
+DCFSerError dcf_ser_table_field(const DCFSerReader* r, uint16_t field_id, DCFSerReader* out_value);
+
 /* ----------------------------------------------------------------------------
  * Raw/Direct Readers
  * ---------------------------------------------------------------------------- */
@@ -596,22 +1349,870 @@ DCFSerError dcf_ser_read_raw(DCFSerReader* r, void* out, size_t len);
  */
 DCFSerError dcf_ser_read_raw_ptr(DCFSerReader* r, const void** out_ptr, size_t len);
 
-/* ============================================================================
+/* ----------------------------------------------------------------------------
+ * Array Offset Index
+ * ---------------------------------------------------------------------------- */
+
+/**
+ * Index the array at the reader position
+ * 
+ * Skips over the elements once (fixed-width elements only have their tag
+ * bytes checked) and records every idx->stride-th offset. On success the
+ * reader is past the array, as after reading every element and
+ * dcf_ser_read_array_end.
+ * 
+ * @return          DCF_SER_ERR_BUFFER_FULL if idx->capacity is too small,
+ *                  DCF_SER_ERR_TYPE_MISMATCH if a fixed-width element has
+ *                  another tag
+ */
+DCFSerError dcf_ser_array_index_build(DCFSerReader* r, DCFSerArrayIndex* idx);
+
+/**
+ * Make an independent reader positioned at an array element
+ * 
+ * `out` is bounded by the end of the array and starts at array depth, so
+ * it can be handed to another thread while `r` is left untouched.
+ */
+DCFSerError dcf_ser_array_index_seek(const DCFSerReader* r, const DCFSerArrayIndex* idx,
+                                     size_t element, DCFSerReader* out);
+
+/**
+ * Decode an indexed array on up to `threads` threads
+ * 
+ * Elements are split into contiguous ranges starting on indexed offsets;
+ * fn runs once per range (the first on the calling thread) with its own
+ * reader. fn must only touch state for its own elements. Without POSIX
+ * threads the ranges run one after another.
+ * 
+ * @return          DCF_SER_OK, or the error of the lowest failing range
+ */
+DCFSerError dcf_ser_array_decode_parallel(const DCFSerReader* r, const DCFSerArrayIndex* idx,
+                                          unsigned threads, DCFSerElementFn fn, void* ctx);
+
+/* ----------------------------------------------------------------------------
+ * Unchecked Readers (trusted readers only)
+ * 
+ * Plain loads with no NULL, tag or bounds checks. Only valid after
+ * dcf_ser_reader_trust succeeded, and only when reading values in the
+ * order and with the types they were written (peek first if unsure).
+ * Debug builds assert both.
+ * ---------------------------------------------------------------------------- */
+
+#if defined(DEBUG) && !defined(NDEBUG)
+    #define DCF_SER_UNCHECKED_TAG(r, t) \
+        assert((r)->trusted && (r)->position < (r)->payload_end && \
+               (r)->buffer[(r)->position] == (t))
+    #define DCF_SER_UNCHECKED_TAG2(r, t1, t2) \
+        assert((r)->trusted && (r)->position < (r)->payload_end && \
+               ((r)->buffer[(r)->position] == (t1) || (r)->buffer[(r)->position] == (t2)))
+#else
+    #define DCF_SER_UNCHECKED_TAG(r, t) ((void)0)
+    #define DCF_SER_UNCHECKED_TAG2(r, t1, t2) ((void)0)
+#endif
+
+static inline uint16_t dcf_ser_load16_(const uint8_t* p) {
+    return (uint16_t)(((uint16_t)p[0] << 8) | p[1]);
+}
+
+static inline uint32_t dcf_ser_load32_(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static inline uint64_t dcf_ser_load64_(const uint8_t* p) {
+    return ((uint64_t)dcf_ser_load32_(p) << 32) | dcf_ser_load32_(p + 4);
+}
+
+static inline bool dcf_ser_read_bool_unchecked(DCFSerReader* r) {
+    DCF_SER_UNCHECKED_TAG(r, DCF_TYPE_BOOL);
+    bool v = r->buffer[r->position + 1] != 0;
+    r->position += 2;
+    return v;
+}
+
+static inline uint8_t dcf_ser_read_u8_unchecked(DCFSerReader* r) {
+    DCF_SER_UNCHECKED_TAG(r, DCF_TYPE_U8);
+    uint8_t v = r->buffer[r->position + 1];
+    r->position += 2;
+    return v;
+}
+
+static inline int8_t dcf_ser_read_i8_unchecked(DCFSerReader* r) {
+    DCF_SER_UNCHECKED_TAG(r, DCF_TYPE_I8);
+    int8_t v = (int8_t)r->buffer[r->position + 1];
+    r->position += 2;
+    return v;
+}
+
+static inline uint16_t dcf_ser_read_u16_unchecked(DCFSerReader* r) {
+    DCF_SER_UNCHECKED_TAG(r, DCF_TYPE_U16);
+    uint16_t v = dcf_ser_load16_(r->buffer + r->position + 1);
+    r->position += 3;
+    return v;
+}
+
+static inline int16_t dcf_ser_read_i16_unchecked(DCFSerReader* r) {
+    DCF_SER_UNCHECKED_TAG(r, DCF_TYPE_I16);
+    int16_t v = (int16_t)dcf_ser_load16_(r->buffer + r->position + 1);
+    r->position += 3;
+    return v;
+}
+
+static inline uint32_t dcf_ser_read_u32_unchecked(DCFSerReader* r) {
+    DCF_SER_UNCHECKED_TAG(r, DCF_TYPE_U32);
+    uint32_t v = dcf_ser_load32_(r->buffer + r->position + 1);
+    r->position += 5;
+    return v;
+}
+
+static inline int32_t dcf_ser_read_i32_unchecked(DCFSerReader* r) {
+    DCF_SER_UNCHECKED_TAG(r, DCF_TYPE_I32);
+    int32_t v = (int32_t)dcf_ser_load32_(r->buffer + r->position + 1);
+    r->position += 5;
+    return v;
+}
+
+static inline uint64_t dcf_ser_read_u64_unchecked(DCFSerReader* r) {
+    DCF_SER_UNCHECKED_TAG(r, DCF_TYPE_U64);
+    uint64_t v = dcf_ser_load64_(r->buffer + r->position + 1);
+    r->position += 9;
+    return v;
+}
+
+static inline int64_t dcf_ser_read_i64_unchecked(DCFSerReader* r) {
+    DCF_SER_UNCHECKED_TAG(r, DCF_TYPE_I64);
+    int64_t v = (int64_t)dcf_ser_load64_(r->buffer + r->position + 1);
+    r->position += 9;
+    return v;
+}
+
+static inline float dcf_ser_read_f32_unchecked(DCFSerReader* r) {
+    DCF_SER_UNCHECKED_TAG(r, DCF_TYPE_F32);
+    union { uint32_t u; float f; } v;
+    v.u = dcf_ser_load32_(r->buffer + r->position + 1);
+    r->position += 5;
+    return v.f;
+}
+
+static inline double dcf_ser_read_f64_unchecked(DCFSerReader* r) {
+    DCF_SER_UNCHECKED_TAG(r, DCF_TYPE_F64);
+    union { uint64_t u; double f; } v;
+    v.u = dcf_ser_load64_(r->buffer + r->position + 1);
+    r->position += 9;
+    return v.f;
+}
+
+static inline uint64_t dcf_ser_read_timestamp_unchecked(DCFSerReader* r) {
+    DCF_SER_UNCHECKED_TAG(r, DCF_TYPE_TIMESTAMP);
+    uint64_t v = dcf_ser_load64_(r->buffer + r->position + 1);
+    r->position += 9;
+    return v;
+}
+
+static inline uint64_t dcf_ser_read_varint_unchecked(DCFSerReader* r) {
+    DCF_SER_UNCHECKED_TAG(r, DCF_TYPE_VARINT);
+    const uint8_t* p = r->buffer + r->position + 1;
+    uint64_t v = 0;
+    unsigned shift = 0;
+    size_t i = 0;
+    uint8_t b;
+    do {
+        b = p[i++];
+        v |= (uint64_t)(b & 0x7F) << shift;
+        shift += 7;
+    } while (b & 0x80);
+    r->position += 1 + i;
+    return v;
+}
+
+static inline const char* dcf_ser_read_string_unchecked(DCFSerReader* r, size_t* out_len) {
+    DCF_SER_UNCHECKED_TAG(r, DCF_TYPE_STRING);
+    *out_len = dcf_ser_load32_(r->buffer + r->position + 1);
+    const char* s = (const char*)(r->buffer + r->position + 5);
+    r->position += 5 + *out_len;
+    return s;
+}
+
+static inline const void* dcf_ser_read_bytes_unchecked(DCFSerReader* r, size_t* out_len) {
+    DCF_SER_UNCHECKED_TAG(r, DCF_TYPE_BYTES);
+    *out_len = dcf_ser_load32_(r->buffer + r->position + 1);
+    const void* d = r->buffer + r->position + 5;
+    r->position += 5 + *out_len;
+    return d;
+}
+
+/** Returns the element count; the element type is as declared when writing */
+static inline size_t dcf_ser_read_array_begin_unchecked(DCFSerReader* r) {
+    DCF_SER_UNCHECKED_TAG(r, DCF_TYPE_ARRAY);
+    size_t count = dcf_ser_load32_(r->buffer + r->position + 2);
+    r->position += 6;
+    r->depth++;
+    return count;
+}
+
+/** Returns the entry count (sorted maps too: their offset table is skipped) */
+static inline size_t dcf_ser_read_map_begin_unchecked(DCFSerReader* r) {
+    DCF_SER_UNCHECKED_TAG2(r, DCF_TYPE_MAP, DCF_TYPE_SORTED_MAP);
+    bool sorted = r->buffer[r->position] == DCF_TYPE_SORTED_MAP;
+    size_t count = dcf_ser_load32_(r->buffer + r->position + 3);
+    r->position += 7 + (sorted ? count * 4 : 0);
+    r->depth++;
+    return count;
+}
+
+/** Returns the struct type_id */
+static inline uint16_t dcf_ser_read_struct_begin_unchecked(DCFSerReader* r) {
+    DCF_SER_UNCHECKED_TAG(r, DCF_TYPE_STRUCT);
+    uint16_t type_id = dcf_ser_load16_(r->buffer + r->position + 1);
+    r->position += 3;
+    r->depth++;
+    return type_id;
+}
+
+/** Returns false (and consumes the marker) at the end of the struct */
+static inline bool dcf_ser_read_field_unchecked(DCFSerReader* r, uint16_t* out_field_id,
+                                                DCFSerType* out_type) {
+    *out_field_id = dcf_ser_load16_(r->buffer + r->position);
+    *out_type = (DCFSerType)r->buffer[r->position + 2];
+    r->position += 3;
+    return !(*out_field_id == 0 && *out_type == DCF_TYPE_NULL);
+}
+
+/** Closes an array, map or struct */
+static inline void dcf_ser_read_end_unchecked(DCFSerReader* r) {
+    r->depth--;
+}
+
+/* ----------------------------------------------------------------------------
+ * Batch Readers
+ * ---------------------------------------------------------------------------- */
+
+/**
+ * Start iterating a validated DCF_SER_MSG_BATCH message
+ */
+DCFSerError dcf_ser_batch_iter_init(DCFSerBatchIter* it, const DCFSerReader* reader);
+
+/**
+ * Get the next sub-message as a reader over the batch buffer (zero-copy)
+ * 
+ * The sub-reader reports the sub-message msg_type/sequence in its header and
+ * inherits the batch's CRC status. Returns DCF_SER_ERR_NOT_FOUND at the end.
+ */
+DCFSerError dcf_ser_batch_next(DCFSerBatchIter* it, DCFSerReader* out);
+
+/* ============================================================================
  * Schema-Based Serialization
  * ============================================================================ */
 
 /**
  * Serialize a struct using schema
+ * 
+ * DCF_FIELD_DEFAULT fields equal to their default are not written.
  */
 DCFSerError dcf_ser_write_struct_schema(DCFSerWriter* w, const void* data,
                                          const DCFSerSchema* schema);
 
 /**
  * Deserialize a struct using schema
+ * 
+ * Fields missing from the message are zero, or their declared default.
  */
 DCFSerError dcf_ser_read_struct_schema(DCFSerReader* r, void* data,
                                         const DCFSerSchema* schema);
 
+/**
+ * Deserialize only selected fields of a struct
+ * 
+ * Bit i of field_mask selects schema->fields[i] (the first 64 fields can be
+ * selected); other members are zero or their default. Accepts tagged
+ * structs, tables and tagless values. Structs stop matching field ids once
+ * every selected field has been read and skip the rest; tables read only
+ * the selected slots; tagless values stop after the last selected field and
+ * jump to the end of the body.
+ */
+DCFSerError dcf_ser_read_struct_projected(DCFSerReader* r, void* data,
+                                           const DCFSerSchema* schema, uint64_t field_mask);
+
+/* ----------------------------------------------------------------------------
+ * Compact Structs
+ * 
+ * DCF_TYPE_COMPACT_STRUCT drops per-field headers and type tags: both sides
+ * share the schema, so the encoder writes a presence bitmap (one bit per
+ * schema field) followed by the untagged values of present fields in schema
+ * order. Optional fields holding zero are absent and cost one bit. Fields
+ * the schema does not know travel as extensions (varint id + tagged value)
+ * after the schema section. A body length keeps the value skippable by
+ * readers without the schema.
+ * ---------------------------------------------------------------------------- */
+
+/**
+ * Begin a compact struct and write its schema fields from data
+ * 
+ * Extensions may follow (dcf_ser_write_compact_ext) before
+ * dcf_ser_write_compact_struct_end.
+ */
+DCFSerError dcf_ser_write_compact_struct_begin(DCFSerWriter* w, const void* data,
+                                                const DCFSerSchema* schema);
+
+/**
+ * Write an extension field header; write exactly one tagged value after it
+ * 
+ * @param field_id  Non-zero field id
+ */
+DCFSerError dcf_ser_write_compact_ext(DCFSerWriter* w, uint16_t field_id);
+
+/**
+ * End a compact struct and patch its body length
+ */
+DCFSerError dcf_ser_write_compact_struct_end(DCFSerWriter* w);
+
+/**
+ * Serialize a struct as a compact struct (begin + end, no extensions)
+ */
+DCFSerError dcf_ser_write_struct_compact(DCFSerWriter* w, const void* data,
+                                          const DCFSerSchema* schema);
+
+/**
+ * Begin reading a compact struct into data
+ * 
+ * Absent fields are zero or their declared default. Fields appended by a
+ * newer schema are skipped;
+ * fields missing from an older encoder are left zero. String fields are
+ * skipped, as in dcf_ser_read_struct_schema.
+ * 
+ * @return          DCF_SER_ERR_TYPE_MISMATCH if the type id differs
+ */
+DCFSerError dcf_ser_read_compact_struct_begin(DCFSerReader* r, void* data,
+                                               const DCFSerSchema* schema);
+
+/**
+ * Read the next extension field id; the tagged value follows
+ * 
+ * @return          DCF_SER_ERR_NOT_FOUND when no extensions remain
+ */
+DCFSerError dcf_ser_read_compact_ext(DCFSerReader* r, uint16_t* field_id);
+
+/**
+ * End a compact struct, skipping unread extensions
+ */
+DCFSerError dcf_ser_read_compact_struct_end(DCFSerReader* r);
+
+/**
+ * Deserialize a compact struct (begin + end, extensions skipped)
+ */
+DCFSerError dcf_ser_read_struct_compact(DCFSerReader* r, void* data,
+                                         const DCFSerSchema* schema);
+
+/* ----------------------------------------------------------------------------
+ * Schema Fingerprints and Tagless Structs
+ * 
+ * Registry lookups never lock and may run on any thread while another
+ * thread publishes. Publishing builds a new table and swaps it in (RCU
+ * style); the replaced table stays readable until dcf_ser_registry_reclaim,
+ * which must only run once lookups started before the swap have returned.
+ * 
+ * A DCF_TYPE_SCHEMA_REF value names its schema by a 64-bit fingerprint and
+ * carries every field value untagged, in schema order. Peers that share the
+ * schema register it; the writer uses the tagless form only for schemas the
+ * peer has registered and otherwise falls back to the self-describing struct
+ * encoding. A body length keeps the value skippable without the schema.
+ * ---------------------------------------------------------------------------- */
+
+/**
+ * Fingerprint of a schema's wire shape
+ * 
+ * Covers type id, field order, ids, types and flags; field names, offsets
+ * and struct sizes do not change it.
+ */
+uint64_t dcf_ser_schema_fingerprint(const DCFSerSchema* schema);
+
+/**
+ * Initialize an empty registry
+ */
+DCFSerError dcf_ser_registry_init(DCFSerRegistry* reg);
+
+/**
+ * Free registry storage (not the schemas); no lookups may be in flight
+ */
+void dcf_ser_registry_destroy(DCFSerRegistry* reg);
+
+/**
+ * Publish a schema
+ * 
+ * The schema becomes the current version for its type id. Earlier versions
+ * stay reachable by fingerprint, so in-flight tagless messages still decode.
+ * Thread-safe against lookups and other publishers.
+ */
+DCFSerError dcf_ser_registry_add(DCFSerRegistry* reg, const DCFSerSchema* schema);
+
+/**
+ * Free tables replaced by earlier publications
+ * 
+ * Call from a quiescent point: no lookup that began before the latest
+ * dcf_ser_registry_add may still be running.
+ */
+void dcf_ser_registry_reclaim(DCFSerRegistry* reg);
+
+/**
+ * Look up a schema by fingerprint (lock-free)
+ * 
+ * @return          Registered schema, or NULL
+ */
+const DCFSerSchema* dcf_ser_registry_find(const DCFSerRegistry* reg, uint64_t fingerprint);
+
+/**
+ * Look up the current schema version for a struct type id (lock-free)
+ * 
+ * @return          Most recently published schema, or NULL
+ */
+const DCFSerSchema* dcf_ser_registry_find_type(const DCFSerRegistry* reg, uint16_t type_id);
+
+/**
+ * Number of registered schema versions
+ */
+size_t dcf_ser_registry_count(const DCFSerRegistry* reg);
+
+/**
+ * Process-wide registry (never destroyed implicitly)
+ */
+DCFSerRegistry* dcf_ser_registry_global(void);
+
+/**
+ * Serialize a struct as a tagless DCF_TYPE_SCHEMA_REF value
+ */
+DCFSerError dcf_ser_write_struct_tagless(DCFSerWriter* w, const void* data,
+                                          const DCFSerSchema* schema);
+
+/**
+ * Serialize tagless if the peer registry knows the schema, else self-describing
+ * 
+ * @param peer      Schemas the receiver has registered (NULL = none)
+ */
+DCFSerError dcf_ser_write_struct_negotiated(DCFSerWriter* w, const void* data,
+                                             const DCFSerSchema* schema,
+                                             const DCFSerRegistry* peer);
+
+/**
+ * Deserialize a tagless struct written with this schema
+ * 
+ * String fields are skipped, as in dcf_ser_read_struct_schema.
+ * 
+ * @return          DCF_SER_ERR_TYPE_MISMATCH if the fingerprint differs
+ *                  (reader left at the value)
+ */
+DCFSerError dcf_ser_read_struct_tagless(DCFSerReader* r, void* data,
+                                         const DCFSerSchema* schema);
+
+/**
+ * Deserialize a tagless or self-describing struct using a registry
+ * 
+ * Tagless values are resolved by fingerprint, self-describing structs by
+ * the current version for their type id. data must be large enough for any
+ * registered schema.
+ * 
+ * @param out_schema  Schema used to decode (optional)
+ * @return          DCF_SER_ERR_NOT_FOUND if no schema matches (nothing consumed)
+ */
+DCFSerError dcf_ser_read_struct_registered(DCFSerReader* r, const DCFSerRegistry* reg,
+                                            void* data, const DCFSerSchema** out_schema);
+
+/* ----------------------------------------------------------------------------
+ * Schema Evolution Plans
+ * 
+ * Resolving a writer schema against a reader schema once yields a plan:
+ * writer-only fields become skips, fields retyped to a wider numeric type
+ * become conversions, and reader-only fields take their value from a
+ * default image. Decoding through the plan then does no per-field lookups
+ * on tagless values and one binary search per field on tagged structs.
+ * 
+ * Widening is lossless only: unsigned to wider unsigned or signed, signed
+ * to wider signed, integers up to 32 bits to f64 (16 bits to f32), f32 to
+ * f64, and varint to or from u64.
+ * ---------------------------------------------------------------------------- */
+
+/**
+ * Precompute the translation from writer schema to reader schema
+ * 
+ * Fields are matched by id.
+ * 
+ * @return          DCF_SER_ERR_TYPE_MISMATCH if a shared field changed type in
+ *                  a way that cannot widen losslessly; DCF_SER_ERR_INVALID_TYPE
+ *                  for field types the untagged codec cannot carry
+ */
+DCFSerError dcf_ser_schema_resolve(DCFSerPlan* plan, const DCFSerSchema* writer,
+                                    const DCFSerSchema* reader);
+
+/**
+ * Free plan storage
+ */
+void dcf_ser_plan_destroy(DCFSerPlan* plan);
+
+/**
+ * Decode a value written with plan->writer into a plan->reader struct
+ * 
+ * Accepts tagless values carrying the writer fingerprint and self-describing
+ * structs of either schema's type id. Strings are skipped, as in
+ * dcf_ser_read_struct_schema.
+ * 
+ * @return          DCF_SER_ERR_TYPE_MISMATCH for another schema's value
+ */
+DCFSerError dcf_ser_read_struct_plan(DCFSerReader* r, void* data, const DCFSerPlan* plan);
+
+/* ============================================================================
+ * Flyweight Layouts
+ * 
+ * A schema of fixed-width fields compiles to byte offsets in one block,
+ * carried as a single DCF_TYPE_FIXED value inside a normal message (header
+ * and CRC as usual). Fields are stored and loaded in place by offset: no
+ * tags, no field headers, no parsing. Bytes fields are fixed-length
+ * (DCFSerField.size); strings and containers are not allowed.
+ * ============================================================================ */
+
+/**
+ * Compile a schema into a fixed layout (fields packed in schema order)
+ * 
+ * @return          DCF_SER_ERR_INVALID_TYPE if a field is not fixed-width
+ */
+DCFSerError dcf_ser_layout_compile(DCFSerLayout* layout, const DCFSerSchema* schema);
+
+/**
+ * Free a compiled layout
+ */
+void dcf_ser_layout_destroy(DCFSerLayout* layout);
+
+/**
+ * Get the block offset of a field (resolve once, then use the accessors)
+ */
+DCFSerError dcf_ser_layout_offset(const DCFSerLayout* layout, uint16_t field_id, uint32_t* out_offset);
+
+/**
+ * Append a zeroed block and return it for in-place stores
+ * 
+ * The block stays valid until the next write on w.
+ */
+DCFSerError dcf_ser_write_flyweight_begin(DCFSerWriter* w, const DCFSerLayout* layout,
+                                          uint8_t** out_block);
+
+/**
+ * Append a block filled from a C struct described by the layout's schema
+ */
+DCFSerError dcf_ser_write_flyweight(DCFSerWriter* w, const DCFSerLayout* layout, const void* data);
+
+/**
+ * Read a block in place (checks type_id and block size against the layout)
+ */
+DCFSerError dcf_ser_read_flyweight(DCFSerReader* r, const DCFSerLayout* layout,
+                                   const uint8_t** out_block);
+
+/**
+ * Copy every field of a block into a C struct described by the layout's schema
+ */
+DCFSerError dcf_ser_flyweight_decode(const DCFSerLayout* layout, const uint8_t* block, void* data);
+
+/* Accessors: network byte order at block + offset */
+
+static inline void dcf_ser_fly_set_u8(uint8_t* b, uint32_t off, uint8_t v) { b[off] = v; }
+
+static inline void dcf_ser_fly_set_u16(uint8_t* b, uint32_t off, uint16_t v) {
+    b[off] = (uint8_t)(v >> 8);
+    b[off + 1] = (uint8_t)v;
+}
+
+static inline void dcf_ser_fly_set_u32(uint8_t* b, uint32_t off, uint32_t v) {
+    b[off] = (uint8_t)(v >> 24);
+    b[off + 1] = (uint8_t)(v >> 16);
+    b[off + 2] = (uint8_t)(v >> 8);
+    b[off + 3] = (uint8_t)v;
+}
+
+static inline void dcf_ser_fly_set_u64(uint8_t* b, uint32_t off, uint64_t v) {
+    dcf_ser_fly_set_u32(b, off, (uint32_t)(v >> 32));
+    dcf_ser_fly_set_u32(b, off + 4, (uint32_t)v);
+}
+
+static inline void dcf_ser_fly_set_i16(uint8_t* b, uint32_t off, int16_t v) { dcf_ser_fly_set_u16(b, off, (uint16_t)v); }
+static inline void dcf_ser_fly_set_i32(uint8_t* b, uint32_t off, int32_t v) { dcf_ser_fly_set_u32(b, off, (uint32_t)v); }
+static inline void dcf_ser_fly_set_i64(uint8_t* b, uint32_t off, int64_t v) { dcf_ser_fly_set_u64(b, off, (uint64_t)v); }
+
+static inline void dcf_ser_fly_set_f32(uint8_t* b, uint32_t off, float v) {
+    union { float f; uint32_t u; } c;
+    c.f = v;
+    dcf_ser_fly_set_u32(b, off, c.u);
+}
+
+static inline void dcf_ser_fly_set_f64(uint8_t* b, uint32_t off, double v) {
+    union { double f; uint64_t u; } c;
+    c.f = v;
+    dcf_ser_fly_set_u64(b, off, c.u);
+}
+
+static inline uint8_t  dcf_ser_fly_get_u8(const uint8_t* b, uint32_t off)  { return b[off]; }
+static inline uint16_t dcf_ser_fly_get_u16(const uint8_t* b, uint32_t off) { return dcf_ser_load16_(b + off); }
+static inline uint32_t dcf_ser_fly_get_u32(const uint8_t* b, uint32_t off) { return dcf_ser_load32_(b + off); }
+static inline uint64_t dcf_ser_fly_get_u64(const uint8_t* b, uint32_t off) { return dcf_ser_load64_(b + off); }
+static inline int16_t  dcf_ser_fly_get_i16(const uint8_t* b, uint32_t off) { return (int16_t)dcf_ser_load16_(b + off); }
+static inline int32_t  dcf_ser_fly_get_i32(const uint8_t* b, uint32_t off) { return (int32_t)dcf_ser_load32_(b + off); }
+static inline int64_t  dcf_ser_fly_get_i64(const uint8_t* b, uint32_t off) { return (int64_t)dcf_ser_load64_(b + off); }
+
+static inline float dcf_ser_fly_get_f32(const uint8_t* b, uint32_t off) {
+    union { uint32_t u; float f; } c;
+    c.u = dcf_ser_load32_(b + off);
+    return c.f;
+}
+
+static inline double dcf_ser_fly_get_f64(const uint8_t* b, uint32_t off) {
+    union { uint64_t u; double f; } c;
+    c.u = dcf_ser_load64_(b + off);
+    return c.f;
+}
+
+/* ============================================================================
+ * Arena Allocation
+ * 
+ * Decoders that copy variable-length data (strings, bytes, DOM nodes) take
+ * an arena. Once the arena has warmed up, a message costs no allocations,
+ * and freeing it is one reset. Pointers into the arena stay valid until the
+ * next reset or destroy.
+ * ============================================================================ */
+
+/**
+ * Initialize an empty arena
+ * 
+ * @param chunk_size  Bytes per chunk (0 = 4096); larger requests get their own
+ */
+DCFSerError dcf_ser_arena_init(DCFSerArena* arena, size_t chunk_size);
+
+/**
+ * Free every chunk
+ */
+void dcf_ser_arena_destroy(DCFSerArena* arena);
+
+/**
+ * Release all allocations at once, keeping the chunks for reuse
+ */
+void dcf_ser_arena_reset(DCFSerArena* arena);
+
+/**
+ * Allocate size bytes aligned for any type
+ * 
+ * @return          Memory valid until reset/destroy, or NULL on failure
+ */
+void* dcf_ser_arena_alloc(DCFSerArena* arena, size_t size);
+
+/**
+ * Read a string, copying it NUL-terminated into the arena
+ * 
+ * @param out_len   String length (optional)
+ */
+DCFSerError dcf_ser_read_string_arena(DCFSerReader* r, DCFSerArena* arena,
+                                       const char** out_str, size_t* out_len);
+
+/**
+ * Read a byte array, copying it into the arena
+ */
+DCFSerError dcf_ser_read_bytes_arena(DCFSerReader* r, DCFSerArena* arena,
+                                      const void** out_data, size_t* out_len);
+
+/**
+ * Deserialize a struct using schema, copying string fields into the arena
+ * 
+ * Same as dcf_ser_read_struct_schema, except string members receive
+ * NUL-terminated copies instead of being left NULL. Absent string fields
+ * with a declared default point at the schema's default string.
+ */
+DCFSerError dcf_ser_read_struct_arena(DCFSerReader* r, void* data, const DCFSerSchema* schema,
+                                       DCFSerArena* arena);
+
+/* ============================================================================
+ * Lazy DOM
+ * 
+ * A tree over a received message. Nodes hold an offset; a container's direct
+ * children are located the first time it is indexed, and scalars are decoded
+ * from the buffer when read. Accessors returning DCFSerValue* give NULL on a
+ * miss, so lookups chain. The buffer and arena must outlive the nodes.
+ * ============================================================================ */
+
+/**
+ * Root node for the value at the reader's position (reader is not advanced)
+ * 
+ * @return          DCF_SER_ERR_INVALID_ARG for incremental or segmented readers
+ */
+DCFSerError dcf_ser_dom_root(const DCFSerReader* r, DCFSerArena* arena, DCFSerValue** out_root);
+
+/**
+ * Number of elements, map entries, or fields (0 for scalars and on error)
+ */
+size_t dcf_ser_value_count(DCFSerValue* v);
+
+/**
+ * Array element, map value, or field by position
+ * 
+ * Arrays of fixed-width elements are indexed without locating the others.
+ */
+DCFSerValue* dcf_ser_value_index(DCFSerValue* v, size_t index);
+
+/**
+ * Map key by position
+ */
+DCFSerValue* dcf_ser_value_key(DCFSerValue* v, size_t index);
+
+/**
+ * Struct or table member by field ID
+ */
+DCFSerValue* dcf_ser_value_field(DCFSerValue* v, uint16_t field_id);
+
+/**
+ * Follow a path of ".<field_id>" and "[<index>]" steps, e.g. ".3[7]"
+ */
+DCFSerValue* dcf_ser_value_path(DCFSerValue* v, const char* path);
+
+/**
+ * Reader positioned at the node's value, for the regular dcf_ser_read_* calls
+ */
+DCFSerError dcf_ser_value_reader(const DCFSerValue* v, DCFSerReader* out);
+
+/**
+ * Read an integer node (any width or signedness that fits)
+ */
+DCFSerError dcf_ser_value_uint(const DCFSerValue* v, uint64_t* out);
+DCFSerError dcf_ser_value_int(const DCFSerValue* v, int64_t* out);
+
+/**
+ * Read an F32/F64 node
+ */
+DCFSerError dcf_ser_value_f64(const DCFSerValue* v, double* out);
+
+/**
+ * Read a string node (zero-copy, points into the message buffer)
+ */
+DCFSerError dcf_ser_value_string(const DCFSerValue* v, const char** out_str, size_t* out_len);
+
+/* ============================================================================
+ * Visitor Decoding
+ * 
+ * One pass over the payload with a callback per value, dispatched through a
+ * table indexed by the type tag. Use it to transcode, index or filter
+ * messages without building anything in between.
+ * ============================================================================ */
+
+/**
+ * Visit every value from the reader's position to the end of the payload
+ * 
+ * A begin callback or on_field returning DCF_SER_VISIT_SKIP skips that
+ * value without further callbacks (no matching end).
+ * 
+ * @return          DCF_SER_OK when the payload is consumed or a callback
+ *                  stopped the walk; DCF_SER_ERR_INVALID_ARG for incremental
+ *                  or segmented readers
+ */
+DCFSerError dcf_ser_visit(DCFSerReader* r, const DCFSerVisitor* visitor, void* ctx);
+
+/* ============================================================================
+ * Stream Reassembly
+ * ============================================================================ */
+
+/**
+ * Initialize a reassembler
+ * 
+ * @param ra        Reassembler to initialize
+ * @param opts      Options, or NULL for defaults
+ * @return          DCF_SER_OK on success
+ */
+DCFSerError dcf_ser_reassembler_init(DCFSerReassembler* ra, const DCFSerReassemblerOptions* opts);
+
+/**
+ * Free all buffered streams
+ */
+void dcf_ser_reassembler_destroy(DCFSerReassembler* ra);
+
+/**
+ * Feed one received message
+ * 
+ * Chunks are keyed by (msg_type, sequence) and must arrive in order within
+ * a stream. When a FINAL chunk completes a stream, out is set up over the
+ * reassembled message (header + payload, no CRC; crc_verified is true if
+ * every chunk was verified) and *out_complete is set. The message stays
+ * valid until the next push. Messages without STREAMING complete at once,
+ * zero-copy over data.
+ * 
+ * In cut-through mode (on_chunk set) chunk payloads are passed to the
+ * callback as they arrive and never buffered.
+ * 
+ * @return          DCF_SER_OK, DCF_SER_ERR_BUFFER_FULL if the stream or
+ *                  memory budget is exhausted, DCF_SER_ERR_TOO_LARGE if the
+ *                  stream exceeds its cap (the stream is dropped), or a
+ *                  validation error for the chunk
+ */
+DCFSerError dcf_ser_reassembler_push(DCFSerReassembler* ra, const void* data, size_t len,
+                                     DCFSerReader* out, bool* out_complete);
+
+/**
+ * Abandon a stream (e.g. on timeout)
+ * 
+ * @return          DCF_SER_OK, or DCF_SER_ERR_NOT_FOUND if no such stream
+ */
+DCFSerError dcf_ser_reassembler_drop(DCFSerReassembler* ra, uint16_t msg_type, uint32_t sequence);
+
+/* ============================================================================
+ * Stream Framing
+ * ============================================================================ */
+
+/**
+ * Initialize a framer
+ * 
+ * @param f         Framer to initialize
+ * @param opts      Options, or NULL for defaults
+ * @return          DCF_SER_OK on success
+ */
+DCFSerError dcf_ser_framer_init(DCFSerFramer* f, const DCFSerFramerOptions* opts);
+
+/**
+ * Free the framer buffer
+ */
+void dcf_ser_framer_destroy(DCFSerFramer* f);
+
+/**
+ * Get space to receive into (e.g. recv(fd, *out_ptr, *out_avail, 0))
+ * 
+ * Invalidates frames returned so far: the buffer may be compacted or grown.
+ * 
+ * @param f         Framer
+ * @param min       Minimum free bytes wanted
+ * @param out_ptr   Receive position
+ * @param out_avail Free bytes at out_ptr (>= min)
+ * @return          DCF_SER_OK, or DCF_SER_ERR_BUFFER_FULL past max_frame
+ */
+DCFSerError dcf_ser_framer_write_ptr(DCFSerFramer* f, size_t min, uint8_t** out_ptr,
+                                     size_t* out_avail);
+
+/**
+ * Mark n bytes at the write pointer as received
+ */
+DCFSerError dcf_ser_framer_commit(DCFSerFramer* f, size_t n);
+
+/**
+ * Copy received bytes into the framer (write_ptr + memcpy + commit)
+ */
+DCFSerError dcf_ser_framer_push(DCFSerFramer* f, const void* data, size_t len);
+
+/**
+ * Get the next complete message
+ * 
+ * The frame is zero-copy and stays valid until the next write_ptr/push.
+ * Garbage, oversized lengths and (with validate) CRC failures are skipped
+ * by scanning for the next "DCFS" magic.
+ * 
+ * @return          DCF_SER_OK, or DCF_SER_ERR_NOT_FOUND if more data is needed
+ */
+DCFSerError dcf_ser_framer_next(DCFSerFramer* f, DCFSerFrame* out);
+
+/**
+ * Get up to max complete messages at once
+ * 
+ * @return          DCF_SER_OK (*out_count may be 0)
+ */
+DCFSerError dcf_ser_framer_next_batch(DCFSerFramer* f, DCFSerFrame* frames, size_t max,
+                                      size_t* out_count);
+
 /* ============================================================================
  * Utility Functions
  * ============================================================================ */
@@ -637,12 +2238,37 @@ size_t dcf_ser_type_size(DCFSerType type);
  */
 DCFSerError dcf_ser_validate_message(const void* data, size_t len);
 
+/**
+ * Validate a complete message down to every value, without decoding
+ * 
+ * Checks the header and CRC, then walks the tag stream iteratively
+ * (see dcf_ser_reader_trust for the rules). With an index, also records
+ * value offsets and container extents in the same pass.
+ * 
+ * @param index     Entry storage (NULL = validate only)
+ * @return          DCF_SER_OK, DCF_SER_ERR_BUFFER_FULL if the index is too
+ *                  small, or the first structural error
+ */
+DCFSerError dcf_ser_validate_structure(const void* data, size_t len, DCFSerIndex* index);
+
 /**
  * Get message length from header (for framing)
  * Returns total message length including header and CRC
+ * (extended headers must be fully available: 29 bytes)
  */
 size_t dcf_ser_message_length(const void* header_data);
 
+/**
+ * Get message length from a possibly partial buffer (for framing)
+ * 
+ * @param data      Start of message
+ * @param avail     Bytes available at data
+ * @param out_len   Total message length including header and CRC
+ * @return          DCF_SER_OK, DCF_SER_ERR_TRUNCATED if the header is
+ *                  incomplete, DCF_SER_ERR_INVALID_MAGIC if not a message start
+ */
+DCFSerError dcf_ser_message_length_ex(const void* data, size_t avail, size_t* out_len);
+
 /* ============================================================================
  * Helper Macros
  * ============================================================================ */
@@ -654,11 +2280,17 @@ size_t dcf_ser_message_length(const void* header_data);
 
 #define DCF_SER_FIELD_DEF(struct_type, field, type_tag, fid) \
     { #field, (fid), (type_tag), DCF_FIELD_REQUIRED, \
-      offsetof(struct_type, field), sizeof(((struct_type*)0)->field) }
+      offsetof(struct_type, field), sizeof(((struct_type*)0)->field), NULL }
 
 #define DCF_SER_FIELD_OPT(struct_type, field, type_tag, fid) \
     { #field, (fid), (type_tag), DCF_FIELD_OPTIONAL, \
-      offsetof(struct_type, field), sizeof(((struct_type*)0)->field) }
+      offsetof(struct_type, field), sizeof(((struct_type*)0)->field), NULL }
+
+/* Field elided when equal to *def (a value of the member's type; for string
+ * fields, the default string itself). def may be NULL for zero / "". */
+#define DCF_SER_FIELD_DEFAULT(struct_type, field, type_tag, fid, def) \
+    { #field, (fid), (type_tag), DCF_FIELD_DEFAULT, \
+      offsetof(struct_type, field), sizeof(((struct_type*)0)->field), (def) }
 
 #ifdef __cplusplus
 }
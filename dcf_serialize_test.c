@@ -14,6 +14,10 @@
 #include "dcf_serialize.h"
 #include <stdio.h>
 #include <stdlib.h>
+
+#ifdef DCF_SER_PLATFORM_POSIX
+    #include <pthread.h>
+#endif
 #include <string.h>
 #include <assert.h>
 
@@ -570,6 +574,2626 @@ static int test_no_crc(void) {
     return 0;
 }
 
+/* ============================================================================
+ * Test: Zero-Copy Byte References
+ * ============================================================================ */
+
+static int test_bytes_ref(void) {
+    printf("Testing zero-copy byte references...\n");
+    
+    uint8_t payload[300];
+    for (size_t i = 0; i < sizeof(payload); i++) payload[i] = (uint8_t)(i * 7);
+    
+    /* Gather path: payload goes out as its own vector */
+    DCFSerWriter writer;
+    TEST_CHECK(dcf_ser_writer_init(&writer, 0x0008, DCF_SER_FLAG_NONE));
+    TEST_CHECK(dcf_ser_write_u32(&writer, 7));
+    TEST_CHECK(dcf_ser_write_bytes_ref(&writer, payload, sizeof(payload)));
+    TEST_CHECK(dcf_ser_write_bytes_ref(&writer, payload, 4));  /* Copied inline */
+    TEST_CHECK(dcf_ser_write_string(&writer, "tail"));
+    TEST_ASSERT(writer.segment_count == 1, "small ref should be copied");
+    
+    DCFSerIoVec iov[8];
+    size_t iov_count;
+    TEST_ASSERT(dcf_ser_writer_iov_count(&writer) == 3, "iov count mismatch");
+    TEST_CHECK(dcf_ser_writer_finish_iov(&writer, iov, 8, &iov_count));
+    TEST_ASSERT(iov_count == 3, "expected header/ref/tail vectors");
+    TEST_ASSERT(iov[1].iov_base == (void*)payload, "ref segment was copied");
+    
+    uint8_t gathered[512];
+    size_t gathered_len = 0;
+    for (size_t i = 0; i < iov_count; i++) {
+        memcpy(gathered + gathered_len, iov[i].iov_base, iov[i].iov_len);
+        gathered_len += iov[i].iov_len;
+    }
+    
+    DCFSerReader reader;
+    TEST_CHECK(dcf_ser_reader_init(&reader, gathered, gathered_len));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    
+    uint32_t u32;
+    const void* blob;
+    size_t blob_len;
+    TEST_CHECK(dcf_ser_read_u32(&reader, &u32));
+    TEST_CHECK(dcf_ser_read_bytes(&reader, &blob, &blob_len));
+    TEST_ASSERT(blob_len == sizeof(payload) && memcmp(blob, payload, blob_len) == 0,
+                "ref bytes mismatch");
+    TEST_CHECK(dcf_ser_read_bytes(&reader, &blob, &blob_len));
+    TEST_ASSERT(blob_len == 4, "small ref length mismatch");
+    
+    /* Contiguous finish must produce identical bytes */
+    DCFSerWriter flat;
+    TEST_CHECK(dcf_ser_writer_init(&flat, 0x0008, DCF_SER_FLAG_NONE));
+    TEST_CHECK(dcf_ser_write_u32(&flat, 7));
+    TEST_CHECK(dcf_ser_write_bytes_ref(&flat, payload, sizeof(payload)));
+    TEST_CHECK(dcf_ser_write_bytes_ref(&flat, payload, 4));
+    TEST_CHECK(dcf_ser_write_string(&flat, "tail"));
+    
+    const uint8_t* data;
+    size_t len;
+    TEST_CHECK(dcf_ser_writer_finish(&flat, &data, &len));
+    TEST_ASSERT(len == gathered_len && memcmp(data, gathered, len) == 0,
+                "linearized message differs from gather list");
+    
+    dcf_ser_writer_destroy(&flat);
+    dcf_ser_writer_destroy(&writer);
+    
+    printf("  Byte reference tests PASSED\n");
+    return 0;
+}
+
+/* ============================================================================
+ * Test: Headroom / Tailroom
+ * ============================================================================ */
+
+static int test_headroom(void) {
+    printf("Testing headroom/tailroom reservation...\n");
+    
+    DCFSerWriterOptions opts = {0};
+    opts.headroom = 8;
+    opts.tailroom = 6;
+    
+    DCFSerWriter writer;
+    TEST_CHECK(dcf_ser_writer_init_ex(&writer, 0x0009, DCF_SER_FLAG_NONE, &opts));
+    for (uint32_t i = 0; i < 100; i++) {
+        TEST_CHECK(dcf_ser_write_u32(&writer, i));  /* Forces buffer growth */
+    }
+    
+    const uint8_t* data;
+    size_t len;
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    
+    uint8_t* head;
+    uint8_t* tail;
+    size_t head_len, tail_len;
+    TEST_CHECK(dcf_ser_writer_headroom(&writer, &head, &head_len));
+    TEST_CHECK(dcf_ser_writer_tailroom(&writer, &tail, &tail_len));
+    TEST_ASSERT(head_len >= 8 && head + head_len == data, "headroom must end at message");
+    TEST_ASSERT(tail_len >= 6 && tail == data + len, "tailroom must start after message");
+    
+    /* Encapsulate in place: 8-byte outer header, 6-byte trailer */
+    memset(head + head_len - 8, 0xAB, 8);
+    memset(tail, 0xCD, 6);
+    
+    DCFSerReader reader;
+    TEST_CHECK(dcf_ser_reader_init(&reader, data, len));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    
+    uint32_t val;
+    for (uint32_t i = 0; i < 100; i++) {
+        TEST_CHECK(dcf_ser_read_u32(&reader, &val));
+        TEST_ASSERT(val == i, "payload mismatch");
+    }
+    
+    dcf_ser_writer_destroy(&writer);
+    
+    /* External buffer too small for the requested room */
+    uint8_t small[32];
+    opts.buffer = small;
+    opts.capacity = sizeof(small);
+    TEST_ASSERT(dcf_ser_writer_init_ex(&writer, 0x0009, 0, &opts) == DCF_SER_ERR_BUFFER_FULL,
+                "undersized external buffer accepted");
+    
+    printf("  Headroom tests PASSED\n");
+    return 0;
+}
+
+/* ============================================================================
+ * Test: Batch Frames
+ * ============================================================================ */
+
+static int test_batch(void) {
+    printf("Testing batch frames...\n");
+    
+    TEST_ASSERT(sizeof(DCFSerHeader) == DCF_SER_HEADER_SIZE, "header size constant stale");
+    
+    DCFSerWriter writer;
+    TEST_CHECK(dcf_ser_writer_init(&writer, DCF_SER_MSG_BATCH, DCF_SER_FLAG_NONE));
+    
+    /* Sub-messages built in place */
+    for (uint32_t i = 0; i < 3; i++) {
+        TEST_CHECK(dcf_ser_batch_begin(&writer, (uint16_t)(0x0100 + i), 1000 + i));
+        TEST_CHECK(dcf_ser_write_u32(&writer, i * 11));
+        TEST_CHECK(dcf_ser_write_string(&writer, "ping"));
+        TEST_CHECK(dcf_ser_batch_end(&writer));
+    }
+    
+    /* Pre-encoded sub-message */
+    const uint8_t raw[] = {DCF_TYPE_U8, 0x7F};
+    TEST_CHECK(dcf_ser_batch_append(&writer, 0x0200, 2000, raw, sizeof(raw)));
+    
+    /* Nesting batch calls is rejected */
+    TEST_CHECK(dcf_ser_batch_begin(&writer, 0x0300, 1));
+    TEST_ASSERT(dcf_ser_batch_begin(&writer, 0x0300, 2) == DCF_SER_ERR_INVALID_ARG,
+                "nested sub-message accepted");
+    TEST_CHECK(dcf_ser_batch_end(&writer));
+    
+    const uint8_t* data;
+    size_t len;
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    print_hex(data, len, "Batch");
+    
+    DCFSerReader reader;
+    TEST_CHECK(dcf_ser_reader_init(&reader, data, len));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    
+    DCFSerBatchIter it;
+    DCFSerReader sub;
+    TEST_CHECK(dcf_ser_batch_iter_init(&it, &reader));
+    
+    for (uint32_t i = 0; i < 3; i++) {
+        TEST_CHECK(dcf_ser_batch_next(&it, &sub));
+        TEST_ASSERT(dcf_ser_reader_msg_type(&sub) == 0x0100 + i, "sub msg_type mismatch");
+        TEST_ASSERT(dcf_ser_reader_header(&sub)->sequence == 1000 + i, "sub sequence mismatch");
+        
+        uint32_t val;
+        const char* str;
+        size_t str_len;
+        TEST_CHECK(dcf_ser_read_u32(&sub, &val));
+        TEST_CHECK(dcf_ser_read_string(&sub, &str, &str_len));
+        TEST_ASSERT(val == i * 11 && str_len == 4, "sub payload mismatch");
+        TEST_ASSERT(dcf_ser_reader_at_end(&sub), "sub reader not at end");
+    }
+    
+    uint8_t u8;
+    TEST_CHECK(dcf_ser_batch_next(&it, &sub));
+    TEST_CHECK(dcf_ser_read_u8(&sub, &u8));
+    TEST_ASSERT(u8 == 0x7F && dcf_ser_reader_header(&sub)->sequence == 2000, "appended sub mismatch");
+    
+    TEST_CHECK(dcf_ser_batch_next(&it, &sub));
+    TEST_ASSERT(dcf_ser_reader_remaining(&sub) == 0, "empty sub-message expected");
+    TEST_ASSERT(dcf_ser_batch_next(&it, &sub) == DCF_SER_ERR_NOT_FOUND, "batch end expected");
+    
+    dcf_ser_writer_destroy(&writer);
+    
+    printf("  Batch tests PASSED\n");
+    return 0;
+}
+
+/* ============================================================================
+ * Test: Compact Header
+ * ============================================================================ */
+
+static int test_compact_header(void) {
+    printf("Testing compact header...\n");
+    
+    DCFSerWriter writer;
+    TEST_CHECK(dcf_ser_writer_init(&writer, 0x0042, DCF_SER_FLAG_COMPACT | DCF_SER_FLAG_PRIORITY));
+    dcf_ser_writer_set_sequence_base(&writer, 1000);
+    dcf_ser_writer_set_sequence(&writer, 1001);
+    TEST_CHECK(dcf_ser_write_u16(&writer, 0xBEEF));
+    
+    const uint8_t* data;
+    size_t len;
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    print_hex(data, len, "Compact");
+    
+    /* sync + len + msg_type + delta = 4 bytes of framing, plus 3 payload, 4 CRC */
+    TEST_ASSERT(len == 4 + 3 + 4, "compact message size mismatch");
+    TEST_ASSERT((data[0] & DCF_SER_COMPACT_MASK) == DCF_SER_COMPACT_SYNC, "sync byte missing");
+    TEST_ASSERT(dcf_ser_message_length(data) == len, "message_length mismatch");
+    
+    size_t framed;
+    TEST_ASSERT(dcf_ser_message_length_ex(data, 2, &framed) == DCF_SER_ERR_TRUNCATED,
+                "partial compact header not detected");
+    TEST_CHECK(dcf_ser_message_length_ex(data, len, &framed));
+    TEST_ASSERT(framed == len, "message_length_ex mismatch");
+    
+    DCFSerReader reader;
+    TEST_CHECK(dcf_ser_reader_init(&reader, data, len));
+    dcf_ser_reader_set_sequence_base(&reader, 1000);
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    TEST_ASSERT(reader.crc_verified, "compact CRC not verified");
+    
+    const DCFSerHeader* hdr = dcf_ser_reader_header(&reader);
+    TEST_ASSERT(hdr->msg_type == 0x0042 && hdr->sequence == 1001, "compact header fields mismatch");
+    TEST_ASSERT(hdr->flags & DCF_SER_FLAG_PRIORITY, "priority flag lost");
+    
+    uint16_t u16;
+    TEST_CHECK(dcf_ser_read_u16(&reader, &u16));
+    TEST_ASSERT(u16 == 0xBEEF, "compact payload mismatch");
+    
+    /* Corruption is still caught */
+    uint8_t corrupt[16];
+    memcpy(corrupt, data, len);
+    corrupt[len - 5] ^= 0x01;
+    TEST_ASSERT(dcf_ser_validate_message(corrupt, len) == DCF_SER_ERR_CRC_MISMATCH,
+                "compact CRC corruption not detected");
+    
+    /* NO_CRC + zero delta: 3 bytes of framing */
+    dcf_ser_writer_reset(&writer, 0x0042, DCF_SER_FLAG_COMPACT | DCF_SER_FLAG_NO_CRC);
+    dcf_ser_writer_set_sequence(&writer, 1000);
+    TEST_CHECK(dcf_ser_write_bool(&writer, true));
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    TEST_ASSERT(len == 3 + 2, "compact NO_CRC size mismatch");
+    
+    /* Flags a compact header cannot carry fall back to the full header */
+    dcf_ser_writer_reset(&writer, 0x0042, DCF_SER_FLAG_COMPACT | DCF_SER_FLAG_ENCRYPTED);
+    TEST_CHECK(dcf_ser_write_bool(&writer, true));
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    TEST_ASSERT(len == sizeof(DCFSerHeader) + 2 + 4, "fallback should use full header");
+    TEST_CHECK(dcf_ser_reader_init(&reader, data, len));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    TEST_ASSERT(dcf_ser_reader_header(&reader)->flags == DCF_SER_FLAG_ENCRYPTED,
+                "compact flag leaked onto the wire");
+    
+    dcf_ser_writer_destroy(&writer);
+    
+    printf("  Compact header tests PASSED\n");
+    return 0;
+}
+
+static int test_extended(void) {
+    printf("Testing extended header and limits...\n");
+    
+    /* Small extended message: 17-byte header + u64 length + header CRC */
+    DCFSerWriter writer;
+    TEST_CHECK(dcf_ser_writer_init(&writer, 0x0077, DCF_SER_FLAG_EXTENDED));
+    TEST_CHECK(dcf_ser_write_u32(&writer, 0xCAFEBABE));
+    
+    const uint8_t* data;
+    size_t len;
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    print_hex(data, len, "Extended");
+    
+    TEST_ASSERT(len == sizeof(DCFSerHeader) + 12 + 5 + 4, "extended message size mismatch");
+    TEST_ASSERT(dcf_ser_message_length(data) == len, "message_length mismatch");
+    
+    size_t framed;
+    TEST_ASSERT(dcf_ser_message_length_ex(data, sizeof(DCFSerHeader), &framed) == DCF_SER_ERR_TRUNCATED,
+                "partial extended header not detected");
+    TEST_CHECK(dcf_ser_message_length_ex(data, len, &framed));
+    TEST_ASSERT(framed == len, "message_length_ex mismatch");
+    
+    DCFSerReader reader;
+    TEST_CHECK(dcf_ser_reader_init(&reader, data, len));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    TEST_ASSERT(dcf_ser_reader_payload_length(&reader) == 5, "payload length mismatch");
+    TEST_ASSERT(dcf_ser_reader_header(&reader)->payload_len == UINT32_MAX, "length sentinel missing");
+    
+    uint32_t u32;
+    TEST_CHECK(dcf_ser_read_u32(&reader, &u32));
+    TEST_ASSERT(u32 == 0xCAFEBABE, "extended payload mismatch");
+    
+    /* A corrupted length is caught by the header CRC */
+    uint8_t corrupt[64];
+    memcpy(corrupt, data, len);
+    corrupt[sizeof(DCFSerHeader) + 7] ^= 0x01;
+    TEST_ASSERT(dcf_ser_message_length_ex(corrupt, len, &framed) == DCF_SER_ERR_CRC_MISMATCH,
+                "header CRC corruption not detected");
+    dcf_ser_writer_destroy(&writer);
+    
+    /* Messages beyond the default 16MB limit need raised limits */
+    size_t big_len = 17 * 1024 * 1024;
+    uint8_t* big = (uint8_t*)malloc(big_len);
+    TEST_ASSERT(big != NULL, "alloc failed");
+    memset(big, 0x5A, big_len);
+    
+    TEST_CHECK(dcf_ser_writer_init(&writer, 0x0077, DCF_SER_FLAG_NONE));
+    TEST_ASSERT(dcf_ser_write_bytes(&writer, big, big_len) == DCF_SER_ERR_TOO_LARGE,
+                "default limit not enforced");
+    dcf_ser_writer_destroy(&writer);
+    
+    DCFSerLimits limits;
+    dcf_ser_limits_default(&limits);
+    limits.max_message = 64 * 1024 * 1024;
+    DCFSerWriterOptions opts = {0};
+    opts.limits = &limits;
+    TEST_CHECK(dcf_ser_writer_init_ex(&writer, 0x0077, DCF_SER_FLAG_EXTENDED, &opts));
+    TEST_CHECK(dcf_ser_write_bytes(&writer, big, big_len));
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    
+    TEST_CHECK(dcf_ser_reader_init(&reader, data, len));
+    TEST_ASSERT(dcf_ser_reader_validate(&reader) == DCF_SER_ERR_TOO_LARGE,
+                "reader default limit not enforced");
+    
+    TEST_CHECK(dcf_ser_reader_init(&reader, data, len));
+    TEST_CHECK(dcf_ser_reader_set_limits(&reader, &limits));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    
+    const void* out;
+    size_t out_len;
+    TEST_CHECK(dcf_ser_read_bytes(&reader, &out, &out_len));
+    TEST_ASSERT(out_len == big_len && memcmp(out, big, big_len) == 0, "large payload mismatch");
+    
+    dcf_ser_writer_destroy(&writer);
+    free(big);
+    
+    /* Tightened limits apply on both sides */
+    limits.max_string = 4;
+    TEST_CHECK(dcf_ser_writer_init_ex(&writer, 0x0077, DCF_SER_FLAG_NONE, &opts));
+    TEST_ASSERT(dcf_ser_write_string(&writer, "hello") == DCF_SER_ERR_TOO_LARGE,
+                "writer string limit not enforced");
+    TEST_CHECK(dcf_ser_write_string(&writer, "hi"));
+    dcf_ser_writer_destroy(&writer);
+    
+    limits.max_depth = DCF_SER_MAX_DEPTH + 1;
+    TEST_ASSERT(dcf_ser_reader_set_limits(&reader, &limits) == DCF_SER_ERR_INVALID_ARG,
+                "depth above hard cap accepted");
+    
+    printf("  Extended header tests PASSED\n");
+    return 0;
+}
+
+/* Collects sink chunks back to back */
+typedef struct {
+    uint8_t data[64 * 1024];
+    size_t  len;
+    size_t  chunks;
+} ChunkSink;
+
+static DCFSerError chunk_sink(void* ctx, const void* data, size_t len) {
+    ChunkSink* sink = (ChunkSink*)ctx;
+    if (sink->len + len > sizeof(sink->data)) return DCF_SER_ERR_IO;
+    memcpy(sink->data + sink->len, data, len);
+    sink->len += len;
+    sink->chunks++;
+    return DCF_SER_OK;
+}
+
+static int test_streaming(void) {
+    printf("Testing streaming sink writer...\n");
+    
+    static ChunkSink sink;
+    memset(&sink, 0, sizeof(sink));
+    
+    uint8_t blob[10000];
+    for (size_t i = 0; i < sizeof(blob); i++) blob[i] = (uint8_t)(i * 7);
+    
+    DCFSerWriterOptions opts = {0};
+    opts.sink = chunk_sink;
+    opts.sink_ctx = &sink;
+    opts.chunk_size = 1024;
+    
+    DCFSerWriter writer;
+    TEST_CHECK(dcf_ser_writer_init_ex(&writer, 0x0300, DCF_SER_FLAG_NONE, &opts));
+    dcf_ser_writer_set_sequence(&writer, 77);
+    TEST_CHECK(dcf_ser_write_u32(&writer, 0x12345678));
+    TEST_CHECK(dcf_ser_write_bytes(&writer, blob, sizeof(blob)));
+    TEST_CHECK(dcf_ser_write_string(&writer, "tail"));
+    TEST_ASSERT(sink.chunks > 0, "nothing streamed before finish");
+    TEST_ASSERT(writer.capacity < 2048, "sink writer buffer grew");
+    
+    const uint8_t* data;
+    size_t len;
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    TEST_ASSERT(data == NULL && len == sink.len, "finish should report wire bytes");
+    TEST_ASSERT(sink.chunks >= 10, "expected one chunk per KB");
+    
+    /* Every chunk is a valid message; payloads concatenate */
+    static uint8_t payload[16 * 1024];
+    size_t payload_len = 0;
+    size_t off = 0;
+    size_t chunks = 0;
+    while (off < sink.len) {
+        size_t msg_len = dcf_ser_message_length(sink.data + off);
+        DCFSerReader chunk;
+        TEST_CHECK(dcf_ser_reader_init(&chunk, sink.data + off, msg_len));
+        TEST_CHECK(dcf_ser_reader_validate(&chunk));
+        
+        const DCFSerHeader* hdr = dcf_ser_reader_header(&chunk);
+        bool last = (off + msg_len == sink.len);
+        TEST_ASSERT(hdr->flags & DCF_SER_FLAG_STREAMING, "chunk missing STREAMING");
+        TEST_ASSERT(!(hdr->flags & DCF_SER_FLAG_FINAL) == !last, "FINAL on wrong chunk");
+        TEST_ASSERT(hdr->sequence == 77 && hdr->msg_type == 0x0300, "chunk header mismatch");
+        TEST_ASSERT(hdr->payload_len <= 1024, "chunk exceeds chunk_size");
+        
+        memcpy(payload + payload_len, sink.data + off + sizeof(DCFSerHeader), hdr->payload_len);
+        payload_len += hdr->payload_len;
+        off += msg_len;
+        chunks++;
+    }
+    TEST_ASSERT(chunks == sink.chunks, "chunk count mismatch");
+    
+    DCFSerReader reader;
+    TEST_CHECK(dcf_ser_reader_init(&reader, payload, payload_len));
+    reader.payload_end = payload_len;
+    
+    uint32_t u32;
+    const void* out;
+    size_t out_len;
+    const char* str;
+    TEST_CHECK(dcf_ser_read_u32(&reader, &u32));
+    TEST_CHECK(dcf_ser_read_bytes(&reader, &out, &out_len));
+    TEST_CHECK(dcf_ser_read_string(&reader, &str, &out_len));
+    TEST_ASSERT(u32 == 0x12345678 && out_len == 4 && memcmp(str, "tail", 4) == 0,
+                "streamed payload mismatch");
+    
+    /* A message that fits in one chunk goes out as a plain message */
+    memset(&sink, 0, sizeof(sink));
+    dcf_ser_writer_reset(&writer, 0x0301, DCF_SER_FLAG_NONE);
+    TEST_CHECK(dcf_ser_write_u8(&writer, 5));
+    TEST_CHECK(dcf_ser_writer_flush(&writer));
+    TEST_ASSERT(sink.chunks == 1, "explicit flush did not send");
+    TEST_CHECK(dcf_ser_write_u8(&writer, 6));
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    TEST_ASSERT(sink.chunks == 2, "finish did not send");
+    
+    /* Open sorted maps still have their offset table to fill in */
+    memset(&sink, 0, sizeof(sink));
+    dcf_ser_writer_reset(&writer, 0x0303, DCF_SER_FLAG_NONE);
+    TEST_CHECK(dcf_ser_write_sorted_map_begin(&writer, DCF_TYPE_U32, DCF_TYPE_U8, 1));
+    TEST_CHECK(dcf_ser_write_u32(&writer, 1));
+    TEST_ASSERT(dcf_ser_writer_flush(&writer) == DCF_SER_ERR_MALFORMED,
+                "flushed an open sorted map");
+    TEST_ASSERT(sink.chunks == 0, "open sorted map sent");
+    TEST_CHECK(dcf_ser_write_u8(&writer, 1));
+    TEST_CHECK(dcf_ser_write_sorted_map_end(&writer));
+    TEST_CHECK(dcf_ser_writer_flush(&writer));
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    
+    memset(&sink, 0, sizeof(sink));
+    dcf_ser_writer_reset(&writer, 0x0302, DCF_SER_FLAG_NONE);
+    TEST_CHECK(dcf_ser_write_u8(&writer, 5));
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    TEST_ASSERT(sink.chunks == 1, "small message should be one send");
+    TEST_CHECK(dcf_ser_validate_message(sink.data, sink.len));
+    TEST_ASSERT(!(sink.data[8] & DCF_SER_FLAG_STREAMING), "small message marked STREAMING");
+    
+    dcf_ser_writer_destroy(&writer);
+    
+    printf("  Streaming tests PASSED\n");
+    return 0;
+}
+
+/* Streams a u32 tag followed by a large byte blob through sink */
+static int stream_blob(ChunkSink* sink, uint32_t stream_id, const uint8_t* blob, size_t len) {
+    DCFSerWriterOptions opts = {0};
+    opts.sink = chunk_sink;
+    opts.sink_ctx = sink;
+    opts.chunk_size = 512;
+    
+    DCFSerWriter writer;
+    const uint8_t* data;
+    size_t out_len;
+    TEST_CHECK(dcf_ser_writer_init_ex(&writer, 0x0400, DCF_SER_FLAG_NONE, &opts));
+    dcf_ser_writer_set_sequence(&writer, stream_id);
+    TEST_CHECK(dcf_ser_write_u32(&writer, stream_id));
+    TEST_CHECK(dcf_ser_write_bytes(&writer, blob, len));
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &out_len));
+    dcf_ser_writer_destroy(&writer);
+    return 0;
+}
+
+typedef struct {
+    uint8_t  data[8192];
+    uint64_t len;
+    bool     final;
+} CutThrough;
+
+static DCFSerError cut_through(void* ctx, const DCFSerStreamChunk* chunk) {
+    CutThrough* ct = (CutThrough*)ctx;
+    if (chunk->offset != ct->len || ct->len + chunk->len > sizeof(ct->data)) {
+        return DCF_SER_ERR_MALFORMED;
+    }
+    memcpy(ct->data + ct->len, chunk->data, chunk->len);
+    ct->len += chunk->len;
+    ct->final = chunk->final;
+    return DCF_SER_OK;
+}
+
+static int test_reassembly(void) {
+    printf("Testing stream reassembly...\n");
+    
+    static ChunkSink a, b;
+    memset(&a, 0, sizeof(a));
+    memset(&b, 0, sizeof(b));
+    
+    uint8_t blob_a[3000], blob_b[2000];
+    for (size_t i = 0; i < sizeof(blob_a); i++) blob_a[i] = (uint8_t)i;
+    for (size_t i = 0; i < sizeof(blob_b); i++) blob_b[i] = (uint8_t)(255 - i);
+    if (stream_blob(&a, 1, blob_a, sizeof(blob_a))) return 1;
+    if (stream_blob(&b, 2, blob_b, sizeof(blob_b))) return 1;
+    TEST_ASSERT(a.chunks > 1 && b.chunks > 1, "streams should be chunked");
+    
+    DCFSerReassembler ra;
+    TEST_CHECK(dcf_ser_reassembler_init(&ra, NULL));
+    
+    /* Interleave the two streams chunk by chunk */
+    size_t off_a = 0, off_b = 0;
+    int completed = 0;
+    while (off_a < a.len || off_b < b.len) {
+        ChunkSink* src = (off_a < a.len && (off_a <= off_b || off_b >= b.len)) ? &a : &b;
+        size_t* off = (src == &a) ? &off_a : &off_b;
+        size_t msg_len = dcf_ser_message_length(src->data + *off);
+        
+        DCFSerReader reader;
+        bool complete;
+        TEST_CHECK(dcf_ser_reassembler_push(&ra, src->data + *off, msg_len, &reader, &complete));
+        *off += msg_len;
+        if (!complete) continue;
+        
+        completed++;
+        TEST_ASSERT(reader.crc_verified, "chunk CRCs not carried over");
+        TEST_ASSERT(!(dcf_ser_reader_header(&reader)->flags & DCF_SER_FLAG_STREAMING),
+                    "reassembled message still flagged STREAMING");
+        
+        uint32_t id;
+        const void* out;
+        size_t out_len;
+        TEST_CHECK(dcf_ser_read_u32(&reader, &id));
+        TEST_CHECK(dcf_ser_read_bytes(&reader, &out, &out_len));
+        TEST_ASSERT(id == dcf_ser_reader_header(&reader)->sequence, "stream ID mismatch");
+        const uint8_t* expect = (id == 1) ? blob_a : blob_b;
+        size_t expect_len = (id == 1) ? sizeof(blob_a) : sizeof(blob_b);
+        TEST_ASSERT(out_len == expect_len && memcmp(out, expect, out_len) == 0,
+                    "reassembled payload mismatch");
+    }
+    TEST_ASSERT(completed == 2 && ra.active == 0 && ra.total_bytes == 0,
+                "streams not completed");
+    
+    /* Plain messages pass straight through */
+    DCFSerWriter writer;
+    const uint8_t* data;
+    size_t len;
+    TEST_CHECK(dcf_ser_writer_init(&writer, 0x0401, DCF_SER_FLAG_NONE));
+    TEST_CHECK(dcf_ser_write_u8(&writer, 9));
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    
+    DCFSerReader reader;
+    bool complete;
+    TEST_CHECK(dcf_ser_reassembler_push(&ra, data, len, &reader, &complete));
+    TEST_ASSERT(complete && reader.buffer == data, "plain message should be zero-copy");
+    dcf_ser_writer_destroy(&writer);
+    dcf_ser_reassembler_destroy(&ra);
+    
+    /* Per-stream cap drops the stream */
+    DCFSerReassemblerOptions opts = {0};
+    opts.max_stream_bytes = 1024;
+    TEST_CHECK(dcf_ser_reassembler_init(&ra, &opts));
+    DCFSerError err = DCF_SER_OK;
+    for (size_t off = 0; off < a.len && err == DCF_SER_OK; ) {
+        size_t msg_len = dcf_ser_message_length(a.data + off);
+        err = dcf_ser_reassembler_push(&ra, a.data + off, msg_len, &reader, &complete);
+        off += msg_len;
+    }
+    TEST_ASSERT(err == DCF_SER_ERR_TOO_LARGE, "per-stream cap not enforced");
+    TEST_ASSERT(ra.active == 0 && ra.total_bytes == 0, "oversized stream not dropped");
+    
+    /* One stream slot: a second concurrent stream is refused */
+    dcf_ser_reassembler_destroy(&ra);
+    opts.max_stream_bytes = 0;
+    opts.max_streams = 1;
+    TEST_CHECK(dcf_ser_reassembler_init(&ra, &opts));
+    TEST_CHECK(dcf_ser_reassembler_push(&ra, a.data, dcf_ser_message_length(a.data),
+                                        &reader, &complete));
+    TEST_ASSERT(dcf_ser_reassembler_push(&ra, b.data, dcf_ser_message_length(b.data),
+                                         &reader, &complete) == DCF_SER_ERR_BUFFER_FULL,
+                "stream limit not enforced");
+    TEST_CHECK(dcf_ser_reassembler_drop(&ra, 0x0400, 1));
+    TEST_ASSERT(dcf_ser_reassembler_drop(&ra, 0x0400, 1) == DCF_SER_ERR_NOT_FOUND,
+                "dropped stream still present");
+    dcf_ser_reassembler_destroy(&ra);
+    
+    /* Cut-through delivers payloads without buffering */
+    static CutThrough ct;
+    memset(&ct, 0, sizeof(ct));
+    memset(&opts, 0, sizeof(opts));
+    opts.on_chunk = cut_through;
+    opts.ctx = &ct;
+    TEST_CHECK(dcf_ser_reassembler_init(&ra, &opts));
+    for (size_t off = 0; off < b.len; ) {
+        size_t msg_len = dcf_ser_message_length(b.data + off);
+        TEST_CHECK(dcf_ser_reassembler_push(&ra, b.data + off, msg_len, &reader, &complete));
+        TEST_ASSERT(!complete && ra.total_bytes == 0, "cut-through should not buffer");
+        off += msg_len;
+    }
+    TEST_ASSERT(ct.final && ct.len == 5 + 5 + sizeof(blob_b), "cut-through length mismatch");
+    TEST_ASSERT(memcmp(ct.data + 10, blob_b, sizeof(blob_b)) == 0, "cut-through payload mismatch");
+    dcf_ser_reassembler_destroy(&ra);
+    
+    printf("  Reassembly tests PASSED\n");
+    return 0;
+}
+
+static int test_framer(void) {
+    printf("Testing stream framer...\n");
+    
+    /* Stream: msg, garbage, msg (corrupt), big msg, compact msg */
+    static uint8_t stream[200 * 1024];
+    size_t stream_len = 0;
+    static uint8_t big[100 * 1024];
+    memset(big, 'D', sizeof(big));  /* Plenty of false magic candidates */
+    
+    DCFSerWriter writer;
+    const uint8_t* data;
+    size_t len;
+    for (int i = 0; i < 4; i++) {
+        TEST_CHECK(dcf_ser_writer_init(&writer, (uint16_t)(0x0500 + i),
+                                       i == 3 ? DCF_SER_FLAG_COMPACT : DCF_SER_FLAG_NONE));
+        if (i == 2) {
+            TEST_CHECK(dcf_ser_write_raw(&writer, big, sizeof(big)));
+        } else {
+            TEST_CHECK(dcf_ser_write_u32(&writer, (uint32_t)i));
+        }
+        TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+        memcpy(stream + stream_len, data, len);
+        if (i == 1) stream[stream_len + len - 1] ^= 0xFF;  /* Bad CRC */
+        stream_len += len;
+        dcf_ser_writer_destroy(&writer);
+        
+        if (i == 0) {
+            static const char junk[] = "xxDCDCFDxx";
+            memcpy(stream + stream_len, junk, sizeof(junk) - 1);
+            stream_len += sizeof(junk) - 1;
+        }
+    }
+    
+    DCFSerFramerOptions opts = {0};
+    opts.capacity = 256;
+    opts.validate = true;
+    DCFSerFramer framer;
+    TEST_CHECK(dcf_ser_framer_init(&framer, &opts));
+    
+    /* Feed in small fragments through the zero-copy receive API */
+    uint16_t types[8];
+    size_t found = 0;
+    size_t off = 0;
+    while (off < stream_len) {
+        uint8_t* dst;
+        size_t avail;
+        TEST_CHECK(dcf_ser_framer_write_ptr(&framer, 1, &dst, &avail));
+        size_t n = stream_len - off;
+        if (n > 1000) n = 1000;
+        if (n > avail) n = avail;
+        memcpy(dst, stream + off, n);
+        TEST_CHECK(dcf_ser_framer_commit(&framer, n));
+        off += n;
+        
+        DCFSerFrame frames[4];
+        size_t count;
+        TEST_CHECK(dcf_ser_framer_next_batch(&framer, frames, 4, &count));
+        for (size_t i = 0; i < count && found < 8; i++) {
+            DCFSerReader reader;
+            TEST_CHECK(dcf_ser_reader_init(&reader, frames[i].data, frames[i].len));
+            TEST_CHECK(dcf_ser_reader_validate(&reader));
+            types[found++] = dcf_ser_reader_msg_type(&reader);
+        }
+    }
+    
+    TEST_ASSERT(found == 3, "expected three intact frames");
+    TEST_ASSERT(types[0] == 0x0500 && types[1] == 0x0502 && types[2] == 0x0503,
+                "wrong frames recovered");
+    TEST_ASSERT(framer.skipped > 0, "resync not counted");
+    
+    DCFSerFrame frame;
+    TEST_ASSERT(dcf_ser_framer_next(&framer, &frame) == DCF_SER_ERR_NOT_FOUND,
+                "empty framer returned a frame");
+    
+    /* Byte-at-a-time delivery via push */
+    dcf_ser_framer_destroy(&framer);
+    TEST_CHECK(dcf_ser_framer_init(&framer, NULL));
+    found = 0;
+    for (off = 0; off < 64 && off < stream_len; off++) {
+        TEST_CHECK(dcf_ser_framer_push(&framer, stream + off, 1));
+        while (dcf_ser_framer_next(&framer, &frame) == DCF_SER_OK) found++;
+    }
+    TEST_ASSERT(found == 2, "byte-wise framing failed");  /* No CRC check: corrupt one passes */
+    dcf_ser_framer_destroy(&framer);
+    
+    /* Compact frames have no magic; validation resyncs on their sync bytes */
+    stream_len = 0;
+    for (int i = 0; i < 5; i++) {
+        TEST_CHECK(dcf_ser_writer_init(&writer, (uint16_t)(0x0600 + i), DCF_SER_FLAG_COMPACT));
+        TEST_CHECK(dcf_ser_write_u32(&writer, 0xD8D9DCDDu));  /* False sync bytes */
+        TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+        memcpy(stream + stream_len, data, len);
+        if (i == 0) stream[stream_len + len - 1] ^= 0xFF;  /* Bad CRC */
+        stream_len += len;
+        dcf_ser_writer_destroy(&writer);
+    }
+    TEST_CHECK(dcf_ser_framer_init(&framer, &opts));
+    TEST_CHECK(dcf_ser_framer_push(&framer, stream, stream_len));
+    found = 0;
+    while (found < 8 && dcf_ser_framer_next(&framer, &frame) == DCF_SER_OK) {
+        DCFSerReader reader;
+        TEST_CHECK(dcf_ser_reader_init(&reader, frame.data, frame.len));
+        TEST_CHECK(dcf_ser_reader_validate(&reader));
+        types[found++] = dcf_ser_reader_msg_type(&reader);
+    }
+    TEST_ASSERT(found == 4, "expected four intact compact frames");
+    for (size_t i = 0; i < found; i++) {
+        TEST_ASSERT(types[i] == 0x0601 + i, "wrong compact frame recovered");
+    }
+    dcf_ser_framer_destroy(&framer);
+    
+    printf("  Framer tests PASSED\n");
+    return 0;
+}
+
+/* One resumable decode step; returns NEED_MORE to be retried after a feed */
+static DCFSerError incremental_step(DCFSerReader* r, int step, uint32_t* sum) {
+    uint16_t id;
+    DCFSerType type;
+    size_t count, len;
+    const char* str;
+    uint32_t u32;
+    
+    switch (step) {
+        case 0: return dcf_ser_read_struct_begin(r, &id);
+        case 1: return dcf_ser_read_field(r, &id, &type);
+        case 2: return dcf_ser_read_string(r, &str, &len);
+        case 3: return dcf_ser_read_field(r, &id, &type);
+        case 4: return dcf_ser_reader_skip(r);   /* Unknown field */
+        case 5: return dcf_ser_read_field(r, &id, &type);
+        case 6: return dcf_ser_read_array_begin(r, &type, &count);
+        case 7: return dcf_ser_read_array_end(r);
+        case 8: {
+            DCFSerError err = dcf_ser_read_field(r, &id, &type);
+            return err == DCF_SER_ERR_NOT_FOUND ? DCF_SER_OK : DCF_SER_ERR_MALFORMED;
+        }
+        case 9: return dcf_ser_read_struct_end(r);
+        default:
+            /* Array elements run between steps 6 and 7 */
+            if (step >= 100) {
+                DCFSerError err = dcf_ser_read_u32(r, &u32);
+                if (err == DCF_SER_OK) *sum += u32;
+                return err;
+            }
+            return DCF_SER_ERR_INVALID_ARG;
+    }
+}
+
+static int test_incremental(void) {
+    printf("Testing incremental reader...\n");
+    
+    DCFSerWriter writer;
+    TEST_CHECK(dcf_ser_writer_init(&writer, 0x0600, DCF_SER_FLAG_NONE));
+    TEST_CHECK(dcf_ser_write_struct_begin(&writer, 1));
+    TEST_CHECK(dcf_ser_write_field(&writer, 1, DCF_TYPE_STRING));
+    TEST_CHECK(dcf_ser_write_string(&writer, "incremental decode"));
+    TEST_CHECK(dcf_ser_write_field(&writer, 2, DCF_TYPE_BYTES));
+    static uint8_t blob[3000];
+    memset(blob, 0x33, sizeof(blob));
+    TEST_CHECK(dcf_ser_write_bytes(&writer, blob, sizeof(blob)));
+    TEST_CHECK(dcf_ser_write_field(&writer, 3, DCF_TYPE_ARRAY));
+    TEST_CHECK(dcf_ser_write_array_begin(&writer, DCF_TYPE_U32, 50));
+    uint32_t expect = 0;
+    for (uint32_t i = 0; i < 50; i++) {
+        TEST_CHECK(dcf_ser_write_u32(&writer, i * 3));
+        expect += i * 3;
+    }
+    TEST_CHECK(dcf_ser_write_array_end(&writer));
+    TEST_CHECK(dcf_ser_write_struct_end(&writer));
+    
+    const uint8_t* data;
+    size_t len;
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    
+    /* Deliver 7 bytes at a time, decoding as far as possible each time */
+    DCFSerReader reader;
+    size_t avail = 7;
+    TEST_ASSERT(dcf_ser_reader_init_incremental(&reader, data, avail) == DCF_SER_ERR_NEED_MORE,
+                "header should be incomplete");
+    
+    int steps[64];
+    int nsteps = 0;
+    for (int i = 0; i <= 6; i++) steps[nsteps++] = i;
+    for (int i = 0; i < 50; i++) steps[nsteps++] = 100 + i;
+    for (int i = 7; i <= 9; i++) steps[nsteps++] = i;
+    
+    int next = 0;
+    int stalls = 0;
+    uint32_t sum = 0;
+    while (true) {
+        DCFSerError err = DCF_SER_ERR_NEED_MORE;
+        while (reader.header_valid && next < nsteps &&
+               (err = incremental_step(&reader, steps[next], &sum)) == DCF_SER_OK) {
+            next++;
+        }
+        if (next < nsteps) {
+            TEST_ASSERT(err == DCF_SER_ERR_NEED_MORE, "unexpected decode error");
+            stalls++;
+        }
+        if (avail == len) break;
+        
+        avail = (avail + 7 < len) ? avail + 7 : len;
+        err = dcf_ser_reader_feed(&reader, data, avail);
+        TEST_ASSERT(err == DCF_SER_OK || err == DCF_SER_ERR_NEED_MORE, "feed failed");
+        if (avail < len) {
+            TEST_ASSERT(dcf_ser_reader_finish(&reader) == DCF_SER_ERR_NEED_MORE,
+                        "finish before the end");
+        }
+    }
+    
+    TEST_ASSERT(next == nsteps, "decode did not complete");
+    TEST_ASSERT(stalls > 100, "decode should have stalled on partial data");
+    TEST_ASSERT(sum == expect, "array contents mismatch");
+    TEST_ASSERT(reader.depth == 0, "container depth not restored");
+    TEST_CHECK(dcf_ser_reader_finish(&reader));
+    TEST_ASSERT(reader.crc_verified, "CRC not verified at the end");
+    
+    /* Corruption is reported once the message is complete */
+    static uint8_t corrupt[4096];
+    memcpy(corrupt, data, len);
+    corrupt[len / 2] ^= 0x40;
+    TEST_CHECK(dcf_ser_reader_init_incremental(&reader, corrupt, len / 2 + 1));
+    TEST_ASSERT(dcf_ser_reader_feed(&reader, corrupt, len) == DCF_SER_ERR_CRC_MISMATCH,
+                "CRC corruption not detected");
+    TEST_ASSERT(dcf_ser_reader_finish(&reader) == DCF_SER_ERR_CRC_MISMATCH,
+                "finish should report the CRC error");
+    
+    /* Truncation past the declared payload is still an error */
+    TEST_CHECK(dcf_ser_reader_init_incremental(&reader, data, len));
+    reader.payload_end = reader.payload_start + 2;
+    TEST_ASSERT(dcf_ser_reader_skip(&reader) == DCF_SER_ERR_TRUNCATED,
+                "skip past payload end not caught");
+    
+    dcf_ser_writer_destroy(&writer);
+    
+    printf("  Incremental reader tests PASSED\n");
+    return 0;
+}
+
+static int test_iov_reader(void) {
+    printf("Testing segmented reader...\n");
+    
+    static uint8_t blob[200];
+    for (size_t i = 0; i < sizeof(blob); i++) blob[i] = (uint8_t)(i ^ 0x5A);
+    
+    DCFSerWriter writer;
+    TEST_CHECK(dcf_ser_writer_init(&writer, 0x0700, DCF_SER_FLAG_NONE));
+    TEST_CHECK(dcf_ser_write_u64(&writer, 0x0102030405060708ULL));
+    TEST_CHECK(dcf_ser_write_string(&writer, "straddles a segment boundary"));
+    TEST_CHECK(dcf_ser_write_bytes(&writer, blob, sizeof(blob)));
+    TEST_CHECK(dcf_ser_write_struct_begin(&writer, 9));
+    TEST_CHECK(dcf_ser_write_field(&writer, 1, DCF_TYPE_BYTES));
+    TEST_CHECK(dcf_ser_write_bytes(&writer, blob, sizeof(blob)));
+    TEST_CHECK(dcf_ser_write_struct_end(&writer));
+    TEST_CHECK(dcf_ser_write_varint(&writer, 300));
+    
+    const uint8_t* data;
+    size_t len;
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    
+    /* Try many segment sizes, including ones smaller than any value */
+    static const size_t sizes[] = { 1, 3, 7, 16, 50, 4096 };
+    for (size_t t = 0; t < sizeof(sizes) / sizeof(sizes[0]); t++) {
+        DCFSerIoVec iov[1024];
+        size_t count = 0;
+        for (size_t off = 0; off < len; off += sizes[t]) {
+            iov[count].iov_base = (void*)(data + off);
+            iov[count].iov_len = (len - off < sizes[t]) ? len - off : sizes[t];
+            count++;
+        }
+        
+        DCFSerReader reader;
+        TEST_CHECK(dcf_ser_reader_init_iov(&reader, iov, count));
+        TEST_CHECK(dcf_ser_reader_validate(&reader));
+        TEST_ASSERT(reader.crc_verified, "segmented CRC not verified");
+        TEST_ASSERT(dcf_ser_reader_payload_length(&reader) == len - sizeof(DCFSerHeader) - 4,
+                    "segmented payload length mismatch");
+        
+        uint64_t u64;
+        TEST_CHECK(dcf_ser_read_u64(&reader, &u64));
+        TEST_ASSERT(u64 == 0x0102030405060708ULL, "u64 across segments mismatch");
+        
+        const char* str;
+        size_t str_len;
+        TEST_CHECK(dcf_ser_read_string(&reader, &str, &str_len));
+        TEST_ASSERT(str_len == 28 && memcmp(str, "straddles a segment boundary", 28) == 0,
+                    "string across segments mismatch");
+        
+        /* Large values come back as fragments */
+        DCFSerIoVec frags[256];
+        size_t nfrags, blob_len;
+        if (sizes[t] < sizeof(blob)) {
+            const void* ptr;
+            size_t ptr_len;
+            TEST_ASSERT(dcf_ser_read_bytes(&reader, &ptr, &ptr_len) == DCF_SER_ERR_FRAGMENTED,
+                        "large straddling value should be fragmented");
+        }
+        TEST_CHECK(dcf_ser_read_bytes_iov(&reader, frags, 256, &nfrags, &blob_len));
+        TEST_ASSERT(blob_len == sizeof(blob), "fragment total mismatch");
+        size_t pos = 0;
+        for (size_t i = 0; i < nfrags; i++) {
+            TEST_ASSERT(memcmp(frags[i].iov_base, blob + pos, frags[i].iov_len) == 0,
+                        "fragment contents mismatch");
+            pos += frags[i].iov_len;
+        }
+        TEST_ASSERT(pos == sizeof(blob), "fragments do not cover the value");
+        
+        /* Skipping needs no contiguity */
+        uint16_t type_id;
+        TEST_CHECK(dcf_ser_read_struct_begin(&reader, &type_id));
+        uint16_t field_id;
+        DCFSerType type;
+        TEST_CHECK(dcf_ser_read_field(&reader, &field_id, &type));
+        TEST_CHECK(dcf_ser_reader_skip(&reader));
+        TEST_ASSERT(dcf_ser_read_field(&reader, &field_id, &type) == DCF_SER_ERR_NOT_FOUND,
+                    "struct end marker not found");
+        TEST_CHECK(dcf_ser_read_struct_end(&reader));
+        
+        uint64_t v;
+        TEST_ASSERT(dcf_ser_reader_peek_type(&reader) == DCF_TYPE_VARINT, "peek across segments");
+        TEST_CHECK(dcf_ser_read_varint(&reader, &v));
+        TEST_ASSERT(v == 300, "varint across segments mismatch");
+        TEST_ASSERT(dcf_ser_reader_at_end(&reader), "segmented reader not at end");
+    }
+    
+    /* Skip a struct with the boundary at every possible offset */
+    dcf_ser_writer_reset(&writer, 0x0701, DCF_SER_FLAG_NONE);
+    TEST_CHECK(dcf_ser_write_struct_begin(&writer, 10));
+    TEST_CHECK(dcf_ser_write_field(&writer, 1, DCF_TYPE_U32));
+    TEST_CHECK(dcf_ser_write_u32(&writer, 1));
+    TEST_CHECK(dcf_ser_write_field(&writer, 2, DCF_TYPE_U32));
+    TEST_CHECK(dcf_ser_write_u32(&writer, 2));
+    TEST_CHECK(dcf_ser_write_struct_end(&writer));
+    TEST_CHECK(dcf_ser_write_u32(&writer, 0xC0FFEE));
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    for (size_t cut = 1; cut < len; cut++) {
+        DCFSerIoVec split[2] = {
+            { (void*)data, cut },
+            { (void*)(data + cut), len - cut },
+        };
+        DCFSerReader reader;
+        uint32_t after;
+        TEST_CHECK(dcf_ser_reader_init_iov(&reader, split, 2));
+        TEST_CHECK(dcf_ser_reader_validate(&reader));
+        TEST_CHECK(dcf_ser_reader_skip(&reader));
+        TEST_CHECK(dcf_ser_read_u32(&reader, &after));
+        TEST_ASSERT(after == 0xC0FFEE, "value after skipped struct misread");
+    }
+    
+    /* Corruption in any segment is caught */
+    static uint8_t corrupt[1024];
+    memcpy(corrupt, data, len);
+    corrupt[len - 10] ^= 0x01;
+    DCFSerIoVec halves[2] = {
+        { corrupt, len / 2 },
+        { corrupt + len / 2, len - len / 2 },
+    };
+    DCFSerReader reader;
+    TEST_CHECK(dcf_ser_reader_init_iov(&reader, halves, 2));
+    TEST_ASSERT(dcf_ser_reader_validate(&reader) == DCF_SER_ERR_CRC_MISMATCH,
+                "segmented CRC corruption not detected");
+    
+    dcf_ser_writer_destroy(&writer);
+    
+    printf("  Segmented reader tests PASSED\n");
+    return 0;
+}
+
+/* Trust a copy of msg with payload byte `at` replaced (at < 0: untouched) */
+static DCFSerError trust_mutated(const uint8_t* msg, size_t len, long at, uint8_t value) {
+    uint8_t copy[256];
+    memcpy(copy, msg, len);
+    if (at >= 0) copy[sizeof(DCFSerHeader) + (size_t)at] = value;
+    
+    DCFSerReader reader;
+    DCFSerError err = dcf_ser_reader_init(&reader, copy, len);
+    if (err == DCF_SER_OK) err = dcf_ser_reader_validate(&reader);
+    if (err == DCF_SER_OK) err = dcf_ser_reader_trust(&reader);
+    return err;
+}
+
+static int test_trusted(void) {
+    printf("Testing trusted reader...\n");
+    
+    DCFSerWriter writer;
+    TEST_CHECK(dcf_ser_writer_init(&writer, 0x0800, DCF_SER_FLAG_NONE));
+    TEST_CHECK(dcf_ser_write_u32(&writer, 0xCAFEBABE));
+    TEST_CHECK(dcf_ser_write_i16(&writer, -7));
+    TEST_CHECK(dcf_ser_write_f64(&writer, 1.5));
+    TEST_CHECK(dcf_ser_write_varint(&writer, 1u << 20));
+    TEST_CHECK(dcf_ser_write_string(&writer, "trusted"));
+    TEST_CHECK(dcf_ser_write_array_begin(&writer, DCF_TYPE_U32, 3));
+    for (uint32_t i = 0; i < 3; i++) TEST_CHECK(dcf_ser_write_u32(&writer, i * 10));
+    TEST_CHECK(dcf_ser_write_array_end(&writer));
+    TEST_CHECK(dcf_ser_write_struct_begin(&writer, 42));
+    TEST_CHECK(dcf_ser_write_field(&writer, 1, DCF_TYPE_BOOL));
+    TEST_CHECK(dcf_ser_write_bool(&writer, true));
+    TEST_CHECK(dcf_ser_write_struct_end(&writer));
+    
+    const uint8_t* data;
+    size_t len;
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    
+    DCFSerReader reader;
+    TEST_CHECK(dcf_ser_reader_init(&reader, data, len));
+    TEST_ASSERT(dcf_ser_reader_trust(&reader) == DCF_SER_ERR_INVALID_ARG,
+                "trust before validate should fail");
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    TEST_CHECK(dcf_ser_reader_trust(&reader));
+    TEST_ASSERT(reader.trusted, "reader not marked trusted");
+    
+    TEST_ASSERT(dcf_ser_read_u32_unchecked(&reader) == 0xCAFEBABE, "unchecked u32 mismatch");
+    TEST_ASSERT(dcf_ser_read_i16_unchecked(&reader) == -7, "unchecked i16 mismatch");
+    TEST_ASSERT(dcf_ser_read_f64_unchecked(&reader) == 1.5, "unchecked f64 mismatch");
+    TEST_ASSERT(dcf_ser_read_varint_unchecked(&reader) == (1u << 20), "unchecked varint mismatch");
+    size_t str_len;
+    const char* str = dcf_ser_read_string_unchecked(&reader, &str_len);
+    TEST_ASSERT(str_len == 7 && memcmp(str, "trusted", 7) == 0, "unchecked string mismatch");
+    size_t count = dcf_ser_read_array_begin_unchecked(&reader);
+    TEST_ASSERT(count == 3, "unchecked array count mismatch");
+    for (uint32_t i = 0; i < count; i++) {
+        TEST_ASSERT(dcf_ser_read_u32_unchecked(&reader) == i * 10, "unchecked element mismatch");
+    }
+    dcf_ser_read_end_unchecked(&reader);
+    TEST_ASSERT(dcf_ser_read_struct_begin_unchecked(&reader) == 42, "unchecked type_id mismatch");
+    uint16_t field_id;
+    DCFSerType type;
+    TEST_ASSERT(dcf_ser_read_field_unchecked(&reader, &field_id, &type) &&
+                field_id == 1 && type == DCF_TYPE_BOOL, "unchecked field mismatch");
+    TEST_ASSERT(dcf_ser_read_bool_unchecked(&reader), "unchecked bool mismatch");
+    TEST_ASSERT(!dcf_ser_read_field_unchecked(&reader, &field_id, &type), "missing end marker");
+    dcf_ser_read_end_unchecked(&reader);
+    TEST_ASSERT(dcf_ser_reader_at_end(&reader) && reader.depth == 0, "unchecked decode not at end");
+    
+    /* Sorted maps read like plain maps once the offset table is skipped */
+    dcf_ser_writer_reset(&writer, 0x0802, DCF_SER_FLAG_NONE);
+    TEST_CHECK(dcf_ser_write_sorted_map_begin(&writer, DCF_TYPE_U32, DCF_TYPE_U32, 2));
+    TEST_CHECK(dcf_ser_write_u32(&writer, 2));
+    TEST_CHECK(dcf_ser_write_u32(&writer, 20));
+    TEST_CHECK(dcf_ser_write_u32(&writer, 1));
+    TEST_CHECK(dcf_ser_write_u32(&writer, 10));
+    TEST_CHECK(dcf_ser_write_sorted_map_end(&writer));
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    TEST_CHECK(dcf_ser_reader_init(&reader, data, len));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    TEST_CHECK(dcf_ser_reader_trust(&reader));
+    count = dcf_ser_read_map_begin_unchecked(&reader);
+    TEST_ASSERT(count == 2, "unchecked sorted map count mismatch");
+    for (uint32_t i = 1; i <= count; i++) {
+        uint32_t k = dcf_ser_read_u32_unchecked(&reader);
+        uint32_t v = dcf_ser_read_u32_unchecked(&reader);
+        TEST_ASSERT(k == i && v == i * 10, "unchecked sorted map entry mismatch");
+    }
+    dcf_ser_read_end_unchecked(&reader);
+    TEST_ASSERT(dcf_ser_reader_at_end(&reader), "unchecked sorted map not at end");
+    
+    dcf_ser_writer_destroy(&writer);
+    
+    /* Malformed payloads are rejected up front */
+    uint8_t msg[64];
+    TEST_CHECK(dcf_ser_writer_init(&writer, 0x0801, DCF_SER_FLAG_NO_CRC));
+    TEST_CHECK(dcf_ser_write_string(&writer, "ab"));                 /* payload 0..6 */
+    TEST_CHECK(dcf_ser_write_array_begin(&writer, DCF_TYPE_U8, 1));  /* payload 7..12 */
+    TEST_CHECK(dcf_ser_write_u8(&writer, 5));                        /* payload 13..14 */
+    TEST_CHECK(dcf_ser_write_array_end(&writer));
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    TEST_ASSERT(len <= sizeof(msg), "malformed fixture too large");
+    memcpy(msg, data, len);
+    dcf_ser_writer_destroy(&writer);
+    
+    TEST_CHECK(trust_mutated(msg, len, -1, 0));
+    TEST_ASSERT(trust_mutated(msg, len, 0, 0x7F) == DCF_SER_ERR_INVALID_TYPE,
+                "unknown tag accepted");
+    TEST_ASSERT(trust_mutated(msg, len, 4, 0x40) == DCF_SER_ERR_TRUNCATED,
+                "overlong string accepted");
+    TEST_ASSERT(trust_mutated(msg, len, 13, DCF_TYPE_I8) == DCF_SER_ERR_TYPE_MISMATCH,
+                "element type mismatch accepted");
+    TEST_ASSERT(trust_mutated(msg, len, 12, 2) == DCF_SER_ERR_TRUNCATED,
+                "overlong array accepted");
+    
+    /* Trailing bytes that are not a complete value */
+    TEST_CHECK(dcf_ser_writer_init(&writer, 0x0802, DCF_SER_FLAG_NO_CRC));
+    TEST_CHECK(dcf_ser_write_u8(&writer, 1));
+    TEST_CHECK(dcf_ser_write_u8(&writer, 2));
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    memcpy(msg, data, len);
+    TEST_ASSERT(trust_mutated(msg, len, 2, DCF_TYPE_U32) == DCF_SER_ERR_TRUNCATED,
+                "trailing garbage accepted");
+    
+    dcf_ser_writer_destroy(&writer);
+    printf("  PASSED\n");
+    return 0;
+}
+
+static int test_validate_structure(void) {
+    printf("Testing structural validation...\n");
+    
+    DCFSerWriter writer;
+    TEST_CHECK(dcf_ser_writer_init(&writer, 0x0900, DCF_SER_FLAG_NONE));
+    TEST_CHECK(dcf_ser_write_u8(&writer, 7));
+    TEST_CHECK(dcf_ser_write_string(&writer, "hi"));
+    TEST_CHECK(dcf_ser_write_struct_begin(&writer, 3));
+    TEST_CHECK(dcf_ser_write_field(&writer, 1, DCF_TYPE_ARRAY));
+    TEST_CHECK(dcf_ser_write_array_begin(&writer, DCF_TYPE_U32, 3));
+    for (uint32_t i = 0; i < 3; i++) TEST_CHECK(dcf_ser_write_u32(&writer, i));
+    TEST_CHECK(dcf_ser_write_array_end(&writer));
+    TEST_CHECK(dcf_ser_write_field(&writer, 2, DCF_TYPE_MAP));
+    TEST_CHECK(dcf_ser_write_map_begin(&writer, DCF_TYPE_STRING, DCF_TYPE_I32, 1));
+    TEST_CHECK(dcf_ser_write_string(&writer, "k"));
+    TEST_CHECK(dcf_ser_write_i32(&writer, -1));
+    TEST_CHECK(dcf_ser_write_map_end(&writer));
+    TEST_CHECK(dcf_ser_write_struct_end(&writer));
+    TEST_CHECK(dcf_ser_write_varint(&writer, 5));
+    
+    const uint8_t* data;
+    size_t len;
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    
+    TEST_CHECK(dcf_ser_validate_structure(data, len, NULL));
+    
+    DCFSerIndexEntry entries[16];
+    DCFSerIndex index = { entries, 16, 0, NULL };
+    TEST_CHECK(dcf_ser_validate_structure(data, len, &index));
+    TEST_ASSERT(index.count == 8, "wrong index entry count");
+    TEST_ASSERT(index.payload == data + sizeof(DCFSerHeader), "wrong index payload base");
+    
+    static const uint8_t types[8] = {
+        DCF_TYPE_U8, DCF_TYPE_STRING, DCF_TYPE_STRUCT, DCF_TYPE_ARRAY,
+        DCF_TYPE_MAP, DCF_TYPE_STRING, DCF_TYPE_I32, DCF_TYPE_VARINT
+    };
+    static const uint32_t parents[8] = {
+        DCF_SER_INDEX_ROOT, DCF_SER_INDEX_ROOT, DCF_SER_INDEX_ROOT, 2, 2, 4, 4, DCF_SER_INDEX_ROOT
+    };
+    for (size_t i = 0; i < 8; i++) {
+        TEST_ASSERT(entries[i].type == types[i], "wrong indexed type");
+        TEST_ASSERT(entries[i].parent == parents[i], "wrong indexed parent");
+        TEST_ASSERT(index.payload[entries[i].offset] == types[i], "offset not at tag");
+    }
+    TEST_ASSERT(entries[3].field_id == 1 && entries[4].field_id == 2, "wrong field ids");
+    TEST_ASSERT(entries[3].end - entries[3].offset == 6 + 3 * 5, "wrong array extent");
+    TEST_ASSERT(entries[4].end == entries[6].end, "map should end after its last value");
+    TEST_ASSERT(entries[2].end == entries[4].end + 3, "struct should end after its end marker");
+    TEST_ASSERT(entries[7].end == len - sizeof(DCFSerHeader) - 4, "index does not cover payload");
+    TEST_ASSERT(entries[5].depth == 2, "wrong nesting depth");
+    
+    /* Decoding can start from any indexed value */
+    DCFSerReader reader;
+    TEST_CHECK(dcf_ser_reader_init(&reader, data, len));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    reader.position = reader.payload_start + entries[6].offset;
+    int32_t i32;
+    TEST_CHECK(dcf_ser_read_i32(&reader, &i32));
+    TEST_ASSERT(i32 == -1, "value at indexed offset mismatch");
+    
+    index.capacity = 4;
+    TEST_ASSERT(dcf_ser_validate_structure(data, len, &index) == DCF_SER_ERR_BUFFER_FULL,
+                "small index should report BUFFER_FULL");
+    
+    /* Corruption is caught by the CRC first, then by the walk */
+    uint8_t copy[128];
+    TEST_ASSERT(len <= sizeof(copy), "fixture too large");
+    memcpy(copy, data, len);
+    copy[sizeof(DCFSerHeader) + 20] ^= 0xFF;
+    TEST_ASSERT(dcf_ser_validate_structure(copy, len, NULL) == DCF_SER_ERR_CRC_MISMATCH,
+                "corrupt message accepted");
+    dcf_ser_writer_destroy(&writer);
+    
+    TEST_CHECK(dcf_ser_writer_init(&writer, 0x0901, DCF_SER_FLAG_NO_CRC));
+    TEST_CHECK(dcf_ser_write_array_begin(&writer, DCF_TYPE_U16, 4));
+    for (uint16_t i = 0; i < 4; i++) TEST_CHECK(dcf_ser_write_u16(&writer, i));
+    TEST_CHECK(dcf_ser_write_array_end(&writer));
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    memcpy(copy, data, len);
+    copy[sizeof(DCFSerHeader) + 6 + 2 * 3] = DCF_TYPE_I16;   /* Third element tag */
+    TEST_ASSERT(dcf_ser_validate_structure(copy, len, NULL) == DCF_SER_ERR_TYPE_MISMATCH,
+                "mistyped array element accepted");
+    copy[sizeof(DCFSerHeader) + 6 + 2 * 3] = DCF_TYPE_U16;
+    copy[sizeof(DCFSerHeader) + 5] = 5;                       /* Count beyond payload */
+    TEST_ASSERT(dcf_ser_validate_structure(copy, len, NULL) == DCF_SER_ERR_TRUNCATED,
+                "overlong array accepted");
+    
+    dcf_ser_writer_destroy(&writer);
+    printf("  PASSED\n");
+    return 0;
+}
+
+/* Decodes {1: u32 id, 2: string} elements into ids[first..] */
+static DCFSerError decode_id_range(void* ctx, DCFSerReader* r, size_t first, size_t count) {
+    uint32_t* ids = (uint32_t*)ctx;
+    for (size_t i = 0; i < count; i++) {
+        uint16_t type_id, field_id;
+        DCFSerType type;
+        const char* str;
+        size_t str_len;
+        DCF_SER_CHECK(dcf_ser_read_struct_begin(r, &type_id));
+        DCF_SER_CHECK(dcf_ser_read_field(r, &field_id, &type));
+        DCF_SER_CHECK(dcf_ser_read_u32(r, &ids[first + i]));
+        DCF_SER_CHECK(dcf_ser_read_field(r, &field_id, &type));
+        DCF_SER_CHECK(dcf_ser_read_string(r, &str, &str_len));
+        if (dcf_ser_read_field(r, &field_id, &type) != DCF_SER_ERR_NOT_FOUND) {
+            return DCF_SER_ERR_MALFORMED;
+        }
+        DCF_SER_CHECK(dcf_ser_read_struct_end(r));
+    }
+    return DCF_SER_OK;
+}
+
+static int test_array_index(void) {
+    printf("Testing array offset index...\n");
+    
+    enum { N = 1000 };
+    DCFSerWriter writer;
+    TEST_CHECK(dcf_ser_writer_init(&writer, 0x0A00, DCF_SER_FLAG_NONE));
+    TEST_CHECK(dcf_ser_write_array_begin(&writer, DCF_TYPE_STRUCT, N));
+    for (uint32_t i = 0; i < N; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "e%u", (unsigned)i);
+        TEST_CHECK(dcf_ser_write_struct_begin(&writer, 1));
+        TEST_CHECK(dcf_ser_write_field(&writer, 1, DCF_TYPE_U32));
+        TEST_CHECK(dcf_ser_write_u32(&writer, i * 3));
+        TEST_CHECK(dcf_ser_write_field(&writer, 2, DCF_TYPE_STRING));
+        TEST_CHECK(dcf_ser_write_string(&writer, name));
+        TEST_CHECK(dcf_ser_write_struct_end(&writer));
+    }
+    TEST_CHECK(dcf_ser_write_array_end(&writer));
+    TEST_CHECK(dcf_ser_write_array_begin(&writer, DCF_TYPE_U32, N));
+    for (uint32_t i = 0; i < N; i++) TEST_CHECK(dcf_ser_write_u32(&writer, i));
+    TEST_CHECK(dcf_ser_write_array_end(&writer));
+    TEST_CHECK(dcf_ser_write_u8(&writer, 0xEE));
+    
+    const uint8_t* data;
+    size_t len;
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    
+    DCFSerReader reader;
+    TEST_CHECK(dcf_ser_reader_init(&reader, data, len));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    
+    size_t offsets[16];
+    DCFSerArrayIndex tight = { offsets, 16, 0, 1, 0, 0, DCF_TYPE_NULL };
+    DCFSerReader probe = reader;
+    TEST_ASSERT(dcf_ser_array_index_build(&probe, &tight) == DCF_SER_ERR_BUFFER_FULL,
+                "stride 1 should not fit 16 offsets");
+    
+    DCFSerArrayIndex idx = { offsets, 16, 0, 0, 0, 0, DCF_TYPE_NULL };
+    TEST_CHECK(dcf_ser_array_index_build(&reader, &idx));
+    TEST_ASSERT(idx.elements == N && idx.elem_type == DCF_TYPE_STRUCT, "wrong array info");
+    TEST_ASSERT(idx.stride == 63 && idx.count == 16, "wrong automatic stride");
+    
+    /* Random access into the middle */
+    DCFSerReader at;
+    uint32_t one;
+    TEST_CHECK(dcf_ser_array_index_seek(&reader, &idx, 500, &at));
+    TEST_CHECK(decode_id_range(&one, &at, 0, 1));
+    TEST_ASSERT(one == 1500, "seek landed on the wrong element");
+    
+    /* All cores */
+    static uint32_t ids[N];
+    memset(ids, 0xFF, sizeof(ids));
+    TEST_CHECK(dcf_ser_array_decode_parallel(&reader, &idx, 4, decode_id_range, ids));
+    for (uint32_t i = 0; i < N; i++) {
+        TEST_ASSERT(ids[i] == i * 3, "parallel decode mismatch");
+    }
+    
+    /* Fixed-width arrays are indexed without a scan */
+    size_t fixed_offsets[100];
+    DCFSerArrayIndex fixed = { fixed_offsets, 100, 0, 10, 0, 0, DCF_TYPE_NULL };
+    TEST_CHECK(dcf_ser_array_index_build(&reader, &fixed));
+    TEST_ASSERT(fixed.count == 100 && fixed.elem_type == DCF_TYPE_U32, "wrong fixed index");
+    uint32_t u32;
+    TEST_CHECK(dcf_ser_array_index_seek(&reader, &fixed, 777, &at));
+    TEST_CHECK(dcf_ser_read_u32(&at, &u32));
+    TEST_ASSERT(u32 == 777, "fixed seek mismatch");
+    TEST_CHECK(dcf_ser_array_index_seek(&reader, &fixed, N - 1, &at));
+    TEST_CHECK(dcf_ser_read_u32(&at, &u32));
+    TEST_ASSERT(dcf_ser_read_u32(&at, &u32) == DCF_SER_ERR_TRUNCATED,
+                "seeked reader should stop at the array end");
+    
+    /* Building consumed both arrays */
+    uint8_t u8;
+    TEST_CHECK(dcf_ser_read_u8(&reader, &u8));
+    TEST_ASSERT(u8 == 0xEE && reader.depth == 0, "reader not past the arrays");
+    
+    /* A stray element type fails the build and leaves the reader in place */
+    dcf_ser_writer_reset(&writer, 0x0A01, DCF_SER_FLAG_NONE);
+    TEST_CHECK(dcf_ser_write_array_begin(&writer, DCF_TYPE_U32, 3));
+    TEST_CHECK(dcf_ser_write_u32(&writer, 1));
+    TEST_CHECK(dcf_ser_write_string(&writer, "x"));
+    TEST_CHECK(dcf_ser_write_u32(&writer, 3));
+    TEST_CHECK(dcf_ser_write_array_end(&writer));
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    TEST_CHECK(dcf_ser_reader_init(&reader, data, len));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    size_t before = reader.position;
+    TEST_ASSERT(dcf_ser_array_index_build(&reader, &fixed) == DCF_SER_ERR_TYPE_MISMATCH,
+                "mixed fixed-width array indexed");
+    TEST_ASSERT(reader.position == before && reader.depth == 0, "failed build moved the reader");
+    
+    dcf_ser_writer_destroy(&writer);
+    printf("  PASSED\n");
+    return 0;
+}
+
+static int test_sorted_map(void) {
+    printf("Testing sorted maps...\n");
+    
+    enum { N = 500 };
+    DCFSerWriter writer;
+    TEST_CHECK(dcf_ser_writer_init(&writer, 0x0B00, DCF_SER_FLAG_NO_CRC));
+    TEST_CHECK(dcf_ser_write_sorted_map_begin(&writer, DCF_TYPE_STRING, DCF_TYPE_U32, N));
+    for (uint32_t i = 0; i < N; i++) {
+        uint32_t k = (i * 7919) % N;   /* Scrambled insertion order */
+        char key[16];
+        snprintf(key, sizeof(key), "key%05u", (unsigned)k);
+        TEST_CHECK(dcf_ser_write_string(&writer, key));
+        TEST_CHECK(dcf_ser_write_u32(&writer, k * 2));
+    }
+    TEST_CHECK(dcf_ser_write_sorted_map_end(&writer));
+    TEST_CHECK(dcf_ser_write_sorted_map_begin(&writer, DCF_TYPE_I32, DCF_TYPE_BOOL, 3));
+    static const int32_t ikeys[3] = { 40, -5, 0 };
+    for (int i = 0; i < 3; i++) {
+        TEST_CHECK(dcf_ser_write_i32(&writer, ikeys[i]));
+        TEST_CHECK(dcf_ser_write_bool(&writer, ikeys[i] < 0));
+    }
+    TEST_CHECK(dcf_ser_write_sorted_map_end(&writer));
+    TEST_CHECK(dcf_ser_write_u8(&writer, 0x5A));
+    
+    const uint8_t* data;
+    size_t len;
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    TEST_CHECK(dcf_ser_validate_structure(data, len, NULL));
+    
+    DCFSerReader reader, value;
+    TEST_CHECK(dcf_ser_reader_init(&reader, data, len));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    TEST_ASSERT(dcf_ser_reader_peek_type(&reader) == DCF_TYPE_SORTED_MAP, "wrong map tag");
+    
+    /* Point lookups */
+    uint32_t u32;
+    TEST_CHECK(dcf_ser_map_find(&reader, "key00123", 8, &value));
+    TEST_CHECK(dcf_ser_read_u32(&value, &u32));
+    TEST_ASSERT(u32 == 246, "looked-up value mismatch");
+    TEST_CHECK(dcf_ser_map_find(&reader, "key00000", 8, &value));
+    TEST_CHECK(dcf_ser_map_find(&reader, "key00499", 8, &value));
+    TEST_ASSERT(dcf_ser_map_find(&reader, "key00500", 8, &value) == DCF_SER_ERR_NOT_FOUND,
+                "missing key found");
+    TEST_ASSERT(dcf_ser_map_find(&reader, "key", 3, &value) == DCF_SER_ERR_NOT_FOUND,
+                "key prefix found");
+    TEST_ASSERT(dcf_ser_map_find_int(&reader, 1, &value) == DCF_SER_ERR_TYPE_MISMATCH,
+                "integer lookup in string map accepted");
+    
+    /* Sequential reads see the entries in key order */
+    DCFSerType key_type, val_type;
+    size_t count;
+    TEST_CHECK(dcf_ser_read_map_begin(&reader, &key_type, &val_type, &count));
+    TEST_ASSERT(count == N && key_type == DCF_TYPE_STRING, "wrong sorted map header");
+    for (uint32_t i = 0; i < N; i++) {
+        const char* key;
+        size_t key_len;
+        char expect[16];
+        snprintf(expect, sizeof(expect), "key%05u", (unsigned)i);
+        TEST_CHECK(dcf_ser_read_string(&reader, &key, &key_len));
+        TEST_CHECK(dcf_ser_read_u32(&reader, &u32));
+        TEST_ASSERT(key_len == 8 && memcmp(key, expect, 8) == 0 && u32 == i * 2,
+                    "entries not in key order");
+    }
+    TEST_CHECK(dcf_ser_read_map_end(&reader));
+    
+    /* Signed keys order numerically */
+    bool b;
+    TEST_CHECK(dcf_ser_map_find_int(&reader, -5, &value));
+    TEST_CHECK(dcf_ser_read_bool(&value, &b));
+    TEST_ASSERT(b, "signed key value mismatch");
+    TEST_ASSERT(dcf_ser_map_find_int(&reader, 7, &value) == DCF_SER_ERR_NOT_FOUND,
+                "missing integer key found");
+    TEST_ASSERT(dcf_ser_map_find_int(&reader, (1LL << 32) - 5, &value) == DCF_SER_ERR_NOT_FOUND,
+                "out-of-range key matched a truncated entry");
+    TEST_CHECK(dcf_ser_read_map_begin(&reader, &key_type, &val_type, &count));
+    int32_t i32;
+    TEST_CHECK(dcf_ser_read_i32(&reader, &i32));
+    TEST_ASSERT(i32 == -5, "negative key should sort first");
+    dcf_ser_reader_skip(&reader);
+    TEST_CHECK(dcf_ser_read_i32(&reader, &i32));
+    TEST_ASSERT(i32 == 0, "zero key should sort second");
+    
+    /* Skipping uses the same layout */
+    TEST_CHECK(dcf_ser_reader_init(&reader, data, len));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    TEST_CHECK(dcf_ser_reader_skip(&reader));
+    TEST_CHECK(dcf_ser_reader_skip(&reader));
+    uint8_t u8;
+    TEST_CHECK(dcf_ser_read_u8(&reader, &u8));
+    TEST_ASSERT(u8 == 0x5A, "skip over sorted maps failed");
+    
+    /* A corrupt offset table is caught by structural validation */
+    uint8_t* copy = (uint8_t*)malloc(len);
+    TEST_ASSERT(copy != NULL, "alloc failed");
+    memcpy(copy, data, len);
+    copy[sizeof(DCFSerHeader) + 7 + 4 * 10 + 3] ^= 0x01;
+    TEST_ASSERT(dcf_ser_validate_structure(copy, len, NULL) == DCF_SER_ERR_MALFORMED,
+                "corrupt offset table accepted");
+    free(copy);
+    
+    /* Duplicate keys and miscounted entries are rejected */
+    dcf_ser_writer_reset(&writer, 0x0B01, DCF_SER_FLAG_NONE);
+    TEST_CHECK(dcf_ser_write_sorted_map_begin(&writer, DCF_TYPE_U16, DCF_TYPE_NULL, 2));
+    TEST_CHECK(dcf_ser_write_u16(&writer, 9));
+    TEST_CHECK(dcf_ser_write_null(&writer));
+    TEST_CHECK(dcf_ser_write_u16(&writer, 9));
+    TEST_CHECK(dcf_ser_write_null(&writer));
+    TEST_ASSERT(dcf_ser_write_sorted_map_end(&writer) == DCF_SER_ERR_INVALID_ARG,
+                "duplicate key accepted");
+    dcf_ser_writer_reset(&writer, 0x0B02, DCF_SER_FLAG_NONE);
+    TEST_CHECK(dcf_ser_write_sorted_map_begin(&writer, DCF_TYPE_U16, DCF_TYPE_NULL, 2));
+    TEST_CHECK(dcf_ser_write_u16(&writer, 1));
+    TEST_CHECK(dcf_ser_write_null(&writer));
+    TEST_ASSERT(dcf_ser_write_sorted_map_end(&writer) == DCF_SER_ERR_MALFORMED,
+                "short sorted map accepted");
+    TEST_ASSERT(dcf_ser_write_sorted_map_begin(&writer, DCF_TYPE_F32, DCF_TYPE_NULL, 1) ==
+                DCF_SER_ERR_INVALID_ARG, "float keys accepted");
+    
+    dcf_ser_writer_destroy(&writer);
+    printf("  PASSED\n");
+    return 0;
+}
+
+static int test_table(void) {
+    printf("Testing tables...\n");
+    
+    DCFSerWriter writer;
+    TEST_CHECK(dcf_ser_writer_init(&writer, 0x0C00, DCF_SER_FLAG_NO_CRC));
+    TEST_CHECK(dcf_ser_write_table_begin(&writer, 77, 50));
+    TEST_CHECK(dcf_ser_write_table_field(&writer, 40));
+    TEST_CHECK(dcf_ser_write_string(&writer, "route-b"));
+    TEST_CHECK(dcf_ser_write_table_field(&writer, 1));
+    TEST_CHECK(dcf_ser_write_u64(&writer, 0xABCDEF));
+    TEST_CHECK(dcf_ser_write_table_field(&writer, 50));
+    TEST_CHECK(dcf_ser_write_table_begin(&writer, 78, 2));
+    TEST_CHECK(dcf_ser_write_table_field(&writer, 2));
+    TEST_CHECK(dcf_ser_write_i16(&writer, -3));
+    TEST_CHECK(dcf_ser_write_table_end(&writer));
+    TEST_ASSERT(dcf_ser_write_table_field(&writer, 1) == DCF_SER_ERR_INVALID_ARG,
+                "repeated field accepted");
+    TEST_ASSERT(dcf_ser_write_table_field(&writer, 51) == DCF_SER_ERR_INVALID_ARG,
+                "out-of-range field accepted");
+    TEST_CHECK(dcf_ser_write_table_field(&writer, 7));
+    TEST_CHECK(dcf_ser_write_bool(&writer, true));
+    TEST_CHECK(dcf_ser_write_table_end(&writer));
+    TEST_CHECK(dcf_ser_write_u8(&writer, 0x42));
+    
+    const uint8_t* data;
+    size_t len;
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    TEST_CHECK(dcf_ser_validate_structure(data, len, NULL));
+    
+    DCFSerReader reader, value, inner;
+    TEST_CHECK(dcf_ser_reader_init(&reader, data, len));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    
+    uint16_t type_id, max_field;
+    TEST_CHECK(dcf_ser_table_info(&reader, &type_id, &max_field));
+    TEST_ASSERT(type_id == 77 && max_field == 50, "wrong table info");
+    
+    const char* str;
+    size_t str_len;
+    TEST_CHECK(dcf_ser_table_field(&reader, 40, &value));
+    TEST_CHECK(dcf_ser_read_string(&value, &str, &str_len));
+    TEST_ASSERT(str_len == 7 && memcmp(str, "route-b", 7) == 0, "field 40 mismatch");
+    
+    uint64_t u64;
+    TEST_CHECK(dcf_ser_table_field(&reader, 1, &value));
+    TEST_CHECK(dcf_ser_read_u64(&value, &u64));
+    TEST_ASSERT(u64 == 0xABCDEF, "field 1 mismatch");
+    
+    int16_t i16;
+    TEST_CHECK(dcf_ser_table_field(&reader, 50, &value));
+    TEST_CHECK(dcf_ser_table_field(&value, 2, &inner));
+    TEST_CHECK(dcf_ser_read_i16(&inner, &i16));
+    TEST_ASSERT(i16 == -3, "nested table field mismatch");
+    TEST_ASSERT(dcf_ser_read_i16(&inner, &i16) == DCF_SER_ERR_TRUNCATED,
+                "field reader should stop at the table body");
+    
+    TEST_ASSERT(dcf_ser_table_field(&reader, 2, &value) == DCF_SER_ERR_NOT_FOUND,
+                "absent field found");
+    TEST_ASSERT(dcf_ser_table_field(&reader, 60, &value) == DCF_SER_ERR_NOT_FOUND,
+                "out-of-range field found");
+    
+    /* Skip over the whole table */
+    uint8_t u8;
+    TEST_CHECK(dcf_ser_reader_skip(&reader));
+    TEST_CHECK(dcf_ser_read_u8(&reader, &u8));
+    TEST_ASSERT(u8 == 0x42, "skip over table failed");
+    
+    /* Slots pointing outside the body are rejected */
+    uint8_t copy[512];
+    TEST_ASSERT(len <= sizeof(copy), "fixture too large");
+    memcpy(copy, data, len);
+    copy[sizeof(DCFSerHeader) + 9 + 6 * 4 + 3] = 1;   /* Slot of field 7 -> table header */
+    TEST_ASSERT(dcf_ser_validate_structure(copy, len, NULL) == DCF_SER_ERR_MALFORMED,
+                "bad slot offset accepted");
+    TEST_CHECK(dcf_ser_reader_init(&reader, copy, len));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    TEST_ASSERT(dcf_ser_table_field(&reader, 7, &value) == DCF_SER_ERR_MALFORMED,
+                "bad slot offset followed");
+    
+    /* So are slots pointing inside the body but not at a value start */
+    memcpy(copy, data, len);
+    copy[sizeof(DCFSerHeader) + 9 + 39 * 4 + 3] += 1;  /* Field 40 -> inside its string */
+    TEST_ASSERT(dcf_ser_validate_structure(copy, len, NULL) == DCF_SER_ERR_MALFORMED,
+                "mid-value slot offset accepted");
+    TEST_CHECK(dcf_ser_reader_init(&reader, copy, len));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    TEST_ASSERT(dcf_ser_reader_trust(&reader) == DCF_SER_ERR_MALFORMED,
+                "mid-value slot offset trusted");
+    
+    /* Every field needs exactly one closed value before the next */
+    dcf_ser_writer_reset(&writer, 0x0C01, DCF_SER_FLAG_NONE);
+    TEST_CHECK(dcf_ser_write_table_begin(&writer, 7, 3));
+    TEST_CHECK(dcf_ser_write_table_field(&writer, 1));
+    TEST_ASSERT(dcf_ser_write_table_field(&writer, 2) == DCF_SER_ERR_MALFORMED,
+                "field without a value accepted");
+    TEST_ASSERT(dcf_ser_write_table_end(&writer) == DCF_SER_ERR_MALFORMED,
+                "table ended with a field missing its value");
+    TEST_CHECK(dcf_ser_write_array_begin(&writer, DCF_TYPE_U8, 1));
+    TEST_ASSERT(dcf_ser_write_table_field(&writer, 2) == DCF_SER_ERR_MALFORMED,
+                "field accepted inside an open array");
+    TEST_CHECK(dcf_ser_write_u8(&writer, 1));
+    TEST_CHECK(dcf_ser_write_array_end(&writer));
+    TEST_CHECK(dcf_ser_write_table_field(&writer, 2));
+    TEST_CHECK(dcf_ser_write_u32(&writer, 42));
+    TEST_CHECK(dcf_ser_write_table_end(&writer));
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    TEST_CHECK(dcf_ser_validate_structure(data, len, NULL));
+    
+    dcf_ser_writer_destroy(&writer);
+    printf("  PASSED\n");
+    return 0;
+}
+
+typedef struct {
+    uint64_t order_id;
+    int64_t  price;
+    uint32_t qty;
+    bool     buy;
+    char     symbol[8];
+    uint64_t sent_at;
+} TestOrder;
+
+static const DCFSerField test_order_fields[] = {
+    DCF_SER_FIELD_DEF(TestOrder, order_id, DCF_TYPE_U64, 1),
+    DCF_SER_FIELD_DEF(TestOrder, price, DCF_TYPE_I64, 2),
+    DCF_SER_FIELD_DEF(TestOrder, qty, DCF_TYPE_U32, 3),
+    DCF_SER_FIELD_DEF(TestOrder, buy, DCF_TYPE_BOOL, 4),
+    DCF_SER_FIELD_DEF(TestOrder, symbol, DCF_TYPE_BYTES, 5),
+    DCF_SER_FIELD_DEF(TestOrder, sent_at, DCF_TYPE_TIMESTAMP, 6),
+};
+
+static const DCFSerSchema test_order_schema = {
+    .name = "TestOrder",
+    .type_id = 0x0300,
+    .fields = test_order_fields,
+    .field_count = sizeof(test_order_fields) / sizeof(test_order_fields[0]),
+    .struct_size = sizeof(TestOrder),
+};
+
+static int test_flyweight(void) {
+    printf("Testing flyweight layouts...\n");
+    
+    DCFSerLayout layout;
+    TEST_CHECK(dcf_ser_layout_compile(&layout, &test_order_schema));
+    TEST_ASSERT(layout.block_size == 8 + 8 + 4 + 1 + 8 + 8, "wrong block size");
+    uint32_t qty_off, price_off;
+    TEST_CHECK(dcf_ser_layout_offset(&layout, 3, &qty_off));
+    TEST_CHECK(dcf_ser_layout_offset(&layout, 2, &price_off));
+    TEST_ASSERT(qty_off == 16 && price_off == 8, "wrong field offsets");
+    TEST_ASSERT(dcf_ser_layout_offset(&layout, 9, &qty_off) == DCF_SER_ERR_NOT_FOUND,
+                "unknown field has an offset");
+    
+    /* Exactly-sized external buffer */
+    uint8_t buf[128];
+    TEST_ASSERT(layout.message_size <= sizeof(buf), "layout message too large");
+    DCFSerWriterOptions opts = { .buffer = buf, .capacity = layout.message_size };
+    DCFSerWriter writer;
+    TEST_CHECK(dcf_ser_writer_init_ex(&writer, 0x0D00, DCF_SER_FLAG_NONE, &opts));
+    
+    TestOrder order = { 9001, -125050, 300, true, "ACME", 1704153600000000ULL };
+    TEST_CHECK(dcf_ser_write_flyweight(&writer, &layout, &order));
+    
+    const uint8_t* data;
+    size_t len;
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    TEST_ASSERT(len == layout.message_size, "message size differs from layout");
+    
+    /* Standard header and CRC */
+    DCFSerReader reader;
+    TEST_CHECK(dcf_ser_reader_init(&reader, data, len));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    TEST_CHECK(dcf_ser_validate_structure(data, len, NULL));
+    
+    const uint8_t* block;
+    TEST_CHECK(dcf_ser_read_flyweight(&reader, &layout, &block));
+    TEST_ASSERT(dcf_ser_fly_get_u32(block, qty_off) == 300, "in-place qty mismatch");
+    TEST_ASSERT(dcf_ser_fly_get_i64(block, price_off) == -125050, "in-place price mismatch");
+    TEST_ASSERT(dcf_ser_reader_at_end(&reader), "reader not at end");
+    
+    TestOrder decoded;
+    memset(&decoded, 0, sizeof(decoded));
+    TEST_CHECK(dcf_ser_flyweight_decode(&layout, block, &decoded));
+    TEST_ASSERT(decoded.order_id == 9001 && decoded.price == -125050 && decoded.qty == 300 &&
+                decoded.buy && memcmp(decoded.symbol, "ACME", 5) == 0 &&
+                decoded.sent_at == order.sent_at, "decoded order mismatch");
+    
+    /* In-place stores into a reserved block */
+    dcf_ser_writer_reset(&writer, 0x0D01, DCF_SER_FLAG_NONE);
+    uint8_t* out;
+    TEST_CHECK(dcf_ser_write_flyweight_begin(&writer, &layout, &out));
+    dcf_ser_fly_set_u32(out, qty_off, 42);
+    dcf_ser_fly_set_i64(out, price_off, 7);
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    TEST_CHECK(dcf_ser_reader_init(&reader, data, len));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    TEST_CHECK(dcf_ser_read_flyweight(&reader, &layout, &block));
+    TEST_CHECK(dcf_ser_flyweight_decode(&layout, block, &decoded));
+    TEST_ASSERT(decoded.qty == 42 && decoded.price == 7 && decoded.order_id == 0,
+                "in-place stores mismatch");
+    
+    /* Other layouts are refused */
+    TEST_CHECK(dcf_ser_reader_init(&reader, data, len));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    DCFSerLayout other;
+    TEST_CHECK(dcf_ser_layout_compile(&other, &test_record_schema));
+    TEST_ASSERT(dcf_ser_read_flyweight(&reader, &other, &block) == DCF_SER_ERR_TYPE_MISMATCH,
+                "foreign layout accepted");
+    dcf_ser_layout_destroy(&other);
+    
+    static const DCFSerField bad_fields[] = { { "name", 1, DCF_TYPE_STRING, 0, 0, sizeof(char*), NULL } };
+    static const DCFSerSchema bad_schema = { "Bad", 1, bad_fields, 1, sizeof(char*) };
+    TEST_ASSERT(dcf_ser_layout_compile(&other, &bad_schema) == DCF_SER_ERR_INVALID_TYPE,
+                "variable-length field compiled");
+    
+    dcf_ser_writer_destroy(&writer);
+    dcf_ser_layout_destroy(&layout);
+    printf("  PASSED\n");
+    return 0;
+}
+
+typedef struct {
+    uint32_t    id;
+    uint64_t    visits;
+    const char* name;
+    uint16_t    level;
+    int64_t     balance;
+    double      rating;
+} TestProfile;
+
+static const DCFSerField test_profile_fields[] = {
+    DCF_SER_FIELD_DEF(TestProfile, id, DCF_TYPE_U32, 1),
+    DCF_SER_FIELD_DEF(TestProfile, visits, DCF_TYPE_U64, 2),
+    DCF_SER_FIELD_DEF(TestProfile, name, DCF_TYPE_STRING, 3),
+    DCF_SER_FIELD_OPT(TestProfile, level, DCF_TYPE_U16, 4),
+    DCF_SER_FIELD_OPT(TestProfile, balance, DCF_TYPE_I64, 5),
+    DCF_SER_FIELD_OPT(TestProfile, rating, DCF_TYPE_F64, 6),
+};
+
+static const DCFSerSchema test_profile_schema = {
+    .name = "TestProfile",
+    .type_id = 0x0E00,
+    .fields = test_profile_fields,
+    .field_count = 6,
+    .struct_size = sizeof(TestProfile),
+};
+
+typedef struct {
+    uint8_t a;
+    uint8_t b[2];
+} TestBlob;
+
+/* Same type id as TestPair but with a member the tagless codec cannot carry */
+static const DCFSerField test_pair_fields[] = {
+    { "a", 1, DCF_TYPE_U8, DCF_FIELD_REQUIRED, offsetof(TestBlob, a), 1, NULL },
+    { "b", 2, DCF_TYPE_U8, DCF_FIELD_REQUIRED, offsetof(TestBlob, b), 1, NULL },
+};
+static const DCFSerField test_blob_fields[] = {
+    { "a", 1, DCF_TYPE_U8, DCF_FIELD_REQUIRED, offsetof(TestBlob, a), 1, NULL },
+    { "b", 2, DCF_TYPE_BYTES, DCF_FIELD_REQUIRED, offsetof(TestBlob, b), 2, NULL },
+};
+static const DCFSerSchema test_pair_schema = { "TestPair", 0x0E02, test_pair_fields, 2, sizeof(TestBlob) };
+static const DCFSerSchema test_blob_schema = { "TestBlob", 0x0E02, test_blob_fields, 2, sizeof(TestBlob) };
+
+static int test_compact_struct(void) {
+    printf("Testing compact structs...\n");
+    
+    TestProfile profile = { 77, 300, "ada", 0, -5000, 0.0 };
+    
+    DCFSerWriter tagged;
+    TEST_CHECK(dcf_ser_writer_init(&tagged, 0x0E00, DCF_SER_FLAG_NONE));
+    TEST_CHECK(dcf_ser_write_struct_schema(&tagged, &profile, &test_profile_schema));
+    const uint8_t* data;
+    size_t tagged_len;
+    TEST_CHECK(dcf_ser_writer_finish(&tagged, &data, &tagged_len));
+    
+    DCFSerWriter writer;
+    TEST_CHECK(dcf_ser_writer_init(&writer, 0x0E00, DCF_SER_FLAG_NONE));
+    TEST_CHECK(dcf_ser_write_struct_compact(&writer, &profile, &test_profile_schema));
+    TEST_CHECK(dcf_ser_write_u8(&writer, 0xAB));
+    size_t len;
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    TEST_ASSERT(len + 20 < tagged_len, "compact struct not smaller than tagged");
+    
+    DCFSerReader reader;
+    TEST_CHECK(dcf_ser_reader_init(&reader, data, len));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    TEST_CHECK(dcf_ser_validate_structure(data, len, NULL));
+    TEST_ASSERT(dcf_ser_reader_peek_type(&reader) == DCF_TYPE_COMPACT_STRUCT, "wrong tag");
+    
+    TestProfile decoded;
+    memset(&decoded, 0xFF, sizeof(decoded));
+    TEST_CHECK(dcf_ser_read_struct_compact(&reader, &decoded, &test_profile_schema));
+    TEST_ASSERT(decoded.id == 77 && decoded.visits == 300 && decoded.name == NULL &&
+                decoded.level == 0 && decoded.balance == -5000 && decoded.rating == 0.0,
+                "compact round trip mismatch");
+    uint8_t tail;
+    TEST_CHECK(dcf_ser_read_u8(&reader, &tail));
+    TEST_ASSERT(tail == 0xAB, "value after compact struct misread");
+    
+    /* Skippable without the schema */
+    TEST_CHECK(dcf_ser_reader_init(&reader, data, len));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    TEST_CHECK(dcf_ser_reader_skip(&reader));
+    TEST_CHECK(dcf_ser_read_u8(&reader, &tail));
+    TEST_ASSERT(tail == 0xAB, "skip misplaced reader");
+    
+    /* Other type ids are refused */
+    static const DCFSerSchema other = { "Other", 0x0E01, test_profile_fields, 6, sizeof(TestProfile) };
+    TEST_CHECK(dcf_ser_reader_init(&reader, data, len));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    TEST_ASSERT(dcf_ser_read_struct_compact(&reader, &decoded, &other) == DCF_SER_ERR_TYPE_MISMATCH,
+                "foreign compact struct accepted");
+    
+    /* Extensions, read one and skip the rest */
+    dcf_ser_writer_reset(&writer, 0x0E00, DCF_SER_FLAG_NONE);
+    TEST_CHECK(dcf_ser_write_compact_struct_begin(&writer, &profile, &test_profile_schema));
+    TEST_CHECK(dcf_ser_write_compact_ext(&writer, 40));
+    TEST_CHECK(dcf_ser_write_u32(&writer, 4040));
+    TEST_CHECK(dcf_ser_write_compact_ext(&writer, 41));
+    TEST_CHECK(dcf_ser_write_array_begin(&writer, DCF_TYPE_U8, 2));
+    TEST_CHECK(dcf_ser_write_u8(&writer, 1));
+    TEST_CHECK(dcf_ser_write_u8(&writer, 2));
+    TEST_CHECK(dcf_ser_write_array_end(&writer));
+    TEST_CHECK(dcf_ser_write_compact_struct_end(&writer));
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    TEST_CHECK(dcf_ser_validate_structure(data, len, NULL));
+    
+    TEST_CHECK(dcf_ser_reader_init(&reader, data, len));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    TEST_CHECK(dcf_ser_read_compact_struct_begin(&reader, &decoded, &test_profile_schema));
+    uint16_t ext_id;
+    uint32_t ext_val;
+    TEST_CHECK(dcf_ser_read_compact_ext(&reader, &ext_id));
+    TEST_CHECK(dcf_ser_read_u32(&reader, &ext_val));
+    TEST_ASSERT(ext_id == 40 && ext_val == 4040, "extension mismatch");
+    TEST_CHECK(dcf_ser_read_compact_struct_end(&reader));
+    TEST_ASSERT(dcf_ser_reader_at_end(&reader), "extensions not skipped");
+    
+    /* Extensions are bounded by the declared body length */
+    dcf_ser_writer_reset(&writer, 0x0E00, DCF_SER_FLAG_NO_CRC);
+    TEST_CHECK(dcf_ser_write_compact_struct_begin(&writer, &profile, &test_profile_schema));
+    TEST_CHECK(dcf_ser_write_compact_ext(&writer, 40));
+    TEST_CHECK(dcf_ser_write_u32(&writer, 4040));
+    TEST_CHECK(dcf_ser_write_compact_struct_end(&writer));
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    uint8_t shrunk[256];
+    TEST_ASSERT(len <= sizeof(shrunk), "compact message too large");
+    memcpy(shrunk, data, len);
+    uint8_t* body_len = shrunk + sizeof(DCFSerHeader) + 3;
+    uint32_t declared = ((uint32_t)body_len[0] << 24) | ((uint32_t)body_len[1] << 16) |
+                        ((uint32_t)body_len[2] << 8) | body_len[3];
+    declared -= 6;
+    body_len[0] = (uint8_t)(declared >> 24);
+    body_len[1] = (uint8_t)(declared >> 16);
+    body_len[2] = (uint8_t)(declared >> 8);
+    body_len[3] = (uint8_t)declared;
+    TEST_CHECK(dcf_ser_reader_init(&reader, shrunk, len));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    TEST_ASSERT(dcf_ser_read_struct_compact(&reader, &decoded, &test_profile_schema) ==
+                DCF_SER_ERR_MALFORMED, "extension past the compact body accepted");
+    
+    /* Older reader (schema prefix) skips fields it does not know */
+    static const DCFSerSchema older = { "TestProfile", 0x0E00, test_profile_fields, 4, sizeof(TestProfile) };
+    TEST_CHECK(dcf_ser_reader_init(&reader, data, len));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    TEST_CHECK(dcf_ser_read_struct_compact(&reader, &decoded, &older));
+    TEST_ASSERT(decoded.id == 77 && decoded.balance == 0, "older schema decode mismatch");
+    TEST_ASSERT(dcf_ser_reader_at_end(&reader), "older reader not at end");
+    
+    /* Newer reader leaves fields an older writer lacked zeroed */
+    dcf_ser_writer_reset(&writer, 0x0E00, DCF_SER_FLAG_NONE);
+    TEST_CHECK(dcf_ser_write_struct_compact(&writer, &profile, &older));
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    TEST_CHECK(dcf_ser_reader_init(&reader, data, len));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    memset(&decoded, 0xFF, sizeof(decoded));
+    TEST_CHECK(dcf_ser_read_struct_compact(&reader, &decoded, &test_profile_schema));
+    TEST_ASSERT(decoded.visits == 300 && decoded.balance == 0, "newer schema decode mismatch");
+    
+    /* Schemas with untaggable members are refused on both sides */
+    TestBlob blob = { 1, { 2, 3 } };
+    dcf_ser_writer_reset(&writer, 0x0E00, DCF_SER_FLAG_NONE);
+    TEST_ASSERT(dcf_ser_write_struct_compact(&writer, &blob, &test_blob_schema) ==
+                DCF_SER_ERR_INVALID_TYPE, "compact BYTES field written");
+    dcf_ser_writer_reset(&writer, 0x0E00, DCF_SER_FLAG_NONE);
+    TEST_CHECK(dcf_ser_write_struct_compact(&writer, &blob, &test_pair_schema));
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    TEST_CHECK(dcf_ser_reader_init(&reader, data, len));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    TestBlob* heap_blob = malloc(sizeof(TestBlob));
+    TEST_ASSERT(heap_blob != NULL, "allocation failed");
+    DCFSerError blob_err = dcf_ser_read_struct_compact(&reader, heap_blob, &test_blob_schema);
+    free(heap_blob);
+    TEST_ASSERT(blob_err == DCF_SER_ERR_INVALID_TYPE, "compact BYTES field decoded");
+    
+    dcf_ser_writer_destroy(&writer);
+    dcf_ser_writer_destroy(&tagged);
+    printf("  PASSED\n");
+    return 0;
+}
+
+static int test_tagless(void) {
+    printf("Testing fingerprinted tagless structs...\n");
+    
+    TestRecord record = { 12345, true, 98.5f, 1704153600000000ULL };
+    uint64_t fp = dcf_ser_schema_fingerprint(&test_record_schema);
+    TEST_ASSERT(fp != 0 && fp != dcf_ser_schema_fingerprint(&test_profile_schema),
+                "fingerprints collide");
+    
+    DCFSerRegistry reg;
+    TEST_CHECK(dcf_ser_registry_init(&reg));
+    TEST_CHECK(dcf_ser_registry_add(&reg, &test_record_schema));
+    TEST_CHECK(dcf_ser_registry_add(&reg, &test_record_schema));
+    TEST_ASSERT(dcf_ser_registry_count(&reg) == 1, "duplicate registration");
+    TEST_ASSERT(dcf_ser_registry_find(&reg, fp) == &test_record_schema, "lookup failed");
+    
+    /* Peer knows the schema: tagless; unknown peer: self-describing */
+    DCFSerWriter writer;
+    TEST_CHECK(dcf_ser_writer_init(&writer, 0x0F00, DCF_SER_FLAG_NONE));
+    size_t start = writer.position;
+    TEST_CHECK(dcf_ser_write_struct_negotiated(&writer, &record, &test_record_schema, &reg));
+    size_t tagless_len = writer.position - start;
+    start = writer.position;
+    TEST_CHECK(dcf_ser_write_struct_negotiated(&writer, &record, &test_record_schema, NULL));
+    size_t tagged_len = writer.position - start;
+    TEST_ASSERT(tagless_len < tagged_len, "tagless struct not smaller");
+    TestProfile profile = { 7, 1, "ada", 0, 0, 0.0 };
+    TEST_CHECK(dcf_ser_write_struct_tagless(&writer, &profile, &test_profile_schema));
+    
+    const uint8_t* data;
+    size_t len;
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    TEST_CHECK(dcf_ser_validate_structure(data, len, NULL));
+    
+    DCFSerReader reader;
+    TEST_CHECK(dcf_ser_reader_init(&reader, data, len));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    TEST_ASSERT(dcf_ser_reader_peek_type(&reader) == DCF_TYPE_SCHEMA_REF, "wrong tag");
+    
+    for (int i = 0; i < 2; i++) {
+        TestRecord decoded;
+        const DCFSerSchema* used = NULL;
+        memset(&decoded, 0xFF, sizeof(decoded));
+        TEST_CHECK(dcf_ser_read_struct_registered(&reader, &reg, &decoded, &used));
+        TEST_ASSERT(used == &test_record_schema, "wrong schema resolved");
+        TEST_ASSERT(decoded.id == 12345 && decoded.active && decoded.score == 98.5f &&
+                    decoded.timestamp == record.timestamp, "registered decode mismatch");
+    }
+    
+    /* Unregistered fingerprint: nothing consumed, value skippable */
+    TestProfile scratch;
+    size_t before = reader.position;
+    TEST_ASSERT(dcf_ser_read_struct_registered(&reader, &reg, &scratch, NULL) == DCF_SER_ERR_NOT_FOUND,
+                "unknown fingerprint decoded");
+    TEST_ASSERT(reader.position == before, "unknown fingerprint consumed");
+    TEST_ASSERT(dcf_ser_read_struct_tagless(&reader, &scratch, &test_record_schema) ==
+                DCF_SER_ERR_TYPE_MISMATCH, "foreign fingerprint accepted");
+    TEST_CHECK(dcf_ser_reader_skip(&reader));
+    TEST_ASSERT(dcf_ser_reader_at_end(&reader), "reader not at end");
+    
+    /* Direct decode with the known schema */
+    TEST_CHECK(dcf_ser_reader_init(&reader, data, len));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    TestRecord direct;
+    TEST_CHECK(dcf_ser_read_struct_tagless(&reader, &direct, &test_record_schema));
+    TEST_ASSERT(direct.id == 12345, "tagless decode mismatch");
+    
+    /* A forged reference to a schema with a BYTES member is refused */
+    TestBlob blob = { 1, { 2, 3 } };
+    dcf_ser_writer_reset(&writer, 0x0F00, DCF_SER_FLAG_NO_CRC);
+    TEST_CHECK(dcf_ser_write_struct_tagless(&writer, &blob, &test_pair_schema));
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    uint8_t forged[64];
+    TEST_ASSERT(len <= sizeof(forged), "test message too large");
+    memcpy(forged, data, len);
+    uint64_t blob_fp = dcf_ser_schema_fingerprint(&test_blob_schema);
+    for (int i = 0; i < 8; i++) {
+        forged[sizeof(DCFSerHeader) + 1 + i] = (uint8_t)(blob_fp >> (56 - 8 * i));
+    }
+    TEST_CHECK(dcf_ser_registry_add(&reg, &test_blob_schema));
+    TEST_CHECK(dcf_ser_reader_init(&reader, forged, len));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    TEST_ASSERT(dcf_ser_read_struct_tagless(&reader, &blob, &test_blob_schema) ==
+                DCF_SER_ERR_INVALID_TYPE, "tagless BYTES field decoded");
+    TEST_ASSERT(dcf_ser_read_struct_registered(&reader, &reg, &blob, NULL) ==
+                DCF_SER_ERR_INVALID_TYPE, "registered BYTES field decoded");
+    
+    dcf_ser_writer_destroy(&writer);
+    dcf_ser_registry_destroy(&reg);
+    printf("  PASSED\n");
+    return 0;
+}
+
+static const DCFSerField test_record_v2_fields[] = {
+    DCF_SER_FIELD_DEF(TestRecord, id, DCF_TYPE_U32, 1),
+    DCF_SER_FIELD_DEF(TestRecord, score, DCF_TYPE_F32, 3),
+    DCF_SER_FIELD_DEF(TestRecord, timestamp, DCF_TYPE_TIMESTAMP, 4),
+};
+
+static const DCFSerSchema test_record_v2_schema = {
+    .name = "TestRecord",
+    .type_id = 0x0200,
+    .fields = test_record_v2_fields,
+    .field_count = 3,
+    .struct_size = sizeof(TestRecord),
+};
+
+#ifdef DCF_SER_PLATFORM_POSIX
+typedef struct {
+    DCFSerRegistry* reg;
+    volatile bool*  stop;
+    size_t          misses;
+} RegistryReader;
+
+static void* registry_reader_thread(void* arg) {
+    RegistryReader* rr = arg;
+    while (!*rr->stop) {
+        const DCFSerSchema* s = dcf_ser_registry_find_type(rr->reg, 0x0200);
+        if (s != &test_record_schema && s != &test_record_v2_schema) rr->misses++;
+    }
+    return NULL;
+}
+#endif
+
+static int test_registry(void) {
+    printf("Testing schema registry...\n");
+    
+    /* Many types, looked up by type id */
+    static DCFSerSchema types[300];
+    DCFSerRegistry reg;
+    TEST_CHECK(dcf_ser_registry_init(&reg));
+    for (size_t i = 0; i < 300; i++) {
+        types[i] = test_record_schema;
+        types[i].type_id = (uint16_t)(0x4000 + i);
+        TEST_CHECK(dcf_ser_registry_add(&reg, &types[i]));
+    }
+    for (size_t i = 0; i < 300; i++) {
+        TEST_ASSERT(dcf_ser_registry_find_type(&reg, (uint16_t)(0x4000 + i)) == &types[i],
+                    "type lookup mismatch");
+        TEST_ASSERT(dcf_ser_registry_find(&reg, dcf_ser_schema_fingerprint(&types[i])) == &types[i],
+                    "fingerprint lookup mismatch");
+    }
+    TEST_ASSERT(dcf_ser_registry_find_type(&reg, 0x0200) == NULL, "unregistered type found");
+    
+    /* New versions take over the type id; old ones stay reachable */
+    TEST_CHECK(dcf_ser_registry_add(&reg, &test_record_schema));
+    TEST_CHECK(dcf_ser_registry_add(&reg, &test_record_v2_schema));
+    TEST_ASSERT(dcf_ser_registry_find_type(&reg, 0x0200) == &test_record_v2_schema,
+                "newest version not current");
+    TEST_ASSERT(dcf_ser_registry_find(&reg, dcf_ser_schema_fingerprint(&test_record_schema)) ==
+                &test_record_schema, "old version lost");
+    TEST_CHECK(dcf_ser_registry_add(&reg, &test_record_schema));   /* Roll back */
+    TEST_ASSERT(dcf_ser_registry_find_type(&reg, 0x0200) == &test_record_schema, "rollback failed");
+    TEST_ASSERT(dcf_ser_registry_count(&reg) == 302, "wrong version count");
+    dcf_ser_registry_reclaim(&reg);
+    
+    /* Self-describing structs resolve to the current version */
+    DCFSerWriter writer;
+    TEST_CHECK(dcf_ser_writer_init(&writer, 0x0F01, DCF_SER_FLAG_NONE));
+    TestRecord record = { 5, true, 1.5f, 99 };
+    TEST_CHECK(dcf_ser_write_struct_schema(&writer, &record, &test_record_schema));
+    const uint8_t* data;
+    size_t len;
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    DCFSerReader reader;
+    TEST_CHECK(dcf_ser_reader_init(&reader, data, len));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    TestRecord decoded;
+    const DCFSerSchema* used;
+    TEST_CHECK(dcf_ser_read_struct_registered(&reader, &reg, &decoded, &used));
+    TEST_ASSERT(used == &test_record_schema && decoded.id == 5 && decoded.timestamp == 99,
+                "registered struct decode mismatch");
+    dcf_ser_writer_destroy(&writer);
+    
+#ifdef DCF_SER_PLATFORM_POSIX
+    /* Lookups race with republication */
+    volatile bool stop = false;
+    RegistryReader readers[4];
+    pthread_t tids[4];
+    for (int i = 0; i < 4; i++) {
+        readers[i] = (RegistryReader){ &reg, &stop, 0 };
+        TEST_ASSERT(pthread_create(&tids[i], NULL, registry_reader_thread, &readers[i]) == 0,
+                    "thread start failed");
+    }
+    for (int i = 0; i < 200; i++) {
+        TEST_CHECK(dcf_ser_registry_add(&reg, i % 2 ? &test_record_schema : &test_record_v2_schema));
+    }
+    stop = true;
+    for (int i = 0; i < 4; i++) {
+        pthread_join(tids[i], NULL);
+        TEST_ASSERT(readers[i].misses == 0, "lookup saw no schema during publication");
+    }
+    dcf_ser_registry_reclaim(&reg);
+#endif
+    
+    /* The global registry starts empty */
+    TEST_ASSERT(dcf_ser_registry_find_type(dcf_ser_registry_global(), 0x0200) == NULL,
+                "global registry not empty");
+    
+    dcf_ser_registry_destroy(&reg);
+    printf("  PASSED\n");
+    return 0;
+}
+
+typedef struct {
+    uint16_t id;
+    uint32_t legacy;
+    float    score;
+    int16_t  delta;
+} TestEventV1;
+
+typedef struct {
+    uint8_t  region;
+    uint32_t id;
+    double   score;
+    int64_t  delta;
+} TestEventV2;
+
+static const DCFSerField test_event_v1_fields[] = {
+    DCF_SER_FIELD_DEF(TestEventV1, id, DCF_TYPE_U16, 1),
+    DCF_SER_FIELD_DEF(TestEventV1, legacy, DCF_TYPE_U32, 2),
+    DCF_SER_FIELD_DEF(TestEventV1, score, DCF_TYPE_F32, 3),
+    DCF_SER_FIELD_DEF(TestEventV1, delta, DCF_TYPE_I16, 4),
+};
+
+static const DCFSerField test_event_v2_fields[] = {
+    DCF_SER_FIELD_DEF(TestEventV2, region, DCF_TYPE_U8, 5),
+    DCF_SER_FIELD_DEF(TestEventV2, id, DCF_TYPE_U32, 1),
+    DCF_SER_FIELD_DEF(TestEventV2, score, DCF_TYPE_F64, 3),
+    DCF_SER_FIELD_DEF(TestEventV2, delta, DCF_TYPE_I64, 4),
+};
+
+static const DCFSerSchema test_event_v1_schema = {
+    "TestEvent", 0x0310, test_event_v1_fields, 4, sizeof(TestEventV1)
+};
+
+static const DCFSerSchema test_event_v2_schema = {
+    "TestEvent", 0x0310, test_event_v2_fields, 4, sizeof(TestEventV2)
+};
+
+static int test_schema_plan(void) {
+    printf("Testing schema evolution plans...\n");
+    
+    DCFSerPlan plan;
+    TEST_CHECK(dcf_ser_schema_resolve(&plan, &test_event_v1_schema, &test_event_v2_schema));
+    TEST_ASSERT(plan.steps[1].target == -1, "removed field not skipped");
+    
+    /* Narrowing cannot be planned */
+    DCFSerPlan narrow;
+    TEST_ASSERT(dcf_ser_schema_resolve(&narrow, &test_event_v2_schema, &test_event_v1_schema) ==
+                DCF_SER_ERR_TYPE_MISMATCH, "narrowing plan accepted");
+    
+    /* Old producer, both encodings */
+    TestEventV1 old = { 4242, 77, 2.5f, -300 };
+    DCFSerWriter writer;
+    TEST_CHECK(dcf_ser_writer_init(&writer, 0x0F02, DCF_SER_FLAG_NONE));
+    TEST_CHECK(dcf_ser_write_struct_tagless(&writer, &old, &test_event_v1_schema));
+    TEST_CHECK(dcf_ser_write_struct_schema(&writer, &old, &test_event_v1_schema));
+    TestRecord other = { 1, false, 0.0f, 0 };
+    TEST_CHECK(dcf_ser_write_struct_tagless(&writer, &other, &test_record_schema));
+    const uint8_t* data;
+    size_t len;
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    
+    DCFSerReader reader;
+    TEST_CHECK(dcf_ser_reader_init(&reader, data, len));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    for (int i = 0; i < 2; i++) {
+        TestEventV2 ev;
+        memset(&ev, 0xFF, sizeof(ev));
+        TEST_CHECK(dcf_ser_read_struct_plan(&reader, &ev, &plan));
+        TEST_ASSERT(ev.id == 4242 && ev.score == 2.5 && ev.delta == -300 && ev.region == 0,
+                    "planned decode mismatch");
+    }
+    
+    /* Values from other schemas are refused and left in place */
+    TestEventV2 ev;
+    TEST_ASSERT(dcf_ser_read_struct_plan(&reader, &ev, &plan) == DCF_SER_ERR_TYPE_MISMATCH,
+                "foreign fingerprint accepted");
+    TEST_CHECK(dcf_ser_reader_skip(&reader));
+    TEST_ASSERT(dcf_ser_reader_at_end(&reader), "reader not at end");
+    
+    /* Same-version plans are plain copies */
+    DCFSerPlan same;
+    TEST_CHECK(dcf_ser_schema_resolve(&same, &test_event_v1_schema, &test_event_v1_schema));
+    TEST_CHECK(dcf_ser_reader_init(&reader, data, len));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    TestEventV1 copy;
+    TEST_CHECK(dcf_ser_read_struct_plan(&reader, &copy, &same));
+    TEST_ASSERT(copy.id == 4242 && copy.legacy == 77 && copy.delta == -300, "copy plan mismatch");
+    
+    dcf_ser_plan_destroy(&same);
+    dcf_ser_plan_destroy(&plan);
+    dcf_ser_writer_destroy(&writer);
+    printf("  PASSED\n");
+    return 0;
+}
+
+typedef struct {
+    uint32_t    code;
+    uint8_t     level;
+    bool        enabled;
+    const char* note;
+    int64_t     retries;
+} TestStatus;
+
+static const uint32_t test_status_code_default = 200;
+static const bool test_status_enabled_default = true;
+
+static const DCFSerField test_status_fields[] = {
+    DCF_SER_FIELD_DEFAULT(TestStatus, code, DCF_TYPE_U32, 1, &test_status_code_default),
+    DCF_SER_FIELD_DEFAULT(TestStatus, level, DCF_TYPE_U8, 2, NULL),
+    DCF_SER_FIELD_DEFAULT(TestStatus, enabled, DCF_TYPE_BOOL, 3, &test_status_enabled_default),
+    DCF_SER_FIELD_DEFAULT(TestStatus, note, DCF_TYPE_STRING, 4, "none"),
+    DCF_SER_FIELD_DEF(TestStatus, retries, DCF_TYPE_I64, 5),
+};
+
+static const DCFSerSchema test_status_schema = {
+    "TestStatus", 0x0320, test_status_fields, 5, sizeof(TestStatus)
+};
+
+static int test_default_elision(void) {
+    printf("Testing default-value elision...\n");
+    
+    TestStatus typical = { 200, 0, true, "none", 3 };
+    TestStatus unusual = { 503, 2, false, "overloaded", 0 };
+    
+    DCFSerWriter writer;
+    TEST_CHECK(dcf_ser_writer_init(&writer, 0x0F03, DCF_SER_FLAG_NONE));
+    size_t start = writer.position;
+    TEST_CHECK(dcf_ser_write_struct_schema(&writer, &typical, &test_status_schema));
+    size_t typical_len = writer.position - start;
+    start = writer.position;
+    TEST_CHECK(dcf_ser_write_struct_schema(&writer, &unusual, &test_status_schema));
+    size_t unusual_len = writer.position - start;
+    TEST_ASSERT(typical_len == 3 + 3 + 9 + 3, "defaults not elided");  /* struct, retries, end */
+    TEST_ASSERT(unusual_len > typical_len, "non-defaults elided");
+    TEST_CHECK(dcf_ser_write_struct_compact(&writer, &typical, &test_status_schema));
+    
+    const uint8_t* data;
+    size_t len;
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    
+    DCFSerReader reader;
+    TEST_CHECK(dcf_ser_reader_init(&reader, data, len));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    TestStatus decoded;
+    TEST_CHECK(dcf_ser_read_struct_schema(&reader, &decoded, &test_status_schema));
+    TEST_ASSERT(decoded.code == 200 && decoded.level == 0 && decoded.enabled &&
+                decoded.retries == 3, "defaults not restored");
+    TEST_CHECK(dcf_ser_read_struct_schema(&reader, &decoded, &test_status_schema));
+    TEST_ASSERT(decoded.code == 503 && decoded.level == 2 && !decoded.enabled,
+                "explicit values lost");
+    
+    /* Compact structs leave defaults out of the bitmap too */
+    memset(&decoded, 0, sizeof(decoded));
+    TEST_CHECK(dcf_ser_read_struct_compact(&reader, &decoded, &test_status_schema));
+    TEST_ASSERT(decoded.code == 200 && decoded.enabled && decoded.retries == 3,
+                "compact defaults not restored");
+    TEST_ASSERT(dcf_ser_reader_at_end(&reader), "reader not at end");
+    
+    /* Plans fill reader-only fields from the default image */
+    DCFSerPlan plan;
+    static const DCFSerSchema narrow = { "TestStatus", 0x0320, &test_status_fields[4], 1,
+                                         sizeof(TestStatus) };
+    TEST_CHECK(dcf_ser_schema_resolve(&plan, &narrow, &test_status_schema));
+    TEST_ASSERT(((const TestStatus*)plan.defaults)->code == 200, "plan default image empty");
+    dcf_ser_plan_destroy(&plan);
+    
+    dcf_ser_writer_destroy(&writer);
+    printf("  PASSED\n");
+    return 0;
+}
+
+static int test_projected(void) {
+    printf("Testing projected decoding...\n");
+    
+    TestRecord record = { 777, true, 4.25f, 1704153600000000ULL };
+    uint64_t mask = (1u << 0) | (1u << 3);     /* id, timestamp */
+    
+    DCFSerWriter writer;
+    TEST_CHECK(dcf_ser_writer_init(&writer, 0x0F04, DCF_SER_FLAG_NONE));
+    TEST_CHECK(dcf_ser_write_struct_schema(&writer, &record, &test_record_schema));
+    TEST_CHECK(dcf_ser_write_struct_tagless(&writer, &record, &test_record_schema));
+    TEST_CHECK(dcf_ser_write_table_begin(&writer, test_record_schema.type_id, 4));
+    TEST_CHECK(dcf_ser_write_table_field(&writer, 4));
+    TEST_CHECK(dcf_ser_write_timestamp(&writer, record.timestamp));
+    TEST_CHECK(dcf_ser_write_table_field(&writer, 1));
+    TEST_CHECK(dcf_ser_write_u32(&writer, record.id));
+    TEST_CHECK(dcf_ser_write_table_field(&writer, 3));
+    TEST_CHECK(dcf_ser_write_f32(&writer, record.score));
+    TEST_CHECK(dcf_ser_write_table_end(&writer));
+    TEST_CHECK(dcf_ser_write_u8(&writer, 0x5A));
+    
+    const uint8_t* data;
+    size_t len;
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    
+    DCFSerReader reader;
+    TEST_CHECK(dcf_ser_reader_init(&reader, data, len));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    for (int i = 0; i < 3; i++) {
+        TestRecord out;
+        memset(&out, 0xFF, sizeof(out));
+        TEST_CHECK(dcf_ser_read_struct_projected(&reader, &out, &test_record_schema, mask));
+        TEST_ASSERT(out.id == 777 && out.timestamp == record.timestamp, "projected fields wrong");
+        TEST_ASSERT(!out.active && out.score == 0.0f, "unrequested fields decoded");
+    }
+    uint8_t sentinel;
+    TEST_CHECK(dcf_ser_read_u8(&reader, &sentinel));
+    TEST_ASSERT(sentinel == 0x5A, "projection misplaced reader");
+    
+    /* Empty mask still consumes the value; wrong schema is refused */
+    TEST_CHECK(dcf_ser_reader_init(&reader, data, len));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    TestRecord out;
+    TEST_CHECK(dcf_ser_read_struct_projected(&reader, &out, &test_record_schema, 0));
+    TEST_CHECK(dcf_ser_read_struct_projected(&reader, &out, &test_record_schema, 0));
+    TestProfile profile;
+    TEST_ASSERT(dcf_ser_read_struct_projected(&reader, &profile, &test_profile_schema, 1) ==
+                DCF_SER_ERR_TYPE_MISMATCH, "foreign table accepted");
+    
+    dcf_ser_writer_destroy(&writer);
+    printf("  PASSED\n");
+    return 0;
+}
+
+static int test_arena(void) {
+    printf("Testing arena decoding...\n");
+    
+    DCFSerArena arena;
+    TEST_CHECK(dcf_ser_arena_init(&arena, 256));
+    void* first = dcf_ser_arena_alloc(&arena, 3);
+    void* second = dcf_ser_arena_alloc(&arena, 8);
+    TEST_ASSERT(first && second && (uintptr_t)second % _Alignof(max_align_t) == 0,
+                "arena allocation misaligned");
+    void* big = dcf_ser_arena_alloc(&arena, 1000);
+    TEST_ASSERT(big != NULL, "oversized allocation failed");
+    memset(big, 0xAB, 1000);
+    
+    /* Reset keeps the chunks: the same memory comes back */
+    dcf_ser_arena_reset(&arena);
+    TEST_ASSERT(arena.used == 0 && arena.head == NULL, "reset left allocations");
+    void* again = dcf_ser_arena_alloc(&arena, 900);
+    TEST_ASSERT(again == big, "oversized chunk not reused");
+    dcf_ser_arena_reset(&arena);
+    
+    /* Sizes that would wrap when rounded up or when adding the chunk header */
+    TEST_ASSERT(dcf_ser_arena_alloc(&arena, SIZE_MAX - 3) == NULL, "rounding overflow allocated");
+    TEST_ASSERT(dcf_ser_arena_alloc(&arena, SIZE_MAX - 20) == NULL, "chunk size overflow allocated");
+    TEST_ASSERT(arena.used == 0, "failed allocation counted");
+    
+    TestProfile profile = { 9, 12, "grace", 3, 0, 0.5 };
+    DCFSerWriter writer;
+    TEST_CHECK(dcf_ser_writer_init(&writer, 0x0F05, DCF_SER_FLAG_NONE));
+    TEST_CHECK(dcf_ser_write_struct_schema(&writer, &profile, &test_profile_schema));
+    TEST_CHECK(dcf_ser_write_string(&writer, "tail"));
+    TEST_CHECK(dcf_ser_write_bytes(&writer, "\x01\x02\x03", 3));
+    const uint8_t* data;
+    size_t len;
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    
+    DCFSerReader reader;
+    TEST_CHECK(dcf_ser_reader_init(&reader, data, len));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    TestProfile decoded;
+    TEST_CHECK(dcf_ser_read_struct_arena(&reader, &decoded, &test_profile_schema, &arena));
+    TEST_ASSERT(decoded.id == 9 && decoded.name && strcmp(decoded.name, "grace") == 0,
+                "arena struct decode mismatch");
+    TEST_ASSERT((const uint8_t*)decoded.name < data || (const uint8_t*)decoded.name >= data + len,
+                "string not copied");
+    
+    const char* str;
+    size_t str_len;
+    TEST_CHECK(dcf_ser_read_string_arena(&reader, &arena, &str, &str_len));
+    TEST_ASSERT(str_len == 4 && strcmp(str, "tail") == 0, "arena string mismatch");
+    const void* bytes;
+    size_t bytes_len;
+    TEST_CHECK(dcf_ser_read_bytes_arena(&reader, &arena, &bytes, &bytes_len));
+    TEST_ASSERT(bytes_len == 3 && memcmp(bytes, "\x01\x02\x03", 3) == 0, "arena bytes mismatch");
+    TEST_ASSERT(arena.used > 0, "arena unused");
+    
+    /* Elided string defaults come back as the default, not NULL */
+    TestStatus status = { 201, 1, true, "none", 0 };
+    dcf_ser_writer_reset(&writer, 0x0F05, DCF_SER_FLAG_NONE);
+    TEST_CHECK(dcf_ser_write_struct_schema(&writer, &status, &test_status_schema));
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    TEST_CHECK(dcf_ser_reader_init(&reader, data, len));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    TestStatus status_out;
+    TEST_CHECK(dcf_ser_read_struct_arena(&reader, &status_out, &test_status_schema, &arena));
+    TEST_ASSERT(status_out.code == 201 && status_out.note && strcmp(status_out.note, "none") == 0,
+                "elided string default lost");
+    
+    dcf_ser_writer_destroy(&writer);
+    dcf_ser_arena_destroy(&arena);
+    printf("  PASSED\n");
+    return 0;
+}
+
+static int test_dom(void) {
+    printf("Testing lazy DOM...\n");
+    
+    /* struct { 1: u32, 2: string, 3: array<struct { 1: i16, 2: f64 }>,
+     *          4: array<u32>, 5: map<string, varint>, 6: table { 2: string } } */
+    DCFSerWriter writer;
+    TEST_CHECK(dcf_ser_writer_init(&writer, 0x0F06, DCF_SER_FLAG_NONE));
+    TEST_CHECK(dcf_ser_write_struct_begin(&writer, 0x0330));
+    TEST_CHECK(dcf_ser_write_field(&writer, 1, DCF_TYPE_U32));
+    TEST_CHECK(dcf_ser_write_u32(&writer, 77));
+    TEST_CHECK(dcf_ser_write_field(&writer, 2, DCF_TYPE_STRING));
+    TEST_CHECK(dcf_ser_write_string(&writer, "root"));
+    TEST_CHECK(dcf_ser_write_field(&writer, 3, DCF_TYPE_ARRAY));
+    TEST_CHECK(dcf_ser_write_array_begin(&writer, DCF_TYPE_STRUCT, 10));
+    for (int i = 0; i < 10; i++) {
+        TEST_CHECK(dcf_ser_write_struct_begin(&writer, 0x0331));
+        TEST_CHECK(dcf_ser_write_field(&writer, 1, DCF_TYPE_I16));
+        TEST_CHECK(dcf_ser_write_i16(&writer, (int16_t)(-i)));
+        TEST_CHECK(dcf_ser_write_field(&writer, 2, DCF_TYPE_F64));
+        TEST_CHECK(dcf_ser_write_f64(&writer, i * 0.5));
+        TEST_CHECK(dcf_ser_write_struct_end(&writer));
+    }
+    TEST_CHECK(dcf_ser_write_array_end(&writer));
+    TEST_CHECK(dcf_ser_write_field(&writer, 4, DCF_TYPE_ARRAY));
+    TEST_CHECK(dcf_ser_write_array_begin(&writer, DCF_TYPE_U32, 100));
+    for (uint32_t i = 0; i < 100; i++) TEST_CHECK(dcf_ser_write_u32(&writer, i * 3));
+    TEST_CHECK(dcf_ser_write_array_end(&writer));
+    TEST_CHECK(dcf_ser_write_field(&writer, 5, DCF_TYPE_MAP));
+    TEST_CHECK(dcf_ser_write_map_begin(&writer, DCF_TYPE_STRING, DCF_TYPE_VARINT, 2));
+    TEST_CHECK(dcf_ser_write_string(&writer, "a"));
+    TEST_CHECK(dcf_ser_write_varint(&writer, 1));
+    TEST_CHECK(dcf_ser_write_string(&writer, "b"));
+    TEST_CHECK(dcf_ser_write_varint(&writer, 300));
+    TEST_CHECK(dcf_ser_write_map_end(&writer));
+    TEST_CHECK(dcf_ser_write_field(&writer, 6, DCF_TYPE_TABLE));
+    TEST_CHECK(dcf_ser_write_table_begin(&writer, 0x0332, 3));
+    TEST_CHECK(dcf_ser_write_table_field(&writer, 2));
+    TEST_CHECK(dcf_ser_write_string(&writer, "slot"));
+    TEST_CHECK(dcf_ser_write_table_end(&writer));
+    TEST_CHECK(dcf_ser_write_struct_end(&writer));
+    const uint8_t* data;
+    size_t len;
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    
+    DCFSerReader reader;
+    TEST_CHECK(dcf_ser_reader_init(&reader, data, len));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    DCFSerArena arena;
+    TEST_CHECK(dcf_ser_arena_init(&arena, 0));
+    DCFSerValue* root;
+    TEST_CHECK(dcf_ser_dom_root(&reader, &arena, &root));
+    TEST_ASSERT(root->type == DCF_TYPE_STRUCT && !root->materialized, "root materialized eagerly");
+    
+    /* Scalars read in place */
+    uint64_t u;
+    int64_t i;
+    double f;
+    const char* str;
+    size_t str_len;
+    TEST_CHECK(dcf_ser_value_uint(dcf_ser_value_field(root, 1), &u));
+    TEST_ASSERT(u == 77, "DOM u32 mismatch");
+    TEST_CHECK(dcf_ser_value_string(dcf_ser_value_field(root, 2), &str, &str_len));
+    TEST_ASSERT(str_len == 4 && memcmp(str, "root", 4) == 0 && (const uint8_t*)str > data &&
+                (const uint8_t*)str < data + len, "DOM string not zero-copy");
+    TEST_ASSERT(dcf_ser_value_count(root) == 6, "DOM field count mismatch");
+    
+    /* Only the containers on the path are materialized */
+    DCFSerValue* items = dcf_ser_value_field(root, 3);
+    TEST_ASSERT(items && !items->materialized, "array materialized before access");
+    DCFSerValue* item = dcf_ser_value_path(root, ".3[7]");
+    TEST_ASSERT(item && items->materialized && items->count == 10, "path lookup failed");
+    TEST_ASSERT(!items->children[6].materialized, "sibling materialized");
+    TEST_CHECK(dcf_ser_value_int(dcf_ser_value_field(item, 1), &i));
+    TEST_CHECK(dcf_ser_value_f64(dcf_ser_value_path(root, ".3[7].2"), &f));
+    TEST_ASSERT(i == -7 && f == 3.5, "DOM nested values mismatch");
+    
+    /* Fixed-width arrays index directly */
+    DCFSerValue* nums = dcf_ser_value_field(root, 4);
+    TEST_ASSERT(dcf_ser_value_count(nums) == 100, "DOM array count mismatch");
+    TEST_CHECK(dcf_ser_value_uint(dcf_ser_value_index(nums, 99), &u));
+    TEST_ASSERT(u == 297 && !nums->materialized, "fixed-width index materialized array");
+    TEST_ASSERT(dcf_ser_value_index(nums, 100) == NULL, "out of range index found");
+    
+    /* Maps expose keys and values */
+    DCFSerValue* map = dcf_ser_value_field(root, 5);
+    TEST_CHECK(dcf_ser_value_string(dcf_ser_value_key(map, 1), &str, &str_len));
+    TEST_CHECK(dcf_ser_value_uint(dcf_ser_value_index(map, 1), &u));
+    TEST_ASSERT(str_len == 1 && str[0] == 'b' && u == 300, "DOM map entry mismatch");
+    
+    /* Tables: direct slot lookup; absent slots miss */
+    TEST_CHECK(dcf_ser_value_string(dcf_ser_value_path(root, ".6.2"), &str, &str_len));
+    TEST_ASSERT(str_len == 4 && memcmp(str, "slot", 4) == 0, "DOM table slot mismatch");
+    TEST_ASSERT(dcf_ser_value_path(root, ".6.1") == NULL, "absent table slot found");
+    
+    /* Misses chain to NULL */
+    TEST_ASSERT(dcf_ser_value_path(root, ".9[0].1") == NULL, "missing field found");
+    TEST_ASSERT(dcf_ser_value_path(root, ".3[x]") == NULL, "bad path accepted");
+    TEST_ASSERT(dcf_ser_value_field(dcf_ser_value_field(root, 1), 1) == NULL, "scalar has fields");
+    TEST_ASSERT(dcf_ser_value_uint(dcf_ser_value_field(root, 2), &u) == DCF_SER_ERR_TYPE_MISMATCH,
+                "string read as integer");
+    
+    /* Reader untouched; node readers hand off to the regular API */
+    TEST_ASSERT(reader.position == root->offset, "DOM advanced the reader");
+    DCFSerReader sub;
+    TEST_CHECK(dcf_ser_value_reader(dcf_ser_value_path(root, ".4[2]"), &sub));
+    uint32_t u32;
+    TEST_CHECK(dcf_ser_read_u32(&sub, &u32));
+    TEST_ASSERT(u32 == 6, "node reader mismatch");
+    
+    dcf_ser_writer_destroy(&writer);
+    dcf_ser_arena_destroy(&arena);
+    printf("  PASSED\n");
+    return 0;
+}
+
+/* Visitor that prints a compact transcript of what it sees */
+typedef struct TestVisitLog {
+    char   text[256];
+    size_t len;
+    uint16_t skip_field;        /* Field to skip (0 = none) */
+    uint32_t stop_at;           /* Stop at this u32 value (0 = never) */
+} TestVisitLog;
+
+static void test_visit_put(TestVisitLog* log, const char* fmt, long long val) {
+    int n = snprintf(log->text + log->len, sizeof(log->text) - log->len, fmt, val);
+    if (n > 0) log->len += (size_t)n;
+}
+
+static DCFSerVisit test_visit_u32(void* ctx, uint32_t val) {
+    TestVisitLog* log = ctx;
+    test_visit_put(log, "u%lld ", val);
+    return val == log->stop_at ? DCF_SER_VISIT_STOP : DCF_SER_VISIT_CONTINUE;
+}
+
+static DCFSerVisit test_visit_i16(void* ctx, int16_t val) {
+    test_visit_put(ctx, "i%lld ", val);
+    return DCF_SER_VISIT_CONTINUE;
+}
+
+static DCFSerVisit test_visit_string(void* ctx, const char* str, size_t len) {
+    TestVisitLog* log = ctx;
+    int n = snprintf(log->text + log->len, sizeof(log->text) - log->len, "'%.*s' ", (int)len, str);
+    if (n > 0) log->len += (size_t)n;
+    return DCF_SER_VISIT_CONTINUE;
+}
+
+static DCFSerVisit test_visit_array_begin(void* ctx, DCFSerType elem_type, uint32_t count) {
+    (void)elem_type;
+    test_visit_put(ctx, "[%lld ", count);
+    return DCF_SER_VISIT_CONTINUE;
+}
+
+static DCFSerVisit test_visit_array_end(void* ctx) {
+    test_visit_put(ctx, "] ", 0);
+    return DCF_SER_VISIT_CONTINUE;
+}
+
+static DCFSerVisit test_visit_map_begin(void* ctx, DCFSerType key_type, DCFSerType val_type,
+                                        uint32_t count) {
+    (void)ctx; (void)key_type; (void)val_type; (void)count;
+    return DCF_SER_VISIT_SKIP;
+}
+
+static DCFSerVisit test_visit_struct_begin(void* ctx, uint16_t type_id) {
+    test_visit_put(ctx, "{%llx ", type_id);
+    return DCF_SER_VISIT_CONTINUE;
+}
+
+static DCFSerVisit test_visit_field(void* ctx, uint16_t field_id, DCFSerType type) {
+    TestVisitLog* log = ctx;
+    (void)type;
+    if (field_id == log->skip_field) return DCF_SER_VISIT_SKIP;
+    test_visit_put(log, "%lld:", field_id);
+    return DCF_SER_VISIT_CONTINUE;
+}
+
+static DCFSerVisit test_visit_struct_end(void* ctx) {
+    test_visit_put(ctx, "} ", 0);
+    return DCF_SER_VISIT_CONTINUE;
+}
+
+static int test_visit(void) {
+    printf("Testing visitor decoding...\n");
+    
+    DCFSerWriter writer;
+    TEST_CHECK(dcf_ser_writer_init(&writer, 0x0F07, DCF_SER_FLAG_NO_CRC));
+    TEST_CHECK(dcf_ser_write_u32(&writer, 5));
+    TEST_CHECK(dcf_ser_write_struct_begin(&writer, 0x0340));
+    TEST_CHECK(dcf_ser_write_field(&writer, 1, DCF_TYPE_STRING));
+    TEST_CHECK(dcf_ser_write_string(&writer, "hi"));
+    TEST_CHECK(dcf_ser_write_field(&writer, 2, DCF_TYPE_ARRAY));
+    TEST_CHECK(dcf_ser_write_array_begin(&writer, DCF_TYPE_I16, 2));
+    TEST_CHECK(dcf_ser_write_i16(&writer, -1));
+    TEST_CHECK(dcf_ser_write_i16(&writer, 2));
+    TEST_CHECK(dcf_ser_write_array_end(&writer));
+    TEST_CHECK(dcf_ser_write_field(&writer, 3, DCF_TYPE_MAP));
+    TEST_CHECK(dcf_ser_write_map_begin(&writer, DCF_TYPE_U32, DCF_TYPE_U32, 1));
+    TEST_CHECK(dcf_ser_write_u32(&writer, 100));
+    TEST_CHECK(dcf_ser_write_u32(&writer, 200));
+    TEST_CHECK(dcf_ser_write_map_end(&writer));
+    TEST_CHECK(dcf_ser_write_struct_end(&writer));
+    TEST_CHECK(dcf_ser_write_table_begin(&writer, 0x0341, 4));
+    TEST_CHECK(dcf_ser_write_table_field(&writer, 4));
+    TEST_CHECK(dcf_ser_write_u32(&writer, 44));
+    TEST_CHECK(dcf_ser_write_table_field(&writer, 2));
+    TEST_CHECK(dcf_ser_write_u32(&writer, 22));
+    TEST_CHECK(dcf_ser_write_table_end(&writer));
+    TEST_CHECK(dcf_ser_write_u32(&writer, 9));
+    const uint8_t* data;
+    size_t len;
+    TEST_CHECK(dcf_ser_writer_finish(&writer, &data, &len));
+    
+    DCFSerVisitor visitor = {
+        .on_i16 = test_visit_i16,
+        .on_u32 = test_visit_u32,
+        .on_string = test_visit_string,
+        .on_array_begin = test_visit_array_begin,
+        .on_array_end = test_visit_array_end,
+        .on_map_begin = test_visit_map_begin,
+        .on_struct_begin = test_visit_struct_begin,
+        .on_field = test_visit_field,
+        .on_struct_end = test_visit_struct_end,
+    };
+    
+    /* Full walk: the map is skipped from its begin callback, table fields in ID order */
+    DCFSerReader reader;
+    TEST_CHECK(dcf_ser_reader_init(&reader, data, len));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    TestVisitLog log = {0};
+    TEST_CHECK(dcf_ser_visit(&reader, &visitor, &log));
+    TEST_ASSERT(strcmp(log.text, "u5 {340 1:'hi' 2:[2 i-1 i2 ] 3:} {341 2:u22 4:u44 } u9 ") == 0,
+                "visitor transcript mismatch");
+    TEST_ASSERT(reader.position == reader.payload_end, "visitor did not consume payload");
+    
+    /* Skip from on_field, stop partway */
+    TEST_CHECK(dcf_ser_reader_init(&reader, data, len));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    TestVisitLog partial = { .skip_field = 2, .stop_at = 44 };
+    TEST_CHECK(dcf_ser_visit(&reader, &visitor, &partial));
+    TEST_ASSERT(strcmp(partial.text, "u5 {340 1:'hi' 3:} {341 4:u44 ") == 0,
+                "visitor skip/stop mismatch");
+    
+    /* Empty visitor still checks every value */
+    DCFSerVisitor none = {0};
+    TEST_CHECK(dcf_ser_reader_init(&reader, data, len));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    TEST_CHECK(dcf_ser_visit(&reader, &none, NULL));
+    
+    uint8_t bad[256];
+    TEST_ASSERT(len <= sizeof(bad), "test message too large");
+    memcpy(bad, data, len);
+    bad[sizeof(DCFSerHeader) + 5] = 0x7F;      /* Struct tag -> invalid tag */
+    TEST_CHECK(dcf_ser_reader_init(&reader, bad, len));
+    TEST_CHECK(dcf_ser_reader_validate(&reader));
+    TEST_ASSERT(dcf_ser_visit(&reader, &none, NULL) == DCF_SER_ERR_INVALID_TYPE,
+                "invalid tag not rejected");
+    
+    dcf_ser_writer_destroy(&writer);
+    printf("  PASSED\n");
+    return 0;
+}
+
 /* ============================================================================
  * Example: Game State Message
  * ============================================================================ */
@@ -653,6 +3277,31 @@ int main(void) {
     failures += test_errors();
     failures += test_external_buffer();
     failures += test_no_crc();
+    failures += test_bytes_ref();
+    failures += test_headroom();
+    failures += test_batch();
+    failures += test_compact_header();
+    failures += test_extended();
+    failures += test_streaming();
+    failures += test_reassembly();
+    failures += test_framer();
+    failures += test_incremental();
+    failures += test_iov_reader();
+    failures += test_trusted();
+    failures += test_validate_structure();
+    failures += test_array_index();
+    failures += test_sorted_map();
+    failures += test_table();
+    failures += test_flyweight();
+    failures += test_compact_struct();
+    failures += test_tagless();
+    failures += test_registry();
+    failures += test_schema_plan();
+    failures += test_default_elision();
+    failures += test_projected();
+    failures += test_arena();
+    failures += test_dom();
+    failures += test_visit();
     
     example_game_protocol();
     
@@ -43,14 +43,14 @@
             runHook preBuild
             
             # Build static library
-            gcc -c -O2 -Wall -Wextra -Wpedantic -fPIC dcf_serialize.c -o dcf_serialize.o
+            gcc -c -O2 -Wall -Wextra -Wpedantic -fPIC -pthread dcf_serialize.c -o dcf_serialize.o
             ar rcs libdcf_serialize.a dcf_serialize.o
             
             # Build shared library
-            gcc -shared -fPIC -O2 -Wall -Wextra dcf_serialize.c -o libdcf_serialize.so.${version}
+            gcc -shared -fPIC -O2 -Wall -Wextra -pthread dcf_serialize.c -o libdcf_serialize.so.${version}
             
             # Build test binary
-            gcc -O2 -Wall -Wextra -Wpedantic dcf_serialize_test.c dcf_serialize.c -o dcf_serialize_test
+            gcc -O2 -Wall -Wextra -Wpedantic -pthread dcf_serialize_test.c dcf_serialize.c -o dcf_serialize_test
             
             runHook postBuild
           '';
@@ -87,7 +87,7 @@
             Name: dcf-serialize
             Description: DeMoD Communications Framework Serialization Shim
             Version: ${version}
-            Libs: -L\''${libdir} -ldcf_serialize
+            Libs: -L\''${libdir} -ldcf_serialize -pthread
             Cflags: -I\''${includedir}
             EOF
             